@@ -10,6 +10,7 @@
 #include "core/Context.h"
 #include "core/EvkMap.h"
 #include "core/EvkRequest.h"
+#include "core/SeededSampler.h"
 
 namespace cheddar {
 
@@ -36,16 +37,21 @@ class UserInterface {
    * sparse-to-dense) will be prepared automatically.
    *
    * @param context CKKS context (can be a BootContext or a Context)
+   * @param seeded_evks whether the ax polynomials of the evaluation keys are
+   * expanded from seeds (see GetEvkSeed), to send the keys compressed
    */
-  explicit UserInterface(ContextPtr<word> context);
+  explicit UserInterface(ContextPtr<word> context, bool seeded_evks = false);
 
   /**
-   * @brief Encrypt a plaintext into a ciphertext.
+   * @brief Encrypt a plaintext into a ciphertext. If ax_seed is given, the
+   * random ax polynomial is expanded from a fresh seed, so that the
+   * ciphertext can be sent compressed (see Serializer::SerializeCompressed).
    *
    * @param ctxt output ciphertext
    * @param ptxt input plaintext
+   * @param ax_seed if not nullptr, receives the seed ax was expanded from
    */
-  void Encrypt(Ct &ctxt, const Pt &ptxt) const;
+  void Encrypt(Ct &ctxt, const Pt &ptxt, PolySeed *ax_seed = nullptr) const;
 
   /**
    * @brief Decrypt a ciphertext into a plaintext.
@@ -55,7 +61,8 @@ class UserInterface {
    */
   void Decrypt(Pt &ptxt, const Ct &ctxt) const;
 
-  // Get const reference to an evaluation key
+  // Get const reference to an evaluation key (owned by evk_map_, which has no
+  // EvkStore attached)
   const Evk &GetRotationKey(int rot_idx) const;
   const Evk &GetMultiplicationKey() const;
   const Evk &GetConjugationKey() const;
@@ -69,6 +76,16 @@ class UserInterface {
    */
   const EvkMap<word> &GetEvkMap() const;
 
+  /**
+   * @brief Getter for the seed the ax polynomials of an evaluation key were
+   * expanded from (stream i for ax_[i]), to send the key compressed. Only
+   * available with seeded_evks.
+   *
+   * @param key_idx key index (see EvkMap)
+   * @return const PolySeed& the seed
+   */
+  const PolySeed &GetEvkSeed(int key_idx) const;
+
   /**
    * @brief Prepare a rotation key for the given rotation distance.
    *
@@ -94,6 +111,8 @@ class UserInterface {
   Dv sparse_secret_;
 
   EvkMap<word> evk_map_;
+  const bool seeded_evks_;
+  std::unordered_map<int, PolySeed> evk_seeds_;
 
   std::vector<word> all_primes_;
 
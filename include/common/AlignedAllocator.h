@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <limits>
+#include <new>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+// Host buffers are aligned to a cache line, which is also the width of an
+// AVX-512 register, so that vectorized loops never split a load.
+constexpr size_t kHostAlignment = 64;
+
+/**
+ * @brief Allocates size bytes of kHostAlignment-aligned host memory.
+ *
+ * @param size the number of bytes
+ * @return void* the allocated memory, or nullptr if size is 0
+ */
+inline void *AlignedAlloc(size_t size) {
+  if (size == 0) return nullptr;
+  constexpr size_t kMaxSize =
+      static_cast<size_t>(std::numeric_limits<std::ptrdiff_t>::max()) -
+      kHostAlignment;
+  if (size > kMaxSize) throw std::bad_alloc();
+  // std::aligned_alloc requires the size to be a multiple of the alignment
+  size_t padded_size = (size + kHostAlignment - 1) / kHostAlignment;
+  padded_size *= kHostAlignment;
+  void *ptr = std::aligned_alloc(kHostAlignment, padded_size);
+  AssertTrue(ptr != nullptr, "AlignedAlloc: Out of host memory while "
+                             "allocating " + std::to_string(size) + " bytes");
+  return ptr;
+}
+
+inline void AlignedFree(void *ptr) { std::free(ptr); }
+
+/**
+ * @brief A std::allocator replacement returning kHostAlignment-aligned memory.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+class AlignedAllocator {
+ public:
+  using value_type = T;
+
+  AlignedAllocator() noexcept = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    if (n > static_cast<size_t>(std::numeric_limits<std::ptrdiff_t>::max()) /
+                sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T *>(AlignedAlloc(n * sizeof(T)));
+  }
+
+  void deallocate(T *ptr, size_t /*n*/) noexcept { AlignedFree(ptr); }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace cheddar
@@ -5,10 +5,20 @@
 
 #include "core/Parameter.h"
 
+#ifdef USE_CPU_BACKEND
+#include "common/HostRuntime.h"
+
+// Host copies of the parameters read by the host kernels
+inline int __cm_log_degree;
+inline int __cm_degree;
+inline int __cm_alpha;
+inline int __cm_L;
+#else
 __constant__ int __cm_log_degree;
 __constant__ int __cm_degree;
 __constant__ int __cm_alpha;
 __constant__ int __cm_L;
+#endif
 
 namespace cheddar {
 
@@ -0,0 +1,79 @@
+#pragma once
+
+// Host stand-ins for the (small) subset of the CUDA runtime API used by the
+// host-side code of Cheddar. With the CPU backend (USE_CPU_BACKEND), "device"
+// memory is ordinary host memory and every operation completes synchronously,
+// so the same sources build and run without the CUDA toolkit.
+#ifdef USE_CPU_BACKEND
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/AlignedAllocator.h"
+
+struct CUstream_st;
+using cudaStream_t = CUstream_st *;
+
+// Same value as the CUDA runtime; only compared against, never dereferenced.
+#define cudaStreamLegacy (reinterpret_cast<cudaStream_t>(0x1))
+
+enum cudaError_t { cudaSuccess = 0, cudaErrorMemoryAllocation = 2 };
+
+enum cudaMemcpyKind {
+  cudaMemcpyHostToHost = 0,
+  cudaMemcpyHostToDevice = 1,
+  cudaMemcpyDeviceToHost = 2,
+  cudaMemcpyDeviceToDevice = 3,
+  cudaMemcpyDefault = 4
+};
+
+inline cudaError_t cudaMalloc(void **ptr, size_t size) {
+  *ptr = cheddar::AlignedAlloc(size);
+  return (*ptr != nullptr || size == 0) ? cudaSuccess
+                                        : cudaErrorMemoryAllocation;
+}
+
+template <typename T>
+inline cudaError_t cudaMalloc(T **ptr, size_t size) {
+  return cudaMalloc(reinterpret_cast<void **>(ptr), size);
+}
+
+inline cudaError_t cudaFree(void *ptr) {
+  cheddar::AlignedFree(ptr);
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaMemcpy(void *dst, const void *src, size_t count,
+                              cudaMemcpyKind /*kind*/) {
+  if (count > 0 && dst != src) std::memcpy(dst, src, count);
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaMemcpyAsync(void *dst, const void *src, size_t count,
+                                   cudaMemcpyKind kind,
+                                   cudaStream_t /*stream*/ = nullptr) {
+  return cudaMemcpy(dst, src, count, kind);
+}
+
+inline cudaError_t cudaMemsetAsync(void *dst, int value, size_t count,
+                                   cudaStream_t /*stream*/ = nullptr) {
+  if (count > 0) std::memset(dst, value, count);
+  return cudaSuccess;
+}
+
+template <typename T>
+inline cudaError_t cudaMemcpyToSymbol(
+    T &symbol, const void *src, size_t count, size_t offset = 0,
+    cudaMemcpyKind /*kind*/ = cudaMemcpyHostToDevice) {
+  std::memcpy(reinterpret_cast<char *>(&symbol) + offset, src, count);
+  return cudaSuccess;
+}
+
+inline cudaError_t cudaDeviceSynchronize() { return cudaSuccess; }
+
+inline cudaError_t cudaStreamSynchronize(cudaStream_t /*stream*/) {
+  return cudaSuccess;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/Assert.h"
+#include "common/CommonUtils.h"
+
+namespace cheddar {
+
+/**
+ * @brief A persistent pool of worker threads used by the host (CPU) backend.
+ * The calling thread also participates in the work, so a pool of n threads
+ * spawns n - 1 workers. Nested ParallelFor calls (from inside a task) and
+ * calls while another job is running are executed serially by the caller,
+ * which keeps the pool deadlock-free without any work stealing.
+ *
+ * An exception thrown by a task is rethrown by ParallelFor on the calling
+ * thread (the remaining indices are skipped). A failing AssertTrue in a task
+ * exits from the worker thread, which is why the global pool is never
+ * destroyed: joining the workers from the exit handlers would deadlock.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Returns the process-wide pool. The number of threads is taken from
+   * the CHEDDAR_NUM_THREADS environment variable if set, otherwise from
+   * std::thread::hardware_concurrency().
+   *
+   * @return ThreadPool& the global thread pool
+   */
+  static ThreadPool &Global() {
+    // Never destroyed (see above)
+    static ThreadPool *pool = new ThreadPool(DefaultNumThreads());
+    return *pool;
+  }
+
+  explicit ThreadPool(int num_threads) : num_threads_(num_threads) {
+    AssertTrue(num_threads > 0, "ThreadPool: Invalid number of threads");
+    for (int i = 1; i < num_threads_; i++) {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  // disable copying (or moving also)
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int NumThreads() const { return num_threads_; }
+
+  /**
+   * @brief Calls func(i) for every i in [begin, end) and blocks until all
+   * calls are done. Indices are handed out in chunks of grain_size. The
+   * first exception thrown by func is rethrown here.
+   *
+   * @param begin the first index
+   * @param end one past the last index
+   * @param func a callable taking an int index
+   * @param grain_size number of consecutive indices handed out at once
+   */
+  template <typename Func>
+  void ParallelFor(int begin, int end, Func &&func, int grain_size = 1) {
+    int count = end - begin;
+    if (count <= 0) return;
+    grain_size = std::max(grain_size, 1);
+
+    std::unique_lock<std::mutex> job_lock(job_mutex_, std::defer_lock);
+    if (num_threads_ == 1 || count <= grain_size || InsideTask() ||
+        !job_lock.try_lock()) {
+      for (int i = begin; i < end; i++) func(i);
+      return;
+    }
+
+    task_ = [&func](int i) { func(i); };
+    next_.store(begin, std::memory_order_relaxed);
+    end_ = end;
+    grain_size_ = grain_size;
+    int num_active = std::min(num_threads_ - 1, DivCeil(count, grain_size));
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = num_active;
+      num_active_ = num_active;
+      generation_++;
+    }
+    start_cv_.notify_all();
+
+    RunTask();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    lock.unlock();
+    if (error) std::rethrow_exception(error);
+  }
+
+ private:
+  static int DefaultNumThreads() {
+    if (const char *env = std::getenv("CHEDDAR_NUM_THREADS")) {
+      int num_threads = std::atoi(env);
+      if (num_threads > 0) return num_threads;
+      Warn("ThreadPool: Ignoring invalid CHEDDAR_NUM_THREADS=" +
+           std::string(env));
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  static bool &InsideTask() {
+    static thread_local bool inside_task = false;
+    return inside_task;
+  }
+
+  void RunTask() {
+    InsideTask() = true;
+    try {
+      while (true) {
+        int start = next_.fetch_add(grain_size_, std::memory_order_relaxed);
+        if (start >= end_) break;
+        int stop = std::min(start + grain_size_, end_);
+        for (int i = start; i < stop; i++) task_(i);
+      }
+    } catch (...) {
+      // Keep the first one, and stop handing out indices.
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) error_ = std::current_exception();
+      next_.store(end_, std::memory_order_relaxed);
+    }
+    InsideTask() = false;
+  }
+
+  void WorkerLoop() {
+    uint64_t seen_generation = 0;
+    int worker_idx = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      worker_idx = num_registered_++;
+    }
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_cv_.wait(lock, [&] {
+          return stop_ ||
+                 (generation_ != seen_generation && worker_idx < num_active_);
+        });
+        if (stop_) return;
+        seen_generation = generation_;
+      }
+      RunTask();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) done_cv_.notify_one();
+      }
+    }
+  }
+
+  const int num_threads_;
+  std::vector<std::thread> workers_;
+
+  // Serializes jobs submitted from different threads
+  std::mutex job_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+  uint64_t generation_ = 0;
+  int num_registered_ = 0;
+  int num_active_ = 0;
+  int pending_ = 0;
+
+  std::function<void(int)> task_;
+  // The first exception thrown by the current job, guarded by mutex_
+  std::exception_ptr error_;
+  std::atomic<int> next_{0};
+  int end_ = 0;
+  int grain_size_ = 1;
+};
+
+}  // namespace cheddar
@@ -14,6 +14,10 @@ namespace cheddar {
 /**
  * @brief A thin wrapper around Tommath's mp_int type. This class is used to
  * represent large integers and perform arithmetic operations on them.
+ *
+ * Every BigInt allocates on the heap. The library itself no longer uses it
+ * (the encoder reduces doubles with DoubleModReducer, and decoding uses
+ * Garner's CRT reconstruction); it is kept for code outside the library.
  */
 class BigInt {
  public:
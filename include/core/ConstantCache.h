@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "core/Container.h"
+#include "core/Encode.h"
+
+namespace cheddar {
+
+/**
+ * @brief A size-bounded, least-recently-used cache of encoded constants and
+ * plaintexts, so that the same (value, level, scale) is encoded only once
+ * while it stays resident. Constants are keyed by their value and plaintexts
+ * by a hash of their message, which is verified against a copy of the message
+ * on every hit. All the functions are thread-safe.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class ConstantCache {
+ public:
+  /**
+   * @brief Counters of a cache. Evictions count the entries dropped to keep
+   * the cache within its capacity.
+   */
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+
+  static constexpr int kDefaultMaxConstants = 1 << 16;
+  static constexpr int64_t kDefaultMaxPlaintextWords = int64_t{1} << 26;
+
+  /**
+   * @brief Construct a new ConstantCache object.
+   *
+   * @param encoder the encoder to use on a miss
+   * @param max_constants maximum number of cached constants
+   * @param max_plaintext_words maximum total size (in words) of the cached
+   * plaintexts
+   */
+  explicit ConstantCache(const Encoder<word> &encoder,
+                         int max_constants = kDefaultMaxConstants,
+                         int64_t max_plaintext_words =
+                             kDefaultMaxPlaintextWords);
+
+  // disable copying (or moving also)
+  ConstantCache(const ConstantCache &) = delete;
+  ConstantCache &operator=(const ConstantCache &) = delete;
+
+  /**
+   * @brief Encode a real number into an RNS constant as
+   * Encoder::EncodeConstant does, copying it from the cache on a hit.
+   *
+   * @param constant output RNS constant
+   * @param level level of the constant
+   * @param scale scale to apply
+   * @param number real number to encode
+   * @param num_aux number of auxiliary primes (default: 0 --> none)
+   */
+  void EncodeConstant(Constant<word> &constant, int level, double scale,
+                      double number, int num_aux = 0) const;
+
+  /**
+   * @brief Encode a message into a plaintext as Encoder::Encode does. The
+   * cached plaintext itself is returned, so that repeated requests share a
+   * single resident copy.
+   *
+   * @param level level of the plaintext
+   * @param scale scale to apply
+   * @param message complex message to encode
+   * @param num_aux number of auxiliary primes
+   * @return std::shared_ptr<const Plaintext<word>> the encoded plaintext
+   */
+  std::shared_ptr<const Plaintext<word>> Encode(
+      int level, double scale, const std::vector<Complex> &message,
+      int num_aux = 0) const;
+
+  Stats GetConstantStats() const;
+  Stats GetPlaintextStats() const;
+
+  /**
+   * @brief Change the capacities, evicting entries if necessary.
+   *
+   * @param max_constants maximum number of cached constants
+   * @param max_plaintext_words maximum total size (in words) of the cached
+   * plaintexts
+   */
+  void SetCapacity(int max_constants, int64_t max_plaintext_words);
+
+  /**
+   * @brief Drop all the cached entries. The counters are kept.
+   */
+  void Clear();
+
+ private:
+  // (number, level, scale, num_aux) with doubles compared bitwise
+  using ConstantKey = std::tuple<uint64_t, int, uint64_t, int>;
+  // (message hash, message size, level, scale, num_aux)
+  using PlaintextKey = std::tuple<uint64_t, int, int, uint64_t, int>;
+
+  struct ConstantEntry {
+    Constant<word> constant;
+    typename std::list<ConstantKey>::iterator lru_it;
+  };
+
+  struct PlaintextEntry {
+    std::vector<Complex> message;
+    std::shared_ptr<const Plaintext<word>> ptxt;
+    int64_t num_words;
+    typename std::list<PlaintextKey>::iterator lru_it;
+  };
+
+  const Encoder<word> &encoder_;
+
+  mutable std::mutex mutex_;
+  int max_constants_;
+  int64_t max_plaintext_words_;
+
+  // The most recently used entries are at the front of the lists.
+  mutable std::map<ConstantKey, ConstantEntry> constants_;
+  mutable std::list<ConstantKey> constant_lru_;
+  mutable Stats constant_stats_;
+
+  mutable std::map<PlaintextKey, PlaintextEntry> plaintexts_;
+  mutable std::list<PlaintextKey> plaintext_lru_;
+  mutable int64_t plaintext_words_ = 0;
+  mutable Stats plaintext_stats_;
+
+  // These should be called with mutex_ held.
+  void EvictConstants() const;
+  void EvictPlaintexts() const;
+};
+
+}  // namespace cheddar
@@ -1,21 +1,64 @@
 #pragma once
 
 #include <memory>
+#include <ostream>
 #include <vector>
 
+#include "core/ConstantCache.h"
 #include "core/Container.h"
 #include "core/ElementWise.h"
 #include "core/Encode.h"
+#include "core/EvkRequest.h"
+#include "core/MemoryFootprint.h"
 #include "core/MemoryPool.h"
 #include "core/ModSwitch.h"
 #include "core/MultiLevelCiphertext.h"
 #include "core/NTT.h"
 #include "core/Parameter.h"
+#include "core/TableCache.h"
 
 namespace cheddar {
 
+template <typename word>
+class ContextFactory;
+
+/**
+ * @brief The precomputed state of a Context, which is not modified after the
+ * construction. Contexts created by a ContextFactory share one instance.
+ *
+ * The memory pool is also kept here, as it is installed as the current
+ * (process-wide) memory resource on construction, and the tables are
+ * allocated from it.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+struct ContextTables {
+  ContextTables(const Parameter<word> &param, TableCache *tables = nullptr,
+                const MemoryBinConfig *bin_config = nullptr);
+  ~ContextTables();
+
+  // disable copying (or moving also)
+  ContextTables(const ContextTables &) = delete;
+  ContextTables &operator=(const ContextTables &) = delete;
+
+  // The order matters here.
+  const Parameter<word> &param_;
+  MemoryPool memory_pool_;
+  ElementWiseHandler<word> elem_handler_;
+  NTTHandler<word> ntt_handler_;
+  std::vector<ModSwitchHandler<word>> mod_switch_handlers_;
+  Encoder<word> encoder_;
+
+  DeviceVector<word> p_prod_;
+  DeviceVector<word> p_prod_dts_;
+  std::vector<Constant<word>> level_down_consts_;
+};
+
 template <typename word>
 class Context {
+  friend class ContextFactory<word>;
+
  protected:
   // short-hand notations
   using Dv = DeviceVector<word>;
@@ -24,7 +67,12 @@ class Context {
   using Evk = EvaluationKey<word>;
   using Const = Constant<word>;
 
-  Context(const Parameter<word> &param);
+  // Should be initialized before the references below
+  std::shared_ptr<const ContextTables<word>> tables_;
+
+  Context(const Parameter<word> &param, TableCache *tables = nullptr,
+          const MemoryBinConfig *bin_config = nullptr);
+  explicit Context(std::shared_ptr<const ContextTables<word>> tables);
 
   void MatchResultWith(Ct &res, const Ct &a) const;
   void MatchResultWith(Ct &res, const Ct &a, const Ct &b) const;
@@ -35,6 +83,10 @@ class Context {
   const ModSwitchHandler<word> &GetDtSModSwitchHandler() const;
   const ModSwitchHandler<word> &GetStDModSwitchHandler() const;
 
+  // The temporaries of a key switching at the maximum level (e.g., HRot),
+  // from ModUp to ModDown
+  static size_t GetKeySwitchBytes(const Parameter<word> &param);
+
  public:
   void AssertSameScale(const double &scale1, const double &scale2) const;
 
@@ -65,9 +117,15 @@ class Context {
    * Context and should be used instead of the constructor.
    *
    * @param param CKKS parameter
+   * @param tables cache of precomputed tables to load the tables from, and to
+   * store the computed ones into (optional, see TableCache)
+   * @param bin_config bins of the memory pool replacing the default ones
+   * (optional, see MemoryBinConfig)
    * @return std::shared_ptr<Context<word>> a shared pointer to the new Context
    */
-  static std::shared_ptr<Context<word>> Create(const Parameter<word> &param);
+  static std::shared_ptr<Context<word>> Create(
+      const Parameter<word> &param, TableCache *tables = nullptr,
+      const MemoryBinConfig *bin_config = nullptr);
 
   // disable copying (or moving also)
   Context(const Context &) = delete;
@@ -79,17 +137,71 @@ class Context {
   // Make it polymorphic
   virtual ~Context();
 
-  // The order matters here.
+  // References to the (possibly shared) ContextTables
   const Parameter<word> &param_;
-  MemoryPool memory_pool_;
-  ElementWiseHandler<word> elem_handler_;
-  NTTHandler<word> ntt_handler_;
-  std::vector<ModSwitchHandler<word>> mod_switch_handlers_;
-  Encoder<word> encoder_;
+  const ElementWiseHandler<word> &elem_handler_;
+  const NTTHandler<word> &ntt_handler_;
+  const std::vector<ModSwitchHandler<word>> &mod_switch_handlers_;
+  const Encoder<word> &encoder_;
+  // Encoded constants and plaintexts shared by the users of the Context
+  ConstantCache<word> constant_cache_;
 
-  DeviceVector<word> p_prod_;
-  DeviceVector<word> p_prod_dts_;
-  std::vector<Const> level_down_consts_;
+  const DeviceVector<word> &p_prod_;
+  const DeviceVector<word> &p_prod_dts_;
+  const std::vector<Const> &level_down_consts_;
+
+  /**
+   * @brief Get the allocation statistics of the memory pool (see
+   * MemoryPoolStats). As the pool is the memory resource of the whole
+   * process, they also count the allocations outside this Context. While a
+   * newer Context (with its own pool) is alive, allocations go to the newer
+   * pool instead, and a warning is printed.
+   *
+   * @return MemoryPoolStats a snapshot of the statistics
+   */
+  MemoryPoolStats GetMemoryStats() const;
+
+  /**
+   * @brief Restart the peak sizes of the memory pool statistics from the
+   * current live sizes, e.g., to measure the peak of a single operation.
+   */
+  void ResetPeakMemoryStats() const;
+
+  /**
+   * @brief Print the memory pool statistics (see MemoryPoolStats::Dump).
+   *
+   * @param os output stream
+   */
+  void DumpMemoryStats(std::ostream &os) const;
+
+  /**
+   * @brief Start recording the requests to the memory pool, e.g., to derive
+   * the bins for a workload (see MemoryBinConfig::FromTrace).
+   */
+  void StartMemoryTrace() const;
+
+  /**
+   * @brief Stop recording the requests to the memory pool.
+   *
+   * @return MemoryTrace the requests since StartMemoryTrace
+   */
+  MemoryTrace StopMemoryTrace() const;
+
+  /**
+   * @brief Estimate the device memory a Context of the given parameter takes
+   * with the given evaluation keys, without creating one. The tables and the
+   * keys are counted as they are allocated. The temporaries are those of a key
+   * switching at the maximum level; the constants and plaintexts encoded by
+   * the user (or cached in constant_cache_) are not counted.
+   *
+   * @param param CKKS parameter
+   * @param evk_request rotation keys and their maximum levels (see
+   * UserInterface::PrepareRotationKey), in addition to the basic keys (see
+   * UserInterface::PrepareBasicEvks)
+   * @return MemoryFootprint the estimate
+   */
+  static MemoryFootprint EstimateMemoryFootprint(
+      const Parameter<word> &param, const EvkRequest &evk_request = {});
 
   /**
    * @brief Copy a ciphertext to another ciphertext. Falls back to nop if the
@@ -408,6 +520,25 @@ class Context {
    */
   void LevelDown(Ct &res, const Ct &a, int target_level) const;
 
+  /**
+   * @brief Shrink a ciphertext that is only to be decrypted, such as a result
+   * returned to the client. The ciphertext is first leveled down to the
+   * lowest level at which the rescaling error still leaves precision_bits
+   * bits of precision. Then, if drop_limbs is set, the limbs that are not
+   * needed to hold the scaled message are dropped without rescaling, down to
+   * the prime set of a lower level (or the short base of LevelToNP(-1)). The
+   * result no longer has the default scale of its level, so it should not be
+   * used for further homomorphic operations.
+   *
+   * @param res result ciphertext
+   * @param a input ciphertext (without rx and auxiliary primes)
+   * @param precision_bits required precision of the message in bits
+   * @param max_abs_message an upper bound of the absolute value of the message
+   * @param drop_limbs whether to drop the limbs beyond the leveled-down level
+   */
+  void Compact(Ct &res, const Ct &a, double precision_bits,
+               double max_abs_message = 1.0, bool drop_limbs = true) const;
+
   /**
    * @brief Add lower-level versions in the MultiLevelCiphertext.
    *
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include "core/Context.h"
+
+namespace cheddar {
+
+/**
+ * @brief A factory of Contexts of the same parameter. The Contexts share the
+ * precomputed tables (see ContextTables), which are computed once on the
+ * construction of the factory, so creating a Context only sets up its own
+ * ConstantCache. The tables are freed when the factory and all the Contexts
+ * created by it are destroyed.
+ *
+ * Note that process-wide states (e.g., the memory resource and the static
+ * members of MultiLevelCiphertext) are bound to the shared tables, so the
+ * Contexts of a factory should not be mixed with Contexts of other
+ * parameters.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class ContextFactory {
+ public:
+  /**
+   * @brief Precompute the tables for the Contexts to be created.
+   *
+   * @param param CKKS parameter
+   * @param tables cache of precomputed tables (optional, see TableCache)
+   * @param bin_config bins of the memory pool (optional, see
+   * MemoryBinConfig)
+   */
+  explicit ContextFactory(const Parameter<word> &param,
+                          TableCache *tables = nullptr,
+                          const MemoryBinConfig *bin_config = nullptr);
+
+  // disable copying (or moving also)
+  ContextFactory(const ContextFactory &) = delete;
+  ContextFactory &operator=(const ContextFactory &) = delete;
+
+  /**
+   * @brief Create a new Context sharing the tables of the factory.
+   *
+   * @return std::shared_ptr<Context<word>> a shared pointer to the new Context
+   */
+  std::shared_ptr<Context<word>> Create() const;
+
+  /**
+   * @brief Get the number of alive Contexts created by this factory.
+   */
+  int GetNumContexts() const;
+
+ private:
+  std::shared_ptr<const ContextTables<word>> tables_;
+};
+
+}  // namespace cheddar
@@ -1,19 +1,42 @@
 #pragma once
 
+#include <iostream>
+
+#ifdef USE_CPU_BACKEND
+#include <vector>
+
+#include "common/HostRuntime.h"
+#include "core/HostUVector.h"
+#else
 #include <thrust/host_vector.h>
 
-#include <iostream>
 #include <rmm/device_uvector.hpp>
+#endif
+
+#include "core/HostStagingPool.h"
 
 namespace cheddar {
 
+#ifdef USE_CPU_BACKEND
+template <typename word>
+using HostVectorBase = std::vector<word, StagingAllocator<word>>;
+template <typename word>
+using DeviceVectorBase = HostUVector<word>;
+#else
+template <typename word>
+using HostVectorBase = thrust::host_vector<word, StagingAllocator<word>>;
+template <typename word>
+using DeviceVectorBase = rmm::device_uvector<word>;
+#endif
+
 /**
- * @brief A thin wrapper around thrust::host_vector.
+ * @brief A thin wrapper around thrust::host_vector (or std::vector for the
+ * CPU backend) allocated from HostStagingPool.
  *
  */
 template <typename word>
-class HostVector : public thrust::host_vector<word> {
-  using Base = thrust::host_vector<word>;
+class HostVector : public HostVectorBase<word> {
+  using Base = HostVectorBase<word>;
 
  public:
   using Base::Base;
@@ -73,14 +96,14 @@ class DvConstView {
 
 /**
  * @brief A wrapper around rmm::device_uvector used for various GPU memory
- * allocations.
+ * allocations. With the CPU backend, it wraps a HostUVector instead.
  *
  * @tparam word uint32_t/uint64_t/int32_t/int64_t
  */
 template <typename word>
-class DeviceVector : public rmm::device_uvector<word> {
+class DeviceVector : public DeviceVectorBase<word> {
  private:
-  using Base = rmm::device_uvector<word>;
+  using Base = DeviceVectorBase<word>;
   using Base::resize;
 
  public:
@@ -124,9 +147,19 @@ class DeviceVector : public rmm::device_uvector<word> {
   DvConstView<word> ConstView(int aux_size = 0, int front_offset = 0) const;
 };
 
+// src may be modified or freed on return. Waits for the stream of dst when
+// src is pinned.
 template <typename word>
 void CopyHostToDevice(DeviceVector<word> &dst, const HostVector<word> &src);
 
+// May return before the copy is done on the stream of dst, so that the copy
+// overlaps the host work that follows. src may be freed on return (its
+// buffer is not reused before the copy is done), but must not be modified.
+template <typename word>
+void CopyHostToDeviceAsync(DeviceVector<word> &dst,
+                           const HostVector<word> &src);
+
+// dst is ready on return.
 template <typename word>
 void CopyDeviceToHost(HostVector<word> &dst, const DeviceVector<word> &src);
 
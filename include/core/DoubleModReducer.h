@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+/**
+ * @brief Reduces the integer part of a finite double modulo single words
+ * without any heap allocation, in place of BigInt in the encoder. Any such
+ * integer of at least 2^64 is a 53-bit mantissa times a power of two, so it
+ * is stored exactly as a sign, a 64-bit mantissa, and a left shift; no limbs
+ * are needed for the whole range of a double (< 2^1024), whatever the
+ * modulus is. This is not a general multiprecision integer (see BigInt).
+ */
+class DoubleModReducer {
+ public:
+  // Truncates toward zero.
+  explicit DoubleModReducer(double value) {
+    AssertTrue(std::isfinite(value), "DoubleModReducer: non-finite value");
+    negative_ = value < 0;
+    double abs_value = std::fabs(value);
+    if (abs_value < 0x1p64) {
+      mantissa_ = static_cast<uint64_t>(abs_value);
+    } else {
+      int exponent;
+      double mantissa = std::frexp(abs_value, &exponent);
+      constexpr int kMantissaBits = std::numeric_limits<double>::digits;
+      // abs_value = m * 2^(exponent - 53) exactly, as abs_value >= 2^64
+      mantissa_ = static_cast<uint64_t>(std::ldexp(mantissa, kMantissaBits));
+      shift_ = exponent - kMantissaBits;
+    }
+    if (mantissa_ == 0) negative_ = false;
+  }
+
+  // value % mod for a single-word mod. The result is always positive.
+  uint64_t Reduce(const uint64_t mod) const {
+    AssertTrue(mod != 0, "DoubleModReducer::Reduce: zero modulus");
+    using u128 = unsigned __int128;
+    uint64_t res = mantissa_ % mod;
+    // res * 2^shift_ by square-and-multiply
+    uint64_t base = 2 % mod;
+    for (int shift = shift_; shift > 0 && res != 0; shift >>= 1) {
+      if (shift & 1) res = static_cast<u128>(res) * base % mod;
+      base = static_cast<u128>(base) * base % mod;
+    }
+    if (negative_ && res != 0) res = mod - res;
+    return res;
+  }
+
+ private:
+  bool negative_ = false;
+  uint64_t mantissa_ = 0;
+  int shift_ = 0;
+};
+
+}  // namespace cheddar
@@ -2,9 +2,14 @@
 
 #include <algorithm>
 #include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #include "core/Container.h"
+#include "core/MultiLevelPlaintext.h"
 #include "core/NTT.h"
 #include "core/Parameter.h"
 
@@ -26,14 +31,45 @@ class Encoder {
   const int M_;
 
   std::vector<Complex> twiddle_factors_;
+  // Special FFT twiddle factors in butterfly order: the stage with stride s
+  // uses [s, 2s), so the first num_slots entries serve any num_slots.
+  // SpecialIFFT uses their conjugates.
+  std::vector<Complex> fft_twiddles_;
+
+  /**
+   * @brief Precomputed constants for Garner's (mixed-radix) CRT
+   * reconstruction over the primes q_0, ..., q_(L-1) of an NPInfo. With
+   * P_i = q_0 * ... * q_(i-1), a value x mod Q is written as
+   * x = u_0 + u_1 * P_1 + ... + u_(L-1) * P_(L-1) with u_i in [0, q_i).
+   * Montgomery-form constants are marked with the _mont suffix.
+   */
+  struct GarnerTable;
+
+  using NPKey = std::tuple<int, int, int>;
+  mutable std::mutex garner_tables_mutex_;
+  mutable std::map<NPKey, std::shared_ptr<const GarnerTable>> garner_tables_;
+
+  std::shared_ptr<const GarnerTable> GetGarnerTable(const NPInfo &np) const;
+
+  // Batches are transferred in chunks of at most this many words, as device
+  // vectors are indexed with int.
+  static constexpr int kMaxBatchWords = 1 << 30;
 
   void EncodeWorker(Plaintext<word> &ptxt, int level, double scale,
                     std::vector<Complex> &message, int num_aux = 0) const;
   void ComplexVectorToPlaintext(Plaintext<word> &ptxt, int level, double scale,
                                 const std::vector<Complex> &data,
                                 int num_aux = 0) const;
+  // Writes the RNS coefficients of data into the zero-initialized host
+  // buffer mx of np.GetNumTotal() * degree words
+  void ComplexVectorToRNS(word *mx, const NPInfo &np, double scale,
+                          const std::vector<Complex> &data) const;
   void PlaintextToComplexVector(std::vector<Complex> &data,
                                 const Plaintext<word> &ptxt) const;
+  // Reconstructs data from the host copy intt_res of an INTT-ed plaintext
+  void RNSToComplexVector(std::vector<Complex> &data, const word *intt_res,
+                          const NPInfo &np, int num_slots, double scale) const;
+  HostVector<word> ICRTConstants(const NPInfo &np) const;
   void SpecialIFFT(std::vector<Complex> &data) const;
   void SpecialFFT(std::vector<Complex> &data) const;
 
@@ -67,6 +103,50 @@ class Encoder {
    */
   void Decode(std::vector<Complex> &message, const Plaintext<word> &ptxt) const;
 
+  /**
+   * @brief Encode messages into plaintexts for a given level and scale, as
+   * Encode does for each of them. The special IFFT and RNS conversion of the
+   * messages run in parallel on the host, and the plaintexts are sent to the
+   * device with a single transfer.
+   *
+   * @param ptxts output plaintexts (NTT-applied), resized to messages.size()
+   * @param level level of the plaintexts
+   * @param scale scale to apply
+   * @param messages complex messages to encode
+   * @param num_aux number of auxiliary primes
+   */
+  void EncodeBatch(std::vector<Plaintext<word>> &ptxts, int level,
+                   double scale,
+                   const std::vector<std::vector<Complex>> &messages,
+                   int num_aux = 0) const;
+
+  /**
+   * @brief Decode plaintexts into complex messages, as Decode does for each of
+   * them. The plaintexts are brought to the host with a single transfer and
+   * decoded in parallel.
+   *
+   * @param messages output complex messages, resized to ptxts.size()
+   * @param ptxts input plaintexts (NTT-applied), possibly of different levels
+   */
+  void DecodeBatch(std::vector<std::vector<Complex>> &messages,
+                   const std::vector<Plaintext<word>> &ptxts) const;
+
+  /**
+   * @brief Encode a message into a multi-level plaintext for the levels in
+   * [min_level, max_level] with a given scale. The special IFFT, the RNS
+   * conversion, and the NTT run only once, over the union of the primes of
+   * all the levels, and each level is then a copy of a subset of the limbs.
+   *
+   * @param ptxt output multi-level plaintext (NTT-applied)
+   * @param min_level the lowest level
+   * @param max_level the highest level
+   * @param scale scale to apply
+   * @param message complex message to encode
+   */
+  void EncodeMultiLevel(MultiLevelPlaintext<word> &ptxt, int min_level,
+                        int max_level, double scale,
+                        const std::vector<Complex> &message) const;
+
   /**
    * @brief Encode a real number (double) into an RNS constant for a given level
    * and scale.
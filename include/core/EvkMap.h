@@ -1,13 +1,19 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 
 #include "core/Container.h"
+#include "core/EvkStore.h"
 
 namespace cheddar {
 
 /**
- * @brief Class for storing client-prepared evaluation keys.
+ * @brief Class for storing client-prepared evaluation keys. Keys that are not
+ * in the map are looked up in the attached EvkStore (if any), which loads them
+ * on their first access. The getters return shared pointers; a key from the
+ * store stays resident while its pointer is held, so hold it for as long as
+ * the key is used (e.g., across a hoisted linear transform).
  *
  * @tparam word uint32_t or uint64_t
  */
@@ -17,7 +23,13 @@ class EvkMap : public std::unordered_map<int, EvaluationKey<word>> {
   using Base = std::unordered_map<int, EvaluationKey<word>>;
   using Evk = EvaluationKey<word>;
 
-  const Evk &GetEvk(int key_idx) const;
+  std::shared_ptr<const EvkStore<word>> store_;
+
+ public:
+  using EvkPtr = typename EvkStore<word>::EvkPtr;
+
+ private:
+  EvkPtr GetEvk(int key_idx) const;
 
  public:
   static inline constexpr int kConjugationKeyIndex = 11111111;
@@ -30,11 +42,19 @@ class EvkMap : public std::unordered_map<int, EvaluationKey<word>> {
   EvkMap &operator=(const EvkMap &) = delete;
   EvkMap(EvkMap &&) = default;
 
-  const Evk &GetRotationKey(int rot_idx) const;
-  const Evk &GetMultiplicationKey() const;
-  const Evk &GetConjugationKey() const;
-  const Evk &GetDenseToSparseKey() const;
-  const Evk &GetSparseToDenseKey() const;
+  /**
+   * @brief Attach an EvkStore to look up the keys missing from the map.
+   * Several maps may share a store.
+   *
+   * @param store the store (nullptr to detach)
+   */
+  void AttachStore(std::shared_ptr<const EvkStore<word>> store);
+
+  EvkPtr GetRotationKey(int rot_idx) const;
+  EvkPtr GetMultiplicationKey() const;
+  EvkPtr GetConjugationKey() const;
+  EvkPtr GetDenseToSparseKey() const;
+  EvkPtr GetSparseToDenseKey() const;
 };
 
 }  // namespace cheddar
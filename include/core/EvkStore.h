@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "core/Container.h"
+#include "core/Parameter.h"
+#include "core/Serialize.h"
+
+namespace cheddar {
+
+/**
+ * @brief An on-disk store of evaluation keys, loaded lazily. A store file is
+ * a StoreHeader, an index of (key index, level, offset, size) entries, and the
+ * serialized keys (see Serializer). The file is memory-mapped, and a key is
+ * copied to the device on its first access. The least recently used keys are
+ * evicted to keep the resident keys within a byte budget.
+ *
+ * Find hands out shared pointers, and a key is pinned (never evicted) while
+ * any of them is alive. Eviction follows the access order and skips the pinned
+ * keys, so the resident keys may exceed the budget while an operation holds
+ * more keys than it (e.g., all the rotation keys of a hoisted linear
+ * transform); the excess is evicted by a later Find once they are released.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class EvkStore {
+ public:
+  using Evk = EvaluationKey<word>;
+  using EvkPtr = std::shared_ptr<const Evk>;
+
+  struct StoreHeader {
+    static constexpr uint32_t kMagic = 0x4b444843;  // "CHDK"
+    static constexpr uint16_t kVersion = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t word_bytes;
+    uint8_t reserved0;
+    int32_t num_entries;
+    int32_t reserved1;
+    uint64_t reserved2[6];
+  };
+  static_assert(sizeof(StoreHeader) == kSerialAlignment,
+                "StoreHeader should fill exactly one alignment unit");
+
+  struct IndexEntry {
+    int32_t key_idx;
+    int32_t level;
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  /**
+   * @brief Counters of the store.
+   */
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+  };
+
+  /**
+   * @brief Write evaluation keys (e.g., an EvkMap) into a store file.
+   *
+   * @param path output file path
+   * @param param CKKS parameter
+   * @param keys the evaluation keys by their key index
+   */
+  static void Write(const std::string &path, const Parameter<word> &param,
+                    const std::unordered_map<int, Evk> &keys);
+
+  /**
+   * @brief Open a store file.
+   *
+   * @param param CKKS parameter
+   * @param path store file path
+   * @param budget_bytes maximum size of the resident keys in bytes
+   */
+  EvkStore(const Parameter<word> &param, const std::string &path,
+           uint64_t budget_bytes);
+
+  // disable copying (or moving also)
+  EvkStore(const EvkStore &) = delete;
+  EvkStore &operator=(const EvkStore &) = delete;
+
+  /**
+   * @brief Returns the key of the given index, loading it if it is not
+   * resident.
+   *
+   * @param key_idx key index (see EvkMap)
+   * @return EvkPtr the key (pinned while the pointer is held), or nullptr if
+   * the store does not have it
+   */
+  EvkPtr Find(int key_idx) const;
+
+  bool Contains(int key_idx) const;
+  int GetLevel(int key_idx) const;
+
+  void SetBudget(uint64_t budget_bytes);
+  uint64_t GetBudget() const;
+  uint64_t GetResidentBytes() const;
+  Stats GetStats() const;
+
+  /**
+   * @brief Evict all the resident keys that are not pinned.
+   */
+  void Clear();
+
+ private:
+  struct Resident {
+    EvkPtr evk;
+    uint64_t bytes;
+    std::list<int>::iterator lru_it;
+  };
+
+  Serializer<word> serializer_;
+  MappedFile file_;
+  std::map<int, IndexEntry> index_;
+
+  mutable std::mutex mutex_;
+  uint64_t budget_bytes_;
+  // The most recently used keys are at the front of the list.
+  mutable std::unordered_map<int, Resident> resident_;
+  mutable std::list<int> lru_;
+  mutable uint64_t resident_bytes_ = 0;
+  mutable Stats stats_;
+
+  // These should be called with mutex_ held. A key is pinned while a pointer
+  // returned by Find is alive (i.e., while it is shared outside the store).
+  static bool IsPinned(const Resident &resident);
+  void Evict() const;
+};
+
+}  // namespace cheddar
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "common/AlignedAllocator.h"
+#include "common/Assert.h"
+
+namespace cheddar {
+
+/**
+ * @brief Host counterpart of rmm::mr::device_memory_resource, used by the CPU
+ * backend (USE_CPU_BACKEND). The method names follow rmm so that the memory
+ * pool code is shared between the backends.
+ */
+class HostMemoryResource {
+ public:
+  virtual ~HostMemoryResource() = default;
+
+  virtual void *allocate(size_t bytes) = 0;
+  virtual void deallocate(void *ptr, size_t bytes) = 0;
+};
+
+/**
+ * @brief Allocates directly from the system with kHostAlignment alignment.
+ */
+class AlignedHostMemoryResource : public HostMemoryResource {
+ public:
+  void *allocate(size_t bytes) override { return AlignedAlloc(bytes); }
+  void deallocate(void *ptr, size_t /*bytes*/) override { AlignedFree(ptr); }
+};
+
+/**
+ * @brief Host counterpart of rmm::mr::binning_memory_resource. An allocation
+ * is served from the smallest bin that fits, and freed blocks are kept in a
+ * per-bin free list for reuse. Allocations larger than every bin go to the
+ * upstream resource.
+ *
+ * @tparam Upstream the upstream HostMemoryResource
+ */
+template <typename Upstream>
+class BinningHostMemoryResource : public HostMemoryResource {
+ public:
+  explicit BinningHostMemoryResource(Upstream *upstream)
+      : upstream_(upstream) {}
+
+  // disable copying (or moving also)
+  BinningHostMemoryResource(const BinningHostMemoryResource &) = delete;
+  BinningHostMemoryResource &operator=(const BinningHostMemoryResource &) =
+      delete;
+
+  ~BinningHostMemoryResource() override {
+    for (auto &[bin_size, free_list] : bins_) {
+      for (void *ptr : free_list) upstream_->deallocate(ptr, bin_size);
+    }
+  }
+
+  void add_bin(size_t bin_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bins_.try_emplace(bin_size);
+  }
+
+  void *allocate(size_t bytes) override {
+    if (bytes == 0) return nullptr;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto bin = bins_.lower_bound(bytes);
+    if (bin == bins_.end()) {
+      lock.unlock();
+      return upstream_->allocate(bytes);
+    }
+    auto &free_list = bin->second;
+    if (!free_list.empty()) {
+      void *ptr = free_list.back();
+      free_list.pop_back();
+      return ptr;
+    }
+    size_t bin_size = bin->first;
+    lock.unlock();
+    return upstream_->allocate(bin_size);
+  }
+
+  void deallocate(void *ptr, size_t bytes) override {
+    if (ptr == nullptr) return;
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto bin = bins_.lower_bound(bytes);
+    if (bin == bins_.end()) {
+      lock.unlock();
+      upstream_->deallocate(ptr, bytes);
+      return;
+    }
+    bin->second.push_back(ptr);
+  }
+
+ private:
+  Upstream *upstream_;
+  std::mutex mutex_;
+  std::map<size_t, std::vector<void *>> bins_;
+};
+
+namespace detail {
+inline AlignedHostMemoryResource &DefaultHostMemoryResource() {
+  static AlignedHostMemoryResource resource;
+  return resource;
+}
+
+inline std::atomic<HostMemoryResource *> &CurrentHostMemoryResource() {
+  static std::atomic<HostMemoryResource *> resource{nullptr};
+  return resource;
+}
+}  // namespace detail
+
+/**
+ * @brief Returns the resource used for new host "device" allocations, the
+ * counterpart of rmm::mr::get_current_device_resource().
+ */
+inline HostMemoryResource *GetCurrentHostMemoryResource() {
+  HostMemoryResource *resource = detail::CurrentHostMemoryResource().load();
+  if (resource == nullptr) return &detail::DefaultHostMemoryResource();
+  return resource;
+}
+
+/**
+ * @brief Sets the resource used for new allocations; nullptr resets it to the
+ * default aligned allocator.
+ */
+inline void SetCurrentHostMemoryResource(HostMemoryResource *resource) {
+  detail::CurrentHostMemoryResource().store(resource);
+}
+
+}  // namespace cheddar
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#ifndef USE_CPU_BACKEND
+#include <cuda_runtime_api.h>
+#endif
+
+namespace cheddar {
+
+/**
+ * @brief A process-wide pool of host buffers for HostVector, which mostly
+ * holds transient staging data of host-device transfers (e.g., in Encode and
+ * Decode). Buffers are grouped into size classes (four per power of two) and
+ * freed buffers are kept for reuse, up to a cache limit.
+ *
+ * With a GPU present, buffers are pinned (cudaMallocHost), so that
+ * host-to-device copies are asynchronous (see CopyHostToDeviceAsync). Each
+ * pinned buffer has an event recorded on the stream of every transfer from
+ * it (RecordTransfer), and a freed buffer is only reused once that event is
+ * complete. Otherwise (or with the CPU backend), buffers of 2 MB or more are
+ * aligned to huge pages, and others to kHostAlignment.
+ */
+class HostStagingPool {
+ public:
+  static constexpr size_t kMinClassSize = 256;
+  static constexpr size_t kHugePageSize = size_t{1} << 21;
+  static constexpr size_t kDefaultCacheLimit = size_t{1} << 30;
+
+  static HostStagingPool &Global();
+
+  // disable copying (or moving also)
+  HostStagingPool(const HostStagingPool &) = delete;
+  HostStagingPool &operator=(const HostStagingPool &) = delete;
+
+  void *Allocate(size_t bytes);
+  void Deallocate(void *ptr, size_t bytes);
+
+  /**
+   * @brief Free all the cached buffers.
+   */
+  void Release();
+
+  /**
+   * @brief Set the maximum total size of the cached (freed) buffers. Extra
+   * cached buffers are freed immediately.
+   *
+   * @param bytes cache limit in bytes
+   */
+  void SetCacheLimit(size_t bytes);
+
+  size_t GetCachedBytes() const;
+
+  static size_t GetClassSize(size_t bytes);
+
+  /**
+   * @brief Whether new buffers are pinned (i.e., a GPU is present).
+   */
+  bool IsPinned() const;
+
+#ifndef USE_CPU_BACKEND
+  /**
+   * @brief Mark an asynchronous transfer from (a buffer of) this pool, just
+   * queued on the given stream. The buffer is not reused until the transfer
+   * is done, even if it is freed before. Does nothing for pageable buffers.
+   *
+   * @param ptr the start of a buffer allocated from this pool
+   * @param stream the stream of the transfer
+   */
+  void RecordTransfer(const void *ptr, cudaStream_t stream);
+#endif
+
+ private:
+  struct Block {
+    size_t size;
+    bool pinned;
+#ifndef USE_CPU_BACKEND
+    // Recorded after the last transfer from the buffer, if pending
+    cudaEvent_t event;
+    bool pending;
+#endif
+  };
+
+  mutable std::mutex mutex_;
+  size_t cache_limit_ = kDefaultCacheLimit;
+  size_t cached_bytes_ = 0;
+  bool pinned_available_ = false;
+  std::unordered_map<void *, Block> blocks_;
+  std::map<size_t, std::vector<void *>> free_lists_;
+
+  HostStagingPool();
+
+  void *AllocateUpstream(Block &block);
+  void FreeUpstream(void *ptr, const Block &block);
+  void *TakeFreeLocked(size_t size);
+  void TrimLocked(size_t limit);
+};
+
+/**
+ * @brief A std::allocator replacement allocating from HostStagingPool.
+ *
+ * @tparam T the element type
+ */
+template <typename T>
+class StagingAllocator {
+ public:
+  using value_type = T;
+
+  StagingAllocator() noexcept = default;
+  template <typename U>
+  StagingAllocator(const StagingAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T *>(HostStagingPool::Global().Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *ptr, size_t n) noexcept {
+    HostStagingPool::Global().Deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const StagingAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const StagingAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace cheddar
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include "common/HostRuntime.h"
+#include "core/HostMemoryResource.h"
+
+namespace cheddar {
+
+/**
+ * @brief Host counterpart of rmm::device_uvector used by the CPU backend: an
+ * uninitialized, movable buffer allocated from the current
+ * HostMemoryResource. The buffer remembers its resource so that it is always
+ * returned to the resource it came from.
+ *
+ * @tparam word element type (trivially copyable)
+ */
+template <typename word>
+class HostUVector {
+ public:
+  using value_type = word;
+  using iterator = word *;
+  using const_iterator = const word *;
+
+  HostUVector(size_t size, cudaStream_t stream)
+      : stream_(stream), resource_(GetCurrentHostMemoryResource()) {
+    Allocate(size);
+    size_ = size;
+  }
+
+  ~HostUVector() { Release(); }
+
+  HostUVector(const HostUVector &) = delete;
+  HostUVector &operator=(const HostUVector &) = delete;
+
+  HostUVector(HostUVector &&other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        stream_(other.stream_),
+        resource_(other.resource_) {}
+
+  HostUVector &operator=(HostUVector &&other) noexcept {
+    if (this != &other) {
+      Release();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      capacity_ = std::exchange(other.capacity_, 0);
+      stream_ = other.stream_;
+      resource_ = other.resource_;
+    }
+    return *this;
+  }
+
+  word *data() noexcept { return data_; }
+  const word *data() const noexcept { return data_; }
+
+  iterator begin() noexcept { return data_; }
+  const_iterator begin() const noexcept { return data_; }
+  iterator end() noexcept { return data_ + size_; }
+  const_iterator end() const noexcept { return data_ + size_; }
+
+  size_t size() const noexcept { return size_; }
+  size_t capacity() const noexcept { return capacity_; }
+  bool is_empty() const noexcept { return size_ == 0; }
+  cudaStream_t stream() const noexcept { return stream_; }
+
+  /**
+   * @brief Resizes the buffer while keeping min(old size, new size) elements,
+   * reallocating only when the capacity is exceeded (as device_uvector does).
+   */
+  void resize(size_t new_size, cudaStream_t stream) {
+    stream_ = stream;
+    if (new_size > capacity_) {
+      word *old_data = data_;
+      size_t old_capacity = capacity_;
+      Allocate(new_size);
+      if (size_ > 0) std::memcpy(data_, old_data, size_ * sizeof(word));
+      resource_->deallocate(old_data, old_capacity * sizeof(word));
+    }
+    size_ = new_size;
+  }
+
+ private:
+  word *data_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  cudaStream_t stream_;
+  HostMemoryResource *resource_;
+
+  void Allocate(size_t capacity) {
+    data_ = static_cast<word *>(resource_->allocate(capacity * sizeof(word)));
+    capacity_ = capacity;
+  }
+
+  void Release() {
+    if (data_ != nullptr) {
+      resource_->deallocate(data_, capacity_ * sizeof(word));
+    }
+    data_ = nullptr;
+    size_ = capacity_ = 0;
+  }
+};
+
+}  // namespace cheddar
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+
+namespace cheddar {
+
+/**
+ * @brief The device memory a workload configuration is expected to take,
+ * computed from the parameters without allocating anything (see
+ * Context::EstimateMemoryFootprint and BootContext::EstimateMemoryFootprint).
+ * Sizes are in bytes, as requested from the memory pool (i.e., before the
+ * rounding up to the bin sizes).
+ */
+struct MemoryFootprint {
+  // The tables of a Context (shared by the Contexts of a ContextFactory)
+  size_t twiddle_bytes = 0;
+  size_t mod_switch_bytes = 0;
+  // P products and level-down constants
+  size_t other_table_bytes = 0;
+
+  // The plaintexts of the special FFTs prepared for bootstrapping
+  size_t boot_plaintext_bytes = 0;
+
+  // By key index, either a rotation index or one of the EvkMap indices
+  std::map<int, size_t> evk_bytes;
+
+  // The temporaries of the most demanding operation, taken at once
+  size_t peak_temporary_bytes = 0;
+
+  size_t GetTableBytes() const;
+  size_t GetEvkBytes() const;
+  size_t GetTotalBytes() const;
+
+  /**
+   * @brief Print the sizes by category, followed by the total.
+   *
+   * @param os output stream
+   */
+  void Dump(std::ostream &os) const;
+};
+
+}  // namespace cheddar
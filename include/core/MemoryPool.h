@@ -1,27 +1,289 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef USE_CPU_BACKEND
+#include "core/HostMemoryResource.h"
+#else
 #include <rmm/mr/device/binning_memory_resource.hpp>
 #include <rmm/mr/device/cuda_async_memory_resource.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/fixed_size_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
+#endif
 
 #include "core/Parameter.h"
 
 namespace cheddar {
+
+/**
+ * @brief Allocation statistics of the allocations served by a bin (or of
+ * those larger than every bin). Sizes are the requested sizes.
+ */
+struct MemoryBinStats {
+  size_t bin_size = 0;
+  uint64_t num_allocations = 0;
+  uint64_t num_live = 0;
+  size_t live_bytes = 0;
+  size_t peak_live_bytes = 0;
+};
+
+/**
+ * @brief A snapshot of the allocation statistics of a MemoryPool.
+ *
+ * "Upstream" refers to the memory the pool obtained from the system (the
+ * CUDA async allocator, or the aligned host allocator with the CPU backend):
+ * the allocations larger than every bin and the memory reserved for the bins.
+ */
+struct MemoryPoolStats {
+  // In the increasing order of the bin sizes
+  std::vector<MemoryBinStats> bins;
+  // Allocations larger than every bin, sent to the upstream as they are
+  MemoryBinStats fall_through;
+
+  size_t live_bytes = 0;
+  size_t peak_live_bytes = 0;
+  // live_bytes, but with each allocation rounded up to its bin size
+  size_t live_binned_bytes = 0;
+
+  uint64_t num_upstream_allocations = 0;
+  size_t upstream_live_bytes = 0;
+  size_t upstream_peak_bytes = 0;
+
+  /**
+   * @brief The fraction of the upstream memory not used by live allocations,
+   * either lost to rounding up to the bin sizes or kept free in the bins.
+   */
+  double GetFragmentation() const;
+
+  /**
+   * @brief Print a per-bin table followed by a summary.
+   *
+   * @param os output stream
+   */
+  void Dump(std::ostream &os) const;
+};
+
+/**
+ * @brief The requests to a MemoryPool in the order they were made: the size
+ * of an allocation, or the negated size of a deallocation. A trace starts
+ * with an allocation for each request that is live at the start, so that the
+ * long-lived allocations (e.g., the tables of a Context and the evaluation
+ * keys) are also covered.
+ */
+struct MemoryTrace {
+  std::vector<int64_t> events;
+};
+
+/**
+ * @brief A set of bins for MemoryPool, replacing the default (heuristic) bins.
+ * Each bin has a number of blocks reserved on the construction of the pool.
+ * Requests larger than every bin go to the upstream resource.
+ *
+ * The intended use is to trace a representative workload once (see
+ * Context::StartMemoryTrace), derive the bins with FromTrace, and Save them
+ * to be loaded for the Contexts of later runs.
+ */
+struct MemoryBinConfig {
+  struct Bin {
+    size_t size;
+    int num_reserved;
+  };
+
+  static constexpr int kDefaultMaxNumBins = 24;
+
+  // In the increasing order of the sizes
+  std::vector<Bin> bins;
+
+  /**
+   * @brief Derive the bins from a trace. Starting from a bin per requested
+   * size with as many reserved blocks as its peak number of live requests,
+   * adjacent bins are merged greedily while merging reduces the reserved
+   * memory (requests of different sizes that are not live at the same time
+   * can share blocks), or while there are more than max_num_bins bins.
+   *
+   * @param trace trace of the workload
+   * @param max_num_bins maximum number of bins
+   * @return MemoryBinConfig the derived bins
+   */
+  static MemoryBinConfig FromTrace(const MemoryTrace &trace,
+                                   int max_num_bins = kDefaultMaxNumBins);
+
+  /**
+   * @brief Read bins written by Save, a "size num_reserved" pair per line.
+   *
+   * @param path file path
+   * @return MemoryBinConfig the bins
+   */
+  static MemoryBinConfig Load(const std::string &path);
+  void Save(const std::string &path) const;
+
+  // The memory reserved by the bins in bytes
+  size_t GetReservedBytes() const;
+};
+
+namespace detail {
+
+// Thread-safe accumulation of MemoryPoolStats (and of a MemoryTrace)
+class MemoryStatsRecorder {
+ public:
+  void AddBin(size_t bin_size);
+  void RecordAllocate(size_t bytes);
+  void RecordDeallocate(size_t bytes);
+  void RecordUpstreamAllocate(size_t bytes);
+  void RecordUpstreamDeallocate(size_t bytes);
+
+  MemoryPoolStats Get() const;
+  void ResetPeak();
+
+  void StartTrace();
+  MemoryTrace StopTrace();
+
+ private:
+  mutable std::mutex mutex_;
+  MemoryPoolStats stats_;
+  bool tracing_ = false;
+  MemoryTrace trace_;
+  // The number of live requests per requested size
+  std::map<size_t, int64_t> live_by_size_;
+
+  MemoryBinStats &FindBin(size_t bytes);
+};
+
+#ifdef USE_CPU_BACKEND
+using MemoryResourceBase = HostMemoryResource;
+#else
+using MemoryResourceBase = rmm::mr::device_memory_resource;
+#endif
+
+// Forwards allocations to the upstream resource while recording them, either
+// as requests to the pool or as upstream allocations of the pool.
+class StatsResourceAdaptor : public MemoryResourceBase {
+ public:
+  StatsResourceAdaptor(MemoryResourceBase *upstream,
+                       MemoryStatsRecorder *recorder, bool is_upstream)
+      : upstream_{upstream}, recorder_{recorder}, is_upstream_{is_upstream} {}
+
+#ifdef USE_CPU_BACKEND
+  void *allocate(size_t bytes) override {
+    void *ptr = upstream_->allocate(bytes);
+    Record(bytes, true);
+    return ptr;
+  }
+
+  void deallocate(void *ptr, size_t bytes) override {
+    upstream_->deallocate(ptr, bytes);
+    Record(bytes, false);
+  }
+#else
+  bool supports_streams() const noexcept override {
+    return upstream_->supports_streams();
+  }
+  bool supports_get_mem_info() const noexcept override {
+    return upstream_->supports_get_mem_info();
+  }
+
+ private:
+  void *do_allocate(size_t bytes, rmm::cuda_stream_view stream) override {
+    void *ptr = upstream_->allocate(bytes, stream);
+    Record(bytes, true);
+    return ptr;
+  }
+
+  void do_deallocate(void *ptr, size_t bytes,
+                     rmm::cuda_stream_view stream) override {
+    upstream_->deallocate(ptr, bytes, stream);
+    Record(bytes, false);
+  }
+
+  std::pair<size_t, size_t> do_get_mem_info(
+      rmm::cuda_stream_view stream) const override {
+    return upstream_->get_mem_info(stream);
+  }
+#endif
+
+ private:
+  MemoryResourceBase *upstream_;
+  MemoryStatsRecorder *recorder_;
+  bool is_upstream_;
+
+  void Record(size_t bytes, bool allocate) {
+    if (bytes == 0) return;
+    if (is_upstream_) {
+      allocate ? recorder_->RecordUpstreamAllocate(bytes)
+               : recorder_->RecordUpstreamDeallocate(bytes);
+    } else {
+      allocate ? recorder_->RecordAllocate(bytes)
+               : recorder_->RecordDeallocate(bytes);
+    }
+  }
+};
+
+}  // namespace detail
+
 // After the creation of an MemoryPool object, all memory allocations on the
-// current device uses binning_memory_resouce.
+// current device uses binning_memory_resouce. When the current pool is
+// destroyed, the most recently created pool still alive (or the default
+// resource, if none) becomes current.
+
+// With the CPU backend, the same bins are kept in host memory.
 
+// The allocations through the pool, and those of the pool from the upstream,
+// are recorded (see MemoryPoolStats). The bins may be given instead (see
+// MemoryBinConfig).
 class MemoryPool {
+#ifdef USE_CPU_BACKEND
+  using DefaultUpstream = AlignedHostMemoryResource;
+  using MemoryPoolBase = BinningHostMemoryResource<detail::StatsResourceAdaptor>;
+#else
   using DefaultUpstream = rmm::mr::cuda_async_memory_resource;
-  using MemoryPoolBase = rmm::mr::binning_memory_resource<DefaultUpstream>;
+  using MemoryPoolBase =
+      rmm::mr::binning_memory_resource<detail::StatsResourceAdaptor>;
+#endif
 
  public:
   template <typename word>
-  explicit MemoryPool(const Parameter<word> &param);
+  explicit MemoryPool(const Parameter<word> &param,
+                      const MemoryBinConfig *bin_config = nullptr);
   ~MemoryPool();
 
+  MemoryPoolStats GetStats() const;
+
+  // Whether new allocations go through this pool
+  bool IsCurrent() const;
+
+  // Restart the peaks from the current live sizes
+  void ResetPeakStats() const;
+
+  // Record the requests until StopTrace
+  void StartTrace() const;
+  MemoryTrace StopTrace() const;
+
  private:
+  // The order matters here.
+  mutable detail::MemoryStatsRecorder recorder_;
   DefaultUpstream base_;
+  detail::StatsResourceAdaptor upstream_stats_;
+#ifndef USE_CPU_BACKEND
+  // The bins with reserved blocks, which the binning resource does not own
+  std::vector<std::unique_ptr<
+      rmm::mr::fixed_size_memory_resource<detail::StatsResourceAdaptor>>>
+      reserved_bins_;
+#endif
   MemoryPoolBase memory_pool_;
+  detail::StatsResourceAdaptor stats_;
+
+  void MakeCurrent();
+  void AddBin(size_t bin_size, int num_reserved = 0);
+  template <typename word>
+  void AddDefaultBins(const Parameter<word> &param);
 };
 
-}  // namespace cheddar
\ No newline at end of file
+}  // namespace cheddar
@@ -28,6 +28,16 @@ class ModSwitchHandler {
                    const ElementWiseHandler<word> &elem_handler,
                    const NTTHandler<word> &ntt_handler);
 
+  /**
+   * @brief Get the size of the constants a ModSwitchHandler for the given
+   * level holds, without creating one.
+   *
+   * @param param CKKS parameter
+   * @param level level in range [-1, max_level_] (-1 for the SSE handler)
+   * @return size_t size in bytes
+   */
+  static size_t GetConstantBytes(const Parameter<word> &param, int level);
+
   // diable copying (or moving also)
   ModSwitchHandler(const ModSwitchHandler &) = delete;
   ModSwitchHandler &operator=(const ModSwitchHandler &) = delete;
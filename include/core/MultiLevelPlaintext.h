@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+
+#include "core/Container.h"
+#include "core/Parameter.h"
+
+namespace cheddar {
+
+/**
+ * @brief The same message encoded for a range of levels with the same scale.
+ * The message is encoded only once, over the union of the primes of all the
+ * levels. As every RNS limb (and its NTT) only depends on its own prime, the
+ * plaintext at each level is a contiguous range of these limbs, which is
+ * copied out on the first access.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class MultiLevelPlaintext {
+ private:
+  using Pt = Plaintext<word>;
+
+  const Parameter<word> *param_ = nullptr;
+  int min_level_ = 0;
+  int max_level_ = -1;
+
+  // Plaintext over the union of the primes of [min_level_, max_level_]
+  Pt base_;
+  std::map<int, Pt> level_map_;
+
+ public:
+  /**
+   * @brief Returns the NPInfo covering the primes of all the levels in
+   * [min_level, max_level], over which the base plaintext is encoded.
+   */
+  static NPInfo UnionNP(const Parameter<word> &param, int min_level,
+                        int max_level);
+
+  MultiLevelPlaintext() = default;
+
+  /**
+   * @brief Construct a new MultiLevelPlaintext object.
+   *
+   * @param param CKKS parameter
+   * @param min_level the lowest level
+   * @param max_level the highest level
+   * @param base a plaintext encoded over UnionNP(param, min_level, max_level)
+   */
+  MultiLevelPlaintext(const Parameter<word> &param, int min_level,
+                      int max_level, Pt &&base);
+
+  // movable, but not copyable
+  MultiLevelPlaintext(MultiLevelPlaintext &&) = default;
+  MultiLevelPlaintext &operator=(MultiLevelPlaintext &&) = default;
+
+  int GetMaxLevel() const;
+  int GetMinLevel() const;
+
+  /**
+   * @brief Returns the plaintext at the given level, which is the same as
+   * encoding the message at that level with the same scale.
+   *
+   * @param level a level in [GetMinLevel(), GetMaxLevel()]
+   * @return const Pt& the plaintext at the level
+   */
+  const Pt &AtLevel(int level);
+  bool Exists(int level) const;
+  void Clear();
+};
+
+}  // namespace cheddar
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "core/DeviceVector.h"
 #include "core/Parameter.h"
 
 namespace cheddar {
 
+class TableCache;
+
 namespace kernel {
 
 // dst = f(dst, src, const_src, prime, montgormey)
@@ -23,30 +29,62 @@ class NTTHandler {
   using Dv = DeviceVector<word>;
   using Hv = HostVector<word>;
 
+#ifndef USE_CPU_BACKEND
   static inline bool cm_populated_ = false;
+#endif
 
   const Parameter<word> &param_;
 
   Dv twiddle_factors_;
-  Dv twiddle_factors_msb_;
-  Dv inv_twiddle_factors_;
-  Dv inv_twiddle_factors_msb_;
   Dv inv_degree_;
   Dv inv_degree_mont_;
   Dv montgomery_converter_;
 
+#ifdef USE_CPU_BACKEND
+  // Twiddle factors in standard (non-Montgomery) form and their Shoup
+  // companions floor(w * 2^word_size / q) for the host butterflies. The
+  // entries of the last four stages are permuted (see NTT_cpu.cpp).
+  Dv shoup_twiddle_factors_;
+  Dv shoup_twiddle_factors_pre_;
+  Dv shoup_inv_twiddle_factors_;
+  Dv shoup_inv_twiddle_factors_pre_;
+#else
+  Dv twiddle_factors_msb_;
+  Dv inv_twiddle_factors_;
+  Dv inv_twiddle_factors_msb_;
+
   int GetLsbSize() const;
   int GetMsbSize() const;
+  static int GetLsbSize(int log_degree);
+  static int GetMsbSize(int log_degree);
   int GetLogWarpBatching() const;
   int GetStageMerging(NTTType type, Phase phase) const;
   int GetBlockDim(NTTType type, Phase phase) const;
+#endif
 
  public:
   // TODO: allow for different log_degree
   static constexpr int min_log_degree_ = 12;
   static constexpr int max_log_degree_ = 16;
 
-  explicit NTTHandler(const Parameter<word> &param);
+  /**
+   * @brief Construct a new NTTHandler object. The twiddle factors are loaded
+   * from the table cache if it has them, and stored into it otherwise.
+   *
+   * @param param CKKS parameter
+   * @param tables precomputed table cache (optional)
+   */
+  explicit NTTHandler(const Parameter<word> &param,
+                      TableCache *tables = nullptr);
+
+  /**
+   * @brief Get the size of the tables an NTTHandler for the given parameter
+   * holds, without creating one.
+   *
+   * @param param CKKS parameter
+   * @return size_t size in bytes
+   */
+  static size_t GetTableBytes(const Parameter<word> &param);
 
   // disable copying (or moving also)
   NTTHandler(const NTTHandler &) = delete;
@@ -84,6 +122,7 @@ class NTTHandler {
 
  private:
   void PopulateTwiddleFactors();
+  std::vector<std::pair<std::string, Dv *>> GetTables();
 };
 
 }  // namespace cheddar
\ No newline at end of file
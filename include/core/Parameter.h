@@ -135,6 +135,15 @@ class Parameter {
    */
   bool IsUsingSparseSecretEncapsulation() const;
 
+  /**
+   * @brief Get a 64-bit hash of everything that defines the parameter (word
+   * size, degree, scale, primes, level configuration, and Hamming weights),
+   * to key data precomputed for it (see TableCache).
+   *
+   * @return uint64_t the fingerprint
+   */
+  uint64_t GetFingerprint() const;
+
   /**
    * @brief Get the maximum number of terminal primes. Refer to our paper.
    *
@@ -195,6 +204,15 @@ class Parameter {
    */
   int NPToLevel(const NPInfo &np) const;
 
+  /**
+   * @brief Get the NPInfo of an evaluation key usable up to a given level.
+   *
+   * @param max_level level in range [0, max_level_], or -1 for the
+   * dense-to-sparse key of SSE
+   * @return NPInfo the NPInfo of the evaluation key
+   */
+  NPInfo GetEvkNP(int max_level) const;
+
   /**
    * @brief Get a concatenated vector of primes for a given level. The
    * concatenated list is composed as follows: ter_primes_[num_ter - 1 ... 0],
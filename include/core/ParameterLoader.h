@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/Parameter.h"
+
+namespace cheddar {
+
+/**
+ * @brief The contents of a parameter file in the JSON format of the files in
+ * parameters/, e.g.,
+ *
+ *   {"log_degree": 16, "log_default_scale": 30, "default_encryption_level": 22,
+ *    "main_primes": [...], "terminal_primes": [...], "auxiliary_primes": [...],
+ *    "level_config": [[2, 0], [3, 0], ...], "additional_base": [0, 0],
+ *    "dense_hamming_weight": 32768, "sparse_hamming_weight": 32,
+ *    "boot": true, "num_cts_levels": 4, "num_stc_levels": 3}
+ *
+ * where terminal_primes, additional_base, the Hamming weights, and the
+ * bootstrapping entries are optional. Unknown entries are ignored.
+ */
+struct ParameterConfig {
+  int log_degree = 0;
+  int log_default_scale = 0;
+  int default_encryption_level = 0;
+  std::vector<uint64_t> main_primes;
+  std::vector<uint64_t> terminal_primes;
+  std::vector<uint64_t> auxiliary_primes;
+  std::vector<std::pair<int, int>> level_config;
+  std::pair<int, int> additional_base{0, 0};
+  // -1 for the default of Parameter
+  int dense_hamming_weight = -1;
+  int sparse_hamming_weight = -1;
+
+  // Bootstrapping (see BootParameter)
+  bool boot = false;
+  int num_cts_levels = 0;
+  int num_stc_levels = 0;
+
+  /**
+   * @brief Read a parameter file.
+   *
+   * @param path JSON file path
+   * @return ParameterConfig the parsed contents
+   */
+  static ParameterConfig Load(const std::string &path);
+
+  /**
+   * @brief Parse the contents of a parameter file.
+   *
+   * @param text JSON text
+   * @return ParameterConfig the parsed contents
+   */
+  static ParameterConfig Parse(const std::string &text);
+
+  /**
+   * @brief Construct a Parameter, with the Hamming weights applied.
+   *
+   * @tparam word uint32_t or uint64_t
+   * @return std::unique_ptr<Parameter<word>> the new Parameter
+   */
+  template <typename word>
+  std::unique_ptr<Parameter<word>> CreateParameter() const;
+};
+
+}  // namespace cheddar
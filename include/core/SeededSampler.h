@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/DeviceVector.h"
+#include "core/Parameter.h"
+
+namespace cheddar {
+
+/**
+ * @brief A seed from which a uniformly random polynomial is expanded, so that
+ * the random (ax) half of a fresh ciphertext or an evaluation key can be
+ * stored and sent as a seed.
+ */
+struct PolySeed {
+  uint64_t words[2] = {0, 0};
+
+  /**
+   * @brief Sample a fresh seed from std::random_device.
+   *
+   * @return PolySeed the new seed
+   */
+  static PolySeed Generate();
+
+  bool operator==(const PolySeed &other) const;
+};
+
+/**
+ * @brief Expand a seed into a uniformly random polynomial in [0, q_i) for
+ * every prime of np, by rejection sampling. The output is meant to be used
+ * as it is in the NTT (and Montgomery) form, so no transform is applied.
+ * Each limb is drawn from SHAKE128 of (seed, stream, the position of its
+ * prime in the parameter) as 64-bit little-endian words, so the limbs shared
+ * by two NPInfos are the same.
+ *
+ * @tparam word uint32_t or uint64_t
+ * @param poly output polynomial (resized to np.GetNumTotal() * degree)
+ * @param param CKKS parameter
+ * @param np the NPInfo of the polynomial
+ * @param seed the seed
+ * @param stream an index to draw several polynomials from a seed
+ */
+template <typename word>
+void ExpandUniformPolynomial(DeviceVector<word> &poly,
+                             const Parameter<word> &param, const NPInfo &np,
+                             const PolySeed &seed, int stream = 0);
+
+}  // namespace cheddar
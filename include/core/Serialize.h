@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/Assert.h"
+#include "core/Container.h"
+#include "core/Parameter.h"
+#include "core/SeededSampler.h"
+
+namespace cheddar {
+
+/**
+ * @brief Kinds of serialized objects.
+ */
+enum class SerialType : uint8_t {
+  kCiphertext = 1,
+  kPlaintext = 2,
+  kEvaluationKey = 3,
+};
+
+/**
+ * @brief The header of a serialized object. A serialized object is this
+ * header followed by its polynomials (in the layout they have on the device),
+ * each starting at a kSerialAlignment-byte aligned offset from the header, so
+ * that the polynomials of an aligned (e.g., memory-mapped) buffer can be
+ * copied to the device as they are. All the fields are in host byte order.
+ *
+ * With the kSeededAx flag, the ax polynomials are not stored. Instead, a
+ * kSerialAlignment-byte block holding their PolySeed follows the header, and
+ * they are expanded from it on loading (see ExpandUniformPolynomial).
+ *
+ * With the kBitPacked flag, each limb of a polynomial is packed to the bit
+ * length of its prime (see Serializer), and the polynomial is padded to a
+ * multiple of kSerialAlignment bytes as a whole.
+ */
+struct SerialHeader {
+  static constexpr uint32_t kMagic = 0x52444843;  // "CHDR"
+  static constexpr uint16_t kVersion = 1;
+
+  // flags
+  static constexpr uint32_t kHasRx = 1;
+  static constexpr uint32_t kSeededAx = 2;
+  static constexpr uint32_t kBitPacked = 4;
+
+  uint32_t magic;
+  uint16_t version;
+  SerialType type;
+  uint8_t word_bytes;
+  int32_t log_degree;
+  int32_t num_main;
+  int32_t num_ter;
+  int32_t num_aux;
+  int32_t num_slots;
+  int32_t num_polys;
+  uint32_t flags;
+  int32_t reserved;
+  double scale;
+  // hash of the primes of the NPInfo, see Serializer::PrimeFingerprint
+  uint64_t prime_fingerprint;
+  // total size of the serialized object in bytes (including this header)
+  uint64_t total_bytes;
+
+  NPInfo GetNP() const;
+  // offset of the first polynomial from the header
+  size_t GetPolyOffset() const;
+};
+
+constexpr size_t kSerialAlignment = 64;
+static_assert(sizeof(SerialHeader) == kSerialAlignment,
+              "SerialHeader should fill exactly one alignment unit");
+
+/**
+ * @brief Reader/writer of the binary format described in SerialHeader. The
+ * header is validated against the parameter (word size, degree, and primes)
+ * before loading.
+ *
+ * With bit-packing, the coefficients of a limb are stored with the bit length
+ * of its prime instead of a full word (e.g., 30 bits in a uint32_t), which
+ * shrinks the output at the cost of a (vectorized) pack/unpack pass on the
+ * host. Packed polynomials are unpacked into a staging buffer on loading
+ * instead of being copied from the buffer as they are. Deserialize accepts
+ * both forms regardless of the setting.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class Serializer {
+ private:
+  using Ct = Ciphertext<word>;
+  using Pt = Plaintext<word>;
+  using Evk = EvaluationKey<word>;
+
+  const Parameter<word> &param_;
+  bool bit_packing_;
+
+  size_t GetPolyBytes(const NPInfo &np, bool bit_packed) const;
+  SerialHeader MakeHeader(SerialType type, const NPInfo &np, int num_polys,
+                          bool seeded_ax = false) const;
+  SerialHeader ReadHeader(const void *buffer, size_t size,
+                          SerialType type) const;
+  void WritePolys(std::ostream &os, const SerialHeader &header,
+                  const std::vector<const DeviceVector<word> *> &polys,
+                  const PolySeed *seed = nullptr) const;
+  void ReadPoly(DeviceVector<word> &dst, const void *buffer,
+                const SerialHeader &header, int index) const;
+  PolySeed ReadSeed(const void *buffer) const;
+
+ public:
+  /**
+   * @brief Construct a new Serializer object.
+   *
+   * @param param CKKS parameter
+   * @param bit_packing whether to bit-pack the polynomials on writing
+   */
+  explicit Serializer(const Parameter<word> &param, bool bit_packing = false);
+
+  /**
+   * @brief Returns a hash of the degree and the primes of an NPInfo, which
+   * tells whether serialized data was produced under the same parameter.
+   *
+   * @param np the NPInfo
+   * @return uint64_t the fingerprint
+   */
+  uint64_t PrimeFingerprint(const NPInfo &np) const;
+
+  /**
+   * @brief Returns the number of bytes Serialize writes for an object.
+   */
+  size_t GetSerializedSize(const Ct &ct) const;
+  size_t GetSerializedSize(const Pt &ptxt) const;
+  size_t GetSerializedSize(const Evk &evk) const;
+
+  /**
+   * @brief Returns the number of bytes SerializeCompressed writes for an
+   * object.
+   */
+  size_t GetCompressedSize(const Ct &ct) const;
+  size_t GetCompressedSize(const Evk &evk) const;
+
+  /**
+   * @brief Write an object to a stream. The size of the output is a multiple
+   * of kSerialAlignment, so objects can be written back to back.
+   *
+   * @param os output stream (binary)
+   * @param ct/ptxt/evk the object to write
+   */
+  void Serialize(std::ostream &os, const Ct &ct) const;
+  void Serialize(std::ostream &os, const Pt &ptxt) const;
+  void Serialize(std::ostream &os, const Evk &evk) const;
+
+  /**
+   * @brief Write an object whose ax polynomials were expanded from a seed
+   * (stream 0 for a ciphertext, stream i for ax_[i] of an evaluation key),
+   * storing the seed instead of them. This roughly halves the size of fresh
+   * ciphertexts and evaluation keys. Deserialize expands them back.
+   *
+   * @param os output stream (binary)
+   * @param ct/evk the object to write (a ciphertext should not have rx)
+   * @param seed the seed ax was expanded from
+   */
+  void SerializeCompressed(std::ostream &os, const Ct &ct,
+                           const PolySeed &seed) const;
+  void SerializeCompressed(std::ostream &os, const Evk &evk,
+                           const PolySeed &seed) const;
+
+  /**
+   * @brief Load an object from a buffer holding its serialization. The
+   * polynomials are copied to the device directly from the buffer.
+   *
+   * @param ct/ptxt/evk the output object
+   * @param buffer a kSerialAlignment-byte aligned buffer
+   * @param size the size of the buffer in bytes
+   * @return size_t the number of bytes consumed (the start of the next object)
+   */
+  size_t Deserialize(Ct &ct, const void *buffer, size_t size) const;
+  size_t Deserialize(Pt &ptxt, const void *buffer, size_t size) const;
+  size_t Deserialize(Evk &evk, const void *buffer, size_t size) const;
+};
+
+/**
+ * @brief Write a trivially copyable value as it is in memory.
+ */
+template <typename T>
+void WriteValue(std::ostream &os, const T &value) {
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * @brief A bounds-checked cursor over a buffer, to read composite objects
+ * written with WriteValue and Serializer (e.g., prepared bootstrapping
+ * state). Serialized containers are read with Serializer::Deserialize at
+ * Current(), followed by Skip().
+ */
+class SerialReader {
+ private:
+  const char *data_;
+  size_t size_;
+  size_t pos_ = 0;
+
+ public:
+  SerialReader(const void *data, size_t size)
+      : data_{static_cast<const char *>(data)}, size_{size} {}
+
+  template <typename T>
+  T Read() {
+    AssertTrue(Remaining() >= sizeof(T), "SerialReader: Truncated buffer");
+    T value;
+    std::memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  void Skip(size_t bytes) {
+    AssertTrue(Remaining() >= bytes, "SerialReader: Truncated buffer");
+    pos_ += bytes;
+  }
+
+  const void *Current() const { return data_ + pos_; }
+  size_t Remaining() const { return size_ - pos_; }
+  size_t GetPosition() const { return pos_; }
+};
+
+/**
+ * @brief A read-only memory mapping of a whole file, to be used as the buffer
+ * for Serializer::Deserialize. The mapping is page-aligned.
+ */
+class MappedFile {
+ private:
+  void *data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path);
+
+  // movable, but not copyable
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile();
+
+  const void *data() const;
+  size_t size() const;
+};
+
+}  // namespace cheddar
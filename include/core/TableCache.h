@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/DeviceVector.h"
+#include "core/Serialize.h"
+
+namespace cheddar {
+
+/**
+ * @brief A file of tables precomputed for a parameter (e.g., NTT twiddle
+ * factors), so that a new process loads them instead of computing them
+ * again. The tables are named arrays handled in groups: a handler either
+ * finds all the tables of its group and copies them to the device, or
+ * computes them and stores them into the cache to be written by Save.
+ *
+ * A file is bound to a parameter fingerprint (see Parameter::GetFingerprint)
+ * and to the backend. A file that does not exist or does not match is
+ * treated as an empty cache, and replaced on Save.
+ */
+class TableCache {
+ public:
+  template <typename word>
+  using NamedTables = std::vector<std::pair<std::string, DeviceVector<word> *>>;
+
+  struct FileHeader {
+    static constexpr uint32_t kMagic = 0x54444843;  // "CHDT"
+    static constexpr uint16_t kVersion = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t backend;
+    uint8_t reserved0;
+    int32_t num_tables;
+    int32_t reserved1;
+    uint64_t fingerprint;
+    uint64_t reserved2[5];
+  };
+  static_assert(sizeof(FileHeader) == kSerialAlignment,
+                "FileHeader should fill exactly one alignment unit");
+
+  static constexpr int kMaxNameLength = 47;
+
+  struct IndexEntry {
+    char name[kMaxNameLength + 1];
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  /**
+   * @brief Open a cache file. The file does not need to exist.
+   *
+   * @param path cache file path
+   * @param fingerprint the fingerprint of the parameter
+   */
+  TableCache(const std::string &path, uint64_t fingerprint);
+
+  // disable copying (or moving also)
+  TableCache(const TableCache &) = delete;
+  TableCache &operator=(const TableCache &) = delete;
+
+  /**
+   * @brief Load the tables of a group into device vectors. Nothing is loaded
+   * unless the cache has all of them.
+   *
+   * @tparam word uint32_t or uint64_t
+   * @param group group name (e.g., "ntt")
+   * @param tables the tables with their names in the group
+   * @return true if the tables are loaded
+   */
+  template <typename word>
+  bool Load(const std::string &group, const NamedTables<word> &tables) const;
+
+  /**
+   * @brief Store (a host copy of) the tables of a group.
+   *
+   * @tparam word uint32_t or uint64_t
+   * @param group group name (e.g., "ntt")
+   * @param tables the tables with their names in the group
+   */
+  template <typename word>
+  void Store(const std::string &group, const NamedTables<word> &tables);
+
+  bool Contains(const std::string &name) const;
+  int GetNumTables() const;
+
+  /**
+   * @brief Whether tables were stored since the file was opened (or last
+   * saved).
+   */
+  bool IsModified() const;
+
+  /**
+   * @brief Write all the tables to the file if the cache is modified. The
+   * file is replaced atomically, so other processes may keep reading the
+   * previous version.
+   */
+  void Save();
+
+ private:
+  struct Table {
+    const char *data;
+    uint64_t bytes;
+  };
+
+  std::string path_;
+  uint64_t fingerprint_;
+  MappedFile file_;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Table> tables_;
+  // Storage of the tables stored after opening the file
+  std::map<std::string, std::vector<char>> stored_;
+  bool modified_ = false;
+
+  static std::string GetName(const std::string &group,
+                             const std::string &name);
+};
+
+}  // namespace cheddar
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "core/Container.h"
+#include "core/DeviceVector.h"
+#include "core/NPInfo.h"
+
+namespace cheddar {
+
+/**
+ * @brief A source of reusable temporaries (ciphertexts and device vectors).
+ * Temporaries taken from a workspace are given back after use with their
+ * memory kept, instead of being freed to the memory pool.
+ *
+ * A workspace may be made active on the calling thread (see Activation).
+ * The Context operations then take their own temporaries (e.g., the ModUp
+ * results and the accumulators of the key switchings, or the INTT buffers of
+ * ModUp, ModDown and Rescale) from it. BootWorkspace is one, active during
+ * BootContext::Boot.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class Workspace {
+ protected:
+  using Dv = DeviceVector<word>;
+  using Ct = Ciphertext<word>;
+
+  Workspace() = default;
+  Workspace(const Workspace &) = default;
+  Workspace(Workspace &&) = default;
+  Workspace &operator=(const Workspace &) = default;
+  Workspace &operator=(Workspace &&) = default;
+
+ public:
+  virtual ~Workspace() = default;
+
+  // A ciphertext without rx, with the given NPInfo (contents undefined)
+  virtual Ct TakeCt(const NPInfo &np = NPInfo{}) = 0;
+  virtual Dv TakeDv(int size) = 0;
+  virtual void Return(Ct &&ct) = 0;
+  virtual void Return(Dv &&dv) = 0;
+
+  // Give back all the ciphertexts in a map and clear it
+  void Return(std::map<int, Ct> &cts);
+
+  /**
+   * @brief The workspace active on the calling thread, or nullptr.
+   */
+  static Workspace *GetActive();
+
+  /**
+   * @brief Makes a workspace active on the calling thread until destruction,
+   * after which the previously active one (if any) is restored. A null
+   * workspace leaves the active one as it is.
+   */
+  class Activation {
+   public:
+    explicit Activation(Workspace *workspace);
+    ~Activation();
+
+    Activation(const Activation &) = delete;
+    Activation &operator=(const Activation &) = delete;
+
+   private:
+    bool activated_;
+    Workspace *previous_;
+  };
+
+  /**
+   * @brief Takes the temporaries out of a workspace and gives them back on
+   * destruction. With a null workspace, the temporaries are allocated and
+   * freed as usual.
+   */
+  class Scope {
+   public:
+    explicit Scope(Workspace *workspace);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    // A ciphertext without rx, with the given NPInfo (contents undefined)
+    Ct &TakeCt(const NPInfo &np = NPInfo{});
+    Dv &TakeDv(int size);
+    // count device vectors of the given size (e.g., ModUp results)
+    std::vector<Dv> &TakeDvs(int count, int size);
+    // A device vector of each given size
+    std::vector<Dv> &TakeDvs(const std::vector<int> &sizes);
+    // An empty map, of which the ciphertexts are given back as well
+    std::map<int, Ct> &TakeCtMap();
+
+    // A ciphertext to be placed in a map (e.g., one from TakeCtMap)
+    Ct MakeCt(const NPInfo &np = NPInfo{});
+
+   private:
+    Workspace *workspace_;
+    // deque for stable references
+    std::deque<Ct> cts_;
+    std::deque<Dv> dvs_;
+    std::deque<std::vector<Dv>> dv_vectors_;
+    std::deque<std::map<int, Ct>> ct_maps_;
+
+    Dv MakeDv(int size);
+  };
+};
+
+}  // namespace cheddar
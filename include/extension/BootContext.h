@@ -2,12 +2,14 @@
 
 #include <map>
 #include <memory>
+#include <ostream>
 #include <vector>
 
 #include "core/Context.h"
 #include "core/EvkMap.h"
 #include "core/EvkRequest.h"
 #include "extension/BootParameter.h"
+#include "extension/BootWorkspace.h"
 #include "extension/EvalMod.h"
 #include "extension/EvalSpecialFFT.h"
 
@@ -55,15 +57,34 @@ class BootContext : public Context<word>,
 
   BootContext(const Parameter<word> &, const BootParameter &);
 
+  // The temporaries reserved by CreateWorkspace
+  struct WorkspaceSize {
+    int num_cts;
+    NPInfo ct_np;
+    int num_dvs;
+    int dv_size;
+
+    size_t GetBytes(int degree) const;
+  };
+
+  static WorkspaceSize GetWorkspaceSize(const Parameter<word> &param,
+                                        int num_fft_cts, int num_mod_cts);
+
   int GetBootEnabledNumSlots(int num_slots) const;
   double GetCtSConst() const;
   double GetStCConst(BootVariant variant = BootVariant::kNormal) const;
-  void ModUpToMax(Ct &res, const Ct &input, const EvkMap<word> &evk_map) const;
+  void ModUpToMax(Ct &res, const Ct &input, const EvkMap<word> &evk_map,
+                  BootWorkspace<word> *workspace = nullptr) const;
   void CoeffToSlot(Ct &res, int num_slots, const Ct &input,
-                   const EvkMap<word> &evk_map, bool min_ks = false) const;
+                   const EvkMap<word> &evk_map, bool min_ks = false,
+                   BootWorkspace<word> *workspace = nullptr) const;
   void SlotToCoeff(Ct &res, int num_slots, const Ct &input,
-                   const EvkMap<word> &evk_map, bool min_ks = false) const;
-  void EvaluateMod(Ct &res, const Ct &input, const Evk &mult_key) const;
+                   const EvkMap<word> &evk_map, bool min_ks = false,
+                   BootWorkspace<word> *workspace = nullptr) const;
+  void EvaluateMod(Ct &res, const Ct &input, const Evk &mult_key,
+                   BootWorkspace<word> *workspace = nullptr) const;
+  void EvaluateBoot(Ct &res, const Ct &input, const EvkMap<word> &evk_map,
+                    bool min_ks, BootWorkspace<word> *workspace) const;
 
   ContextPtr<word> GetContext();
   ConstContextPtr<word> GetContext() const;
@@ -110,6 +131,28 @@ class BootContext : public Context<word>,
   void PrepareEvalSpecialFFT(int num_slots,
                              BootVariant variant = BootVariant::kNormal);
 
+  /**
+   * @brief Writes the special FFT and IFFT state prepared for num_slots, so
+   * that another process with the same Parameter and BootParameter can import
+   * it instead of calling PrepareEvalSpecialFFT. EvalMod is not included, as
+   * PrepareEvalMod is cheap compared to the special FFT.
+   *
+   * @param os output stream (opened in binary mode)
+   * @param num_slots number of slots the state was prepared for
+   */
+  void ExportEvalSpecialFFT(std::ostream &os, int num_slots) const;
+
+  /**
+   * @brief Imports the state written by ExportEvalSpecialFFT, which has the
+   * same effect as PrepareEvalSpecialFFT with the exported num_slots and
+   * variant. The buffer may be a MappedFile.
+   *
+   * @param buffer exported state
+   * @param size size of the buffer in bytes
+   * @return size_t the number of bytes read
+   */
+  size_t ImportEvalSpecialFFT(const void *buffer, size_t size);
+
   // 2. Retrieve required rotation distances for performing bootstrapping.
 
   /**
@@ -139,6 +182,49 @@ class BootContext : public Context<word>,
   void Boot(Ct &res, const Ct &input, const EvkMap<word> &evk_map,
             bool min_ks = false) const;
 
+  /**
+   * @brief Perform bootstrapping, taking the temporaries from a workspace
+   * instead of allocating them, including those of the Context operations
+   * inside. Repeating Boot with the same workspace reuses the same buffers.
+   *
+   * @param res bootstrapping result ciphertext
+   * @param input input ciphertext
+   * @param evk_map client-provided EvkMap
+   * @param workspace workspace (see CreateWorkspace)
+   * @param min_ks whether to use minimum key-switching
+   */
+  void Boot(Ct &res, const Ct &input, const EvkMap<word> &evk_map,
+            BootWorkspace<word> &workspace, bool min_ks = false) const;
+
+  /**
+   * @brief Creates a workspace for Boot with the temporaries reserved for the
+   * given number of slots. PrepareEvalMod() and PrepareEvalSpecialFFT()
+   * should have been already done.
+   *
+   * @param num_slots number of slots in the ciphertext to be bootstrapped
+   * @return BootWorkspace<word> the new workspace
+   */
+  BootWorkspace<word> CreateWorkspace(int num_slots) const;
+
+  /**
+   * @brief Estimate the device memory a BootContext takes with bootstrapping
+   * prepared for the given numbers of slots, without creating one (see
+   * Context::EstimateMemoryFootprint). The temporaries are those of a
+   * workspace (see CreateWorkspace), which also holds those of the key
+   * switchings. The constants of EvalMod are not counted.
+   *
+   * @param param CKKS parameter
+   * @param boot_param bootstrapping parameters
+   * @param num_slots numbers of slots to prepare bootstrapping for (see
+   * PrepareEvalSpecialFFT)
+   * @param evk_request rotation keys and their maximum levels, e.g., from
+   * AddRequiredRotations
+   * @return MemoryFootprint the estimate
+   */
+  static MemoryFootprint EstimateMemoryFootprint(
+      const Parameter<word> &param, const BootParameter &boot_param,
+      const std::vector<int> &num_slots, const EvkRequest &evk_request = {});
+
   // Other functions...
 
   /**
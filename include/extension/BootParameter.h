@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 namespace cheddar {
@@ -84,6 +85,14 @@ struct BootParameter {
    * @return int the ending level for bootstrapping
    */
   int GetEndLevel() const;
+
+  /**
+   * @brief Get a 64-bit hash of all the bootstrapping parameters, to key data
+   * precomputed for them (see BootContext::ExportEvalSpecialFFT).
+   *
+   * @return uint64_t the fingerprint
+   */
+  uint64_t GetFingerprint() const;
 };
 
 }  // namespace cheddar
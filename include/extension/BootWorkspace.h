@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "core/Container.h"
+#include "core/NPInfo.h"
+#include "core/Workspace.h"
+
+namespace cheddar {
+
+/**
+ * @brief Reusable temporaries for bootstrapping (see BootContext::Boot) and
+ * the evaluations it is made of (HoistHandler, EvalPoly, AXYPBZ). Ciphertexts
+ * and device vectors taken from a workspace are given back after use with
+ * their memory kept, so repeated bootstraps with the same workspace reuse the
+ * same buffers instead of allocating new ones. A workspace created by
+ * BootContext::CreateWorkspace reserves the buffers up front, so the memory
+ * held by it is known before the first bootstrap.
+ *
+ * The workspace is active during Boot (see Workspace::Activation), so the
+ * temporaries inside the Context operations (e.g., the key-switching buffers
+ * of HRot and HMult) are taken from it as well.
+ *
+ * A workspace is not thread-safe; use one per thread.
+ *
+ * @tparam word uint32_t or uint64_t
+ */
+template <typename word>
+class BootWorkspace : public Workspace<word> {
+ private:
+  using Dv = DeviceVector<word>;
+  using Ct = Ciphertext<word>;
+
+  // LIFO, so that a repeated sequence of requests gets the same buffers
+  std::vector<Ct> free_cts_;
+  std::vector<Dv> free_dvs_;
+
+ public:
+  using Scope = typename Workspace<word>::Scope;
+
+  /**
+   * @brief Construct an empty workspace, which grows to the sizes used.
+   */
+  BootWorkspace() = default;
+
+  /**
+   * @brief Construct a workspace reserving the given temporaries.
+   *
+   * @param num_cts number of ciphertexts
+   * @param ct_np NPInfo each ciphertext (bx, ax, and rx) can hold
+   * @param num_dvs number of device vectors
+   * @param dv_size size each device vector can hold
+   */
+  BootWorkspace(int num_cts, const NPInfo &ct_np, int num_dvs, int dv_size);
+
+  BootWorkspace(const BootWorkspace &) = delete;
+  BootWorkspace &operator=(const BootWorkspace &) = delete;
+  BootWorkspace(BootWorkspace &&) = default;
+  BootWorkspace &operator=(BootWorkspace &&) = default;
+
+  Ct TakeCt(const NPInfo &np = NPInfo{}) override;
+  Dv TakeDv(int size) override;
+  using Workspace<word>::Return;
+  void Return(Ct &&ct) override;
+  void Return(Dv &&dv) override;
+
+  int GetNumCts() const;
+  int GetNumDvs() const;
+
+  /**
+   * @brief Get the device memory held by the temporaries currently in the
+   * workspace (not taken out).
+   *
+   * @return size_t memory size in bytes
+   */
+  size_t GetReservedBytes() const;
+};
+
+}  // namespace cheddar
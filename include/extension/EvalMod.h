@@ -54,9 +54,28 @@ class EvalMod {
    * @param res result ciphertext
    * @param input input ciphertext
    * @param mult_key Multiplication key
+   * @param workspace workspace for the temporaries (optional, see
+   * BootWorkspace)
    */
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                const Evk &mult_key);
+                const Evk &mult_key, BootWorkspace<word> *workspace = nullptr);
+
+  /**
+   * @brief Get an upper bound of the number of workspace ciphertexts used at
+   * once by Evaluate.
+   *
+   * @return int the number of ciphertexts
+   */
+  int GetNumWorkspaceCts() const;
+
+  /**
+   * @brief The same as GetNumWorkspaceCts, for an EvalMod that would be
+   * constructed with boot_param (without constructing one).
+   *
+   * @param boot_param bootstrapping parameters
+   * @return int the number of ciphertexts
+   */
+  static int EstimateNumWorkspaceCts(const BootParameter &boot_param);
 
   /**
    * @brief Get the polynomial degree of the mod function.
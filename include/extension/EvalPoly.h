@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "core/Context.h"
+#include "extension/BootWorkspace.h"
 
 namespace cheddar {
 
@@ -58,10 +59,13 @@ class AXYPBZ {
   AXYPBZ(ConstContextPtr<word> context, int a, double b, int x_level,
          double x_scale, int y_level, double y_scale);
 
+  // The temporaries are taken from the workspace if given (see BootWorkspace).
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
-                const Ct &y, const Ct &z, const Evk &mult_key) const;
+                const Ct &y, const Ct &z, const Evk &mult_key,
+                BootWorkspace<word> *workspace = nullptr) const;
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
-                const Ct &y, const Evk &mult_key) const;
+                const Ct &y, const Evk &mult_key,
+                BootWorkspace<word> *workspace = nullptr) const;
 };
 
 /**
@@ -101,7 +105,8 @@ class BasisMap {
   void AddBase(ConstContextPtr<word> context, int base_degree);
 
   void Evaluate(ConstContextPtr<word> context, std::map<int, MLCt> &res,
-                const Evk &mult_key) const;
+                const Evk &mult_key,
+                BootWorkspace<word> *workspace = nullptr) const;
   void PlainEvaluate(std::map<int, double> &res) const;
 };
 
@@ -139,11 +144,11 @@ class EvalPolyNode {
 
   bool IsLeaf() const;
   void EvaluateMiddleNode(ConstContextPtr<word> context, Ct &res,
-                          std::map<int, MLCt> &basis,
-                          const Evk &mult_key) const;
+                          std::map<int, MLCt> &basis, const Evk &mult_key,
+                          BootWorkspace<word> *workspace) const;
   void EvaluateLeaf(ConstContextPtr<word> context, Ct &res,
                     std::map<int, MLCt> &basis, const Evk &mult_key,
-                    bool inplace) const;
+                    bool inplace, BootWorkspace<word> *workspace) const;
 
   int target_level_;
   bool do_rescale_ = true;
@@ -162,8 +167,13 @@ class EvalPolyNode {
                int target_level, double target_scale, bool do_rescale = true);
 
   void Evaluate(ConstContextPtr<word> context, Ct &res,
-                std::map<int, MLCt> &basis, const Evk &mult_key) const;
+                std::map<int, MLCt> &basis, const Evk &mult_key,
+                BootWorkspace<word> *workspace = nullptr) const;
   double PlainEvaluate(std::map<int, double> &res) const;
+
+  // An upper bound of the number of workspace ciphertexts used at once, with
+  // do_rescale as given to Compile (also valid before compilation)
+  int GetNumWorkspaceCts(bool do_rescale = true) const;
 };
 
 /**
@@ -198,6 +208,7 @@ class EvalPoly {
   // Preparation & compile methods
   void PreparePlainChebyshevBasis();
   EvalPolyType DetermineType();
+  std::shared_ptr<EvalPolyNode<word>> CreateTree() const;
 
  public:
   EvalPoly(const std::vector<double> &coefficients, int input_level,
@@ -219,8 +230,12 @@ class EvalPoly {
   void Compile(ConstContextPtr<word> context);
 
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                const Evk &mult_key) const;
+                const Evk &mult_key,
+                BootWorkspace<word> *workspace = nullptr) const;
   double PlainEvaluate(double input) const;
+
+  // See EvalPolyNode::GetNumWorkspaceCts (does not require Compile)
+  int GetNumWorkspaceCts() const;
 };
 
 }  // namespace cheddar
\ No newline at end of file
@@ -35,7 +35,21 @@ class EvalSpecialFFT {
   std::vector<StripedMatrix> plain_fft_stages_;
   std::vector<StripedMatrix> plain_ifft_stages_;
 
-  std::pair<int, int> BSGSSplit(int num_diag) const;
+  // The shape of a CtS or StC phase, known without preparing it
+  struct PhaseShape {
+    int level;
+    int num_diag;      // the number of plaintexts
+    int num_eff_diag;  // for BSGSSplit
+  };
+
+  static std::pair<int, int> BSGSSplit(int num_diag);
+  // The number of FFT stages merged into each phase
+  static std::vector<int> SplitStages(int log_num_slots, int num_phases,
+                                      bool cts);
+  // CtS phases followed by StC phases
+  static std::vector<PhaseShape> GetPhaseShapes(
+      const BootParameter &boot_param, int num_slots);
+
   void PopulatePlainMatrices(ConstContextPtr<word> context);
   void PreparePlaintexts(ConstContextPtr<word> context);
 
@@ -43,16 +57,56 @@ class EvalSpecialFFT {
   EvalSpecialFFT(ConstContextPtr<word> context, const BootParameter &boot_param,
                  int num_slots, double cts_const, double stc_const);
 
+  /**
+   * @brief Construct an EvalSpecialFFT from the state written by Export,
+   * skipping the plaintext compilation.
+   *
+   * @param context CKKS context
+   * @param boot_param bootstrapping parameters used for the export
+   * @param num_slots number of slots
+   * @param cts_const constant multiplied to CtS
+   * @param stc_const constant multiplied to StC
+   * @param reader reader positioned at the state
+   */
+  EvalSpecialFFT(ConstContextPtr<word> context, const BootParameter &boot_param,
+                 int num_slots, double cts_const, double stc_const,
+                 SerialReader &reader);
+
   EvalSpecialFFT(const EvalSpecialFFT &) = delete;
   EvalSpecialFFT &operator=(const EvalSpecialFFT &) = delete;
   EvalSpecialFFT(EvalSpecialFFT &&) = default;
 
   void AddRequiredRotations(EvkRequest &req, bool min_ks = false) const;
 
+  // Write the CtS and StC phases
+  void Export(ConstContextPtr<word> context, std::ostream &os) const;
+
   void EvaluateCtS(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                   const EvkMap<word> &evk_map, bool min_ks = false) const;
+                   const EvkMap<word> &evk_map, bool min_ks = false,
+                   BootWorkspace<word> *workspace = nullptr) const;
   void EvaluateStC(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                   const EvkMap<word> &evk_map, bool min_ks = false) const;
+                   const EvkMap<word> &evk_map, bool min_ks = false,
+                   BootWorkspace<word> *workspace = nullptr) const;
+
+  // The maximum over the phases (see HoistHandler::GetNumWorkspaceCts)
+  int GetNumWorkspaceCts() const;
+
+  /**
+   * @brief Get the size of the plaintexts an EvalSpecialFFT for num_slots
+   * holds, without preparing one.
+   *
+   * @param param CKKS parameter
+   * @param boot_param bootstrapping parameters
+   * @param num_slots number of slots
+   * @return size_t size in bytes
+   */
+  static size_t GetPlaintextBytes(const Parameter<word> &param,
+                                  const BootParameter &boot_param,
+                                  int num_slots);
+
+  // An upper bound of GetNumWorkspaceCts, without preparing the phases
+  static int EstimateNumWorkspaceCts(const BootParameter &boot_param,
+                                     int num_slots);
 };
 
 }  // namespace cheddar
\ No newline at end of file
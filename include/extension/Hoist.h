@@ -9,6 +9,8 @@
 #include "core/Context.h"
 #include "core/EvkMap.h"
 #include "core/EvkRequest.h"
+#include "core/Serialize.h"
+#include "extension/BootWorkspace.h"
 
 namespace cheddar {
 
@@ -74,34 +76,59 @@ class HoistHandler {
                             double input_scale) const;
   void EvaluateMinKSBabyStep(ConstContextPtr<word> context,
                              std::map<int, Ct> &bs, const Ct &input,
-                             const EvkMap<word> &evk_map) const;
+                             const EvkMap<word> &evk_map,
+                             BootWorkspace<word> *workspace) const;
   void EvaluateMinKSGiantStep(ConstContextPtr<word> context, Ct &res,
                               const std::map<int, Ct> &bs,
-                              const EvkMap<word> &evk_map) const;
+                              const EvkMap<word> &evk_map,
+                              BootWorkspace<word> *workspace) const;
 
   void EvaluateGiantStepOptimized(ConstContextPtr<word> context, Ct &res,
                                   const std::map<int, Ct> &bs,
-                                  const EvkMap<word> &evk_map) const;
+                                  const EvkMap<word> &evk_map,
+                                  BootWorkspace<word> *workspace) const;
 
  public:
   HoistHandler(ConstContextPtr<word> context, const PlainHoistMap &hoist_map,
                int pt_level, double pt_scale, bool suppress_bs_swap = false);
 
+  /**
+   * @brief Construct a HoistHandler from the state written by Export.
+   *
+   * @param context CKKS context
+   * @param reader reader positioned at the state
+   */
+  HoistHandler(ConstContextPtr<word> context, SerialReader &reader);
+
   HoistHandler(const HoistHandler &) = delete;
   HoistHandler &operator=(const HoistHandler &) = delete;
   HoistHandler(HoistHandler &&) = default;
 
   void AddRequiredRotations(EvkRequest &req, bool min_ks = false) const;
 
+  // Write the indices and the compiled plaintexts
+  void Export(ConstContextPtr<word> context, std::ostream &os) const;
+
+  // The temporaries are taken from the workspace if given (see
+  // BootWorkspace). The baby-step ciphertexts EvaluateBabyStep puts in bs are
+  // taken from the workspace as well, and can be given back with
+  // BootWorkspace::Return.
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                const EvkMap<word> &evk_map, bool min_ks = false) const;
+                const EvkMap<word> &evk_map, bool min_ks = false,
+                BootWorkspace<word> *workspace = nullptr) const;
   void EvaluateBabyStep(ConstContextPtr<word> context, std::map<int, Ct> &bs,
                         const Ct &input, const EvkMap<word> &evk_map,
-                        bool min_ks = false) const;
+                        bool min_ks = false,
+                        BootWorkspace<word> *workspace = nullptr) const;
   void EvaluateGiantStep(ConstContextPtr<word> context, Ct &res,
                          const std::map<int, Ct> &bs,
-                         const EvkMap<word> &evk_map,
-                         bool min_ks = false) const;
+                         const EvkMap<word> &evk_map, bool min_ks = false,
+                         BootWorkspace<word> *workspace = nullptr) const;
+
+  // An upper bound of the number of workspace ciphertexts used at once
+  int GetNumWorkspaceCts() const;
+  // The same, for num_bs baby steps and num_gs giant steps
+  static int GetNumWorkspaceCts(int num_bs, int num_gs);
 };
 
 }  // namespace cheddar
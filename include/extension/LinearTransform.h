@@ -44,6 +44,9 @@ class LinearTransform {
                   int pt_level, double pt_scale, int bs, int gs = 1,
                   int pre_rotation = 0, int additional_pt_rot = 0);
 
+  // Construct from the state written by Export
+  LinearTransform(ConstContextPtr<word> context, SerialReader &reader);
+
   bool IsUsingBSGS() const;
   int GetBS() const;
   int GetGS() const;
@@ -51,8 +54,14 @@ class LinearTransform {
 
   void AddRequiredRotations(EvkRequest &req, bool min_ks = false) const;
 
+  void Export(ConstContextPtr<word> context, std::ostream &os) const;
+
   void Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &input,
-                const EvkMap<word> &evk_map, bool min_ks = false) const;
+                const EvkMap<word> &evk_map, bool min_ks = false,
+                BootWorkspace<word> *workspace = nullptr) const;
+
+  // See HoistHandler::GetNumWorkspaceCts
+  int GetNumWorkspaceCts() const;
 };
 
 }  // namespace cheddar
\ No newline at end of file
@@ -1,5 +1,12 @@
 #include "UserInterface.h"
+
+#include <vector>
+
+#ifdef USE_CPU_BACKEND
+#include "common/BasicSimd.h"
+#else
 #include "common/Basic.cuh"
+#endif
 #include "common/CommonUtils.h"
 #include "common/ConstantMemory.cuh"
 #include "common/PrimeUtils.h"
@@ -9,6 +16,71 @@ namespace cheddar {
 
 namespace kernel {
 
+#ifdef USE_CPU_BACKEND
+// Host versions of the kernels below, walking the primes limb by limb with
+// the array operations of basic::simd. inv_primes is unused, as
+// basic::Modulus carries its own constants.
+
+// dst.ptrs_[0] --> bx (uninitialized)
+// dst.ptrs_[1] --> ax (sampled random value)
+// bx = -ax * sx + mx + ex
+template <typename word>
+void Encrypt(OutputPtrList<word, 2> dst, const word *primes,
+             const make_signed_t<word> *inv_primes, int num_q_primes,
+             int num_primes, const InputPtrList<word, 1> sx,
+             const InputPtrList<word, 1> mx, const InputPtrList<word, 1> ex) {
+  int degree = cm_degree();
+  std::vector<word> ax_sx(degree);
+  for (int prime_index = 0; prime_index < num_primes; prime_index++) {
+    basic::Modulus<word> mod(primes[prime_index]);
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree;
+    const word *sx_limb = sx.ptrs_[0] + offset + (aux_part ? sx.extra_ : 0);
+    const word *mx_limb = mx.ptrs_[0] + offset + (aux_part ? mx.extra_ : 0);
+    const word *ex_limb = ex.ptrs_[0] + offset + (aux_part ? ex.extra_ : 0);
+    const word *ax_limb = dst.ptrs_[1] + offset;
+    word *bx_limb = dst.ptrs_[0] + offset;
+    basic::simd::MultMontgomery(ax_sx.data(), ax_limb, sx_limb, degree, mod);
+    basic::simd::Sub(ax_sx.data(), mx_limb, ax_sx.data(), degree, mod);
+    basic::simd::Add(bx_limb, ax_sx.data(), ex_limb, degree, mod);
+  }
+}
+
+// bx = -ax * sx + ex
+template <typename word>
+void EncryptZero(OutputPtrList<word, 2> dst, const word *primes,
+                 const make_signed_t<word> *inv_primes, int num_q_primes,
+                 int num_primes, const InputPtrList<word, 1> sx,
+                 const InputPtrList<word, 1> ex) {
+  int degree = cm_degree();
+  std::vector<word> ax_sx(degree);
+  for (int prime_index = 0; prime_index < num_primes; prime_index++) {
+    basic::Modulus<word> mod(primes[prime_index]);
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree;
+    const word *sx_limb = sx.ptrs_[0] + offset + (aux_part ? sx.extra_ : 0);
+    const word *ex_limb = ex.ptrs_[0] + offset + (aux_part ? ex.extra_ : 0);
+    const word *ax_limb = dst.ptrs_[1] + offset;
+    word *bx_limb = dst.ptrs_[0] + offset;
+    basic::simd::MultMontgomery(ax_sx.data(), ax_limb, sx_limb, degree, mod);
+    basic::simd::Sub(bx_limb, ex_limb, ax_sx.data(), degree, mod);
+  }
+}
+
+// dst += src * p_prod
+template <typename word>
+void AddEvkPart(word *dst, const word *primes,
+                const make_signed_t<word> *inv_primes, int num_primes,
+                const word *src, const word *p_prod) {
+  int degree = cm_degree();
+  for (int prime_index = 0; prime_index < num_primes; prime_index++) {
+    basic::Modulus<word> mod(primes[prime_index]);
+    int offset = prime_index * degree;
+    basic::simd::MultMontgomeryConstAccum(dst + offset, src + offset,
+                                          p_prod[prime_index], degree, mod);
+  }
+}
+#else
 // dst.ptrs_[0] --> bx (uninitialized)
 // dst.ptrs_[1] --> ax (sampled random value)
 // bx = -ax * sx + mx + ex
@@ -106,12 +178,14 @@ __global__ void AddEvkPart(word *dst, const word *primes,
 
   dst[i] = res;
 }
+#endif
 
 }  // namespace kernel
 
 template <typename word>
-UserInterface<word>::UserInterface(ContextPtr<word> context)
-    : context_{std::move(context)} {
+UserInterface<word>::UserInterface(ContextPtr<word> context,
+                                   bool seeded_evks /*= false*/)
+    : context_{std::move(context)}, seeded_evks_{seeded_evks} {
   const auto &param = context_->param_;
   all_primes_ =
       param.GetPrimeVector(param.LevelToNP(param.max_level_, param.alpha_));
@@ -129,7 +203,8 @@ UserInterface<word>::UserInterface(ContextPtr<word> context)
 }
 
 template <typename word>
-void UserInterface<word>::Encrypt(Ct &ctxt, const Pt &ptxt) const {
+void UserInterface<word>::Encrypt(Ct &ctxt, const Pt &ptxt,
+                                  PolySeed *ax_seed /*= nullptr*/) const {
   NPInfo np = ptxt.GetNP();
 
   // Setting metadata
@@ -138,7 +213,12 @@ void UserInterface<word>::Encrypt(Ct &ctxt, const Pt &ptxt) const {
   ctxt.SetScale(ptxt.GetScale());
   ctxt.SetNumSlots(ptxt.GetNumSlots());
 
-  SampleRandomPolynomial(ctxt.ax_, np);
+  if (ax_seed != nullptr) {
+    *ax_seed = PolySeed::Generate();
+    ExpandUniformPolynomial(ctxt.ax_, context_->param_, np, *ax_seed);
+  } else {
+    SampleRandomPolynomial(ctxt.ax_, np);
+  }
   int num_q_primes = np.num_main_ + np.num_ter_;
   int num_total_primes = np.GetNumTotal();
   int num_aux = np.num_aux_;
@@ -160,11 +240,16 @@ void UserInterface<word>::Encrypt(Ct &ctxt, const Pt &ptxt) const {
   auto ctxt_temp = ctxt.ViewVector();
   OutputPtrList<word, 2> dst(ctxt_temp);
 
+  // bx = -ax * sx + mx + ex
+#ifdef USE_CPU_BACKEND
+  kernel::Encrypt<word>(dst, primes, inv_primes, num_q_primes,
+                        num_total_primes, sx, mx, ex);
+#else
   int grid_dim = num_total_primes * degree / kernel_block_dim_;
 
-  // bx = -ax * sx + mx + ex
   kernel::Encrypt<word><<<grid_dim, kernel_block_dim_>>>(
       dst, primes, inv_primes, num_q_primes, sx, mx, ex);
+#endif
 }
 
 template <typename word>
@@ -192,27 +277,35 @@ void UserInterface<word>::Decrypt(Pt &ptxt, const Ct &ctxt) const {
 template <typename word>
 const EvaluationKey<word> &UserInterface<word>::GetRotationKey(
     int rot_idx) const {
-  return evk_map_.GetRotationKey(rot_idx);
+  return *evk_map_.GetRotationKey(rot_idx);
 }
 
 template <typename word>
 const EvaluationKey<word> &UserInterface<word>::GetMultiplicationKey() const {
-  return evk_map_.GetMultiplicationKey();
+  return *evk_map_.GetMultiplicationKey();
 }
 
 template <typename word>
 const EvaluationKey<word> &UserInterface<word>::GetConjugationKey() const {
-  return evk_map_.GetConjugationKey();
+  return *evk_map_.GetConjugationKey();
 }
 
 template <typename word>
 const EvaluationKey<word> &UserInterface<word>::GetDenseToSparseKey() const {
-  return evk_map_.GetDenseToSparseKey();
+  return *evk_map_.GetDenseToSparseKey();
 }
 
 template <typename word>
 const EvaluationKey<word> &UserInterface<word>::GetSparseToDenseKey() const {
-  return evk_map_.GetSparseToDenseKey();
+  return *evk_map_.GetSparseToDenseKey();
+}
+
+template <typename word>
+const PolySeed &UserInterface<word>::GetEvkSeed(int key_idx) const {
+  auto found = evk_seeds_.find(key_idx);
+  AssertTrue(found != evk_seeds_.end(),
+             "GetEvkSeed: No seeded key for index " + std::to_string(key_idx));
+  return found->second;
 }
 
 template <typename word>
@@ -428,9 +521,18 @@ void UserInterface<word>::PrepareEvk(int key_idx, const NPInfo &np,
 
   // Prepare each of beta pairs.
   // bx = -ax * encryption_secret + target_secret * const + error
+  PolySeed seed;
+  if (seeded_evks_) {
+    seed = PolySeed::Generate();
+    evk_seeds_[key_idx] = seed;
+  }
   for (int i = 0; i < beta; i++) {
     // Preparing the encryption of 0
-    SampleRandomPolynomial(evk.ax_.at(i), np);
+    if (seeded_evks_) {
+      ExpandUniformPolynomial(evk.ax_.at(i), context_->param_, np, seed, i);
+    } else {
+      SampleRandomPolynomial(evk.ax_.at(i), np);
+    }
     Dv ex_dv(np.GetNumTotal() * degree);
     SampleError(ex_dv, np);
 
@@ -438,15 +540,25 @@ void UserInterface<word>::PrepareEvk(int key_idx, const NPInfo &np,
     OutputPtrList<word, 2> evk_ptr_list(evk_temp);
     InputPtrList<word, 1> ex(ex_dv.ConstView(np.num_aux_ * degree));
 
+    int chunk_size = np.num_aux_;
+    if (i == beta - 1) {
+      chunk_size = num_q - (beta - 1) * np.num_aux_;
+    }
+
+#ifdef USE_CPU_BACKEND
+    kernel::EncryptZero<word>(evk_ptr_list, primes, inv_primes, num_q,
+                              num_q + np.num_aux_, enc_s, ex);
+    kernel::AddEvkPart<word>(evk.bx_.at(i).data() + i * np.num_aux_ * degree,
+                             primes + i * np.num_aux_,
+                             inv_primes + i * np.num_aux_, chunk_size,
+                             target_s_ptr + i * np.num_aux_ * degree,
+                             p_prod.data() + i * np.num_aux_);
+#else
     int grid_dim = (num_q + np.num_aux_) * degree / kernel_block_dim_;
 
     kernel::EncryptZero<word><<<grid_dim, kernel_block_dim_>>>(
         evk_ptr_list, primes, inv_primes, num_q, enc_s, ex);
 
-    int chunk_size = np.num_aux_;
-    if (i == beta - 1) {
-      chunk_size = num_q - (beta - 1) * np.num_aux_;
-    }
     grid_dim = chunk_size * degree / kernel_block_dim_;
 
     kernel::AddEvkPart<word><<<grid_dim, kernel_block_dim_>>>(
@@ -454,6 +566,7 @@ void UserInterface<word>::PrepareEvk(int key_idx, const NPInfo &np,
         primes + i * np.num_aux_, inv_primes + i * np.num_aux_,
         target_s_ptr + i * np.num_aux_ * degree,
         p_prod.data() + i * np.num_aux_);
+#endif
   }
 }
 
@@ -521,23 +634,7 @@ void UserInterface<word>::SampleError(Dv &poly, const NPInfo &np) const {
 
 template <typename word>
 NPInfo UserInterface<word>::GetNPForEvk(int max_level) const {
-  // DtS case
-  if (max_level == -1) {
-    NPInfo short_base = context_->param_.LevelToNP(-1);
-    short_base.num_aux_ = short_base.num_main_ + short_base.num_ter_;
-    return short_base;
-  }
-
-  // Normal case
-  NPInfo res = context_->param_.LevelToNP(0);
-  for (int i = 1; i <= max_level; i++) {
-    NPInfo np_i = context_->param_.LevelToNP(i);
-    res.num_main_ = Max(res.num_main_, np_i.num_main_);
-  }
-  res.num_ter_ = context_->param_.GetMaxNumTer();
-  res.num_aux_ = context_->param_.alpha_;
-
-  return res;
+  return context_->param_.GetEvkNP(max_level);
 }
 
 template <typename word>
@@ -0,0 +1,179 @@
+#include "core/ConstantCache.h"
+
+#include <cstring>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+namespace {
+
+uint64_t DoubleBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// 64-bit FNV-1a hash of the bytes of the message
+uint64_t HashMessage(const std::vector<Complex> &message) {
+  const unsigned char *bytes =
+      reinterpret_cast<const unsigned char *>(message.data());
+  size_t num_bytes = message.size() * sizeof(Complex);
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  for (size_t i = 0; i < num_bytes; i++) {
+    hash ^= bytes[i];
+    hash *= UINT64_C(0x100000001b3);
+  }
+  return hash;
+}
+
+}  // namespace
+
+template <typename word>
+ConstantCache<word>::ConstantCache(const Encoder<word> &encoder,
+                                   int max_constants,
+                                   int64_t max_plaintext_words)
+    : encoder_{encoder},
+      max_constants_{max_constants},
+      max_plaintext_words_{max_plaintext_words} {
+  AssertTrue(max_constants >= 0 && max_plaintext_words >= 0,
+             "ConstantCache: Invalid capacity");
+}
+
+template <typename word>
+void ConstantCache<word>::EncodeConstant(Constant<word> &constant, int level,
+                                         double scale, double number,
+                                         int num_aux /*= 0*/) const {
+  ConstantKey key{DoubleBits(number), level, DoubleBits(scale), num_aux};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = constants_.find(key);
+    if (found != constants_.end()) {
+      constant_stats_.hits++;
+      const Constant<word> &cached = found->second.constant;
+      constant_lru_.splice(constant_lru_.begin(), constant_lru_,
+                           found->second.lru_it);
+      constant.ModifyNP(cached.GetNP());
+      constant.SetScale(cached.GetScale());
+      CopyDeviceToDevice(constant.cx_, cached.cx_);
+      return;
+    }
+    constant_stats_.misses++;
+  }
+
+  // Encode without holding the lock
+  encoder_.EncodeConstant(constant, level, scale, number, num_aux);
+  Constant<word> cached(constant.GetNP());
+  cached.SetScale(constant.GetScale());
+  CopyDeviceToDevice(cached.cx_, constant.cx_);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (constants_.find(key) != constants_.end()) return;
+  constant_lru_.push_front(key);
+  constants_.try_emplace(key, ConstantEntry{std::move(cached),
+                                            constant_lru_.begin()});
+  EvictConstants();
+}
+
+template <typename word>
+std::shared_ptr<const Plaintext<word>> ConstantCache<word>::Encode(
+    int level, double scale, const std::vector<Complex> &message,
+    int num_aux /*= 0*/) const {
+  PlaintextKey key{HashMessage(message), static_cast<int>(message.size()),
+                   level, DoubleBits(scale), num_aux};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = plaintexts_.find(key);
+    if (found != plaintexts_.end() &&
+        std::memcmp(found->second.message.data(), message.data(),
+                    message.size() * sizeof(Complex)) == 0) {
+      plaintext_stats_.hits++;
+      plaintext_lru_.splice(plaintext_lru_.begin(), plaintext_lru_,
+                            found->second.lru_it);
+      return found->second.ptxt;
+    }
+    plaintext_stats_.misses++;
+  }
+
+  // Encode without holding the lock
+  auto ptxt = std::make_shared<Plaintext<word>>();
+  encoder_.Encode(*ptxt, level, scale, message, num_aux);
+  int64_t num_words = ptxt->mx_.size();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_words > max_plaintext_words_) return ptxt;
+  auto found = plaintexts_.find(key);
+  if (found != plaintexts_.end()) {
+    // A hash collision (or a concurrent insertion); keep the newer one.
+    plaintext_words_ -= found->second.num_words;
+    plaintext_lru_.erase(found->second.lru_it);
+    plaintexts_.erase(found);
+  }
+  plaintext_lru_.push_front(key);
+  plaintexts_.try_emplace(key, PlaintextEntry{message, ptxt, num_words,
+                                              plaintext_lru_.begin()});
+  plaintext_words_ += num_words;
+  EvictPlaintexts();
+  return ptxt;
+}
+
+template <typename word>
+typename ConstantCache<word>::Stats ConstantCache<word>::GetConstantStats()
+    const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return constant_stats_;
+}
+
+template <typename word>
+typename ConstantCache<word>::Stats ConstantCache<word>::GetPlaintextStats()
+    const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return plaintext_stats_;
+}
+
+template <typename word>
+void ConstantCache<word>::SetCapacity(int max_constants,
+                                      int64_t max_plaintext_words) {
+  AssertTrue(max_constants >= 0 && max_plaintext_words >= 0,
+             "ConstantCache: Invalid capacity");
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_constants_ = max_constants;
+  max_plaintext_words_ = max_plaintext_words;
+  EvictConstants();
+  EvictPlaintexts();
+}
+
+template <typename word>
+void ConstantCache<word>::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  constants_.clear();
+  constant_lru_.clear();
+  plaintexts_.clear();
+  plaintext_lru_.clear();
+  plaintext_words_ = 0;
+}
+
+template <typename word>
+void ConstantCache<word>::EvictConstants() const {
+  while (static_cast<int>(constants_.size()) > max_constants_) {
+    constants_.erase(constant_lru_.back());
+    constant_lru_.pop_back();
+    constant_stats_.evictions++;
+  }
+}
+
+template <typename word>
+void ConstantCache<word>::EvictPlaintexts() const {
+  while (plaintext_words_ > max_plaintext_words_) {
+    auto found = plaintexts_.find(plaintext_lru_.back());
+    plaintext_words_ -= found->second.num_words;
+    plaintexts_.erase(found);
+    plaintext_lru_.pop_back();
+    plaintext_stats_.evictions++;
+  }
+}
+
+template class ConstantCache<uint32_t>;
+template class ConstantCache<uint64_t>;
+
+}  // namespace cheddar
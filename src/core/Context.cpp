@@ -1,8 +1,13 @@
 #include "core/Context.h"
 
+#include <cmath>
+#include <utility>
+
 #include "common/Assert.h"
 #include "common/CommonUtils.h"
 #include "common/PrimeUtils.h"
+#include "core/EvkMap.h"
+#include "core/Workspace.h"
 
 namespace cheddar {
 
@@ -50,6 +55,79 @@ const ModSwitchHandler<word> &Context<word>::GetStDModSwitchHandler() const {
   return mod_switch_handlers_.at(param_.max_level_);
 }
 
+template <typename word>
+size_t Context<word>::GetKeySwitchBytes(const Parameter<word> &param) {
+  // See MultKeyNoModDown and MultKey
+  NPInfo np = param.LevelToNP(param.max_level_);
+  int prime_offset = param.GetMaxNumTer() - np.num_ter_;
+  int padded_num_q = np.GetNumQ() + prime_offset;
+  int beta = DivCeil(padded_num_q, param.alpha_);
+  size_t num_mod_up = 0;
+  for (int i = 0; i < beta; i++) {
+    if (Min((i + 1) * param.alpha_, padded_num_q) > prime_offset) num_mod_up++;
+  }
+  size_t num_q = np.GetNumQ();
+  size_t alpha = param.alpha_;
+  size_t degree = param.degree_;
+  size_t mod_up_size = num_mod_up * (num_q + alpha) * degree;
+  size_t accum_size = 2 * (num_q + alpha) * degree;
+  // ModUp takes an INTT buffer of num_q primes before accum is allocated.
+  size_t mod_up_phase = mod_up_size + Max(num_q * degree, accum_size);
+  // ModDown takes an INTT buffer of alpha primes, and the result of MultKey
+  // is kept for Permute (HRot).
+  size_t mod_down_phase = accum_size + 2 * num_q * degree + alpha * degree;
+  return Max(mod_up_phase, mod_down_phase) * sizeof(word);
+}
+
+template <typename word>
+MemoryFootprint Context<word>::EstimateMemoryFootprint(
+    const Parameter<word> &param, const EvkRequest &evk_request /*= {}*/) {
+  MemoryFootprint res;
+  bool sse = param.IsUsingSparseSecretEncapsulation();
+  res.twiddle_bytes = NTTHandler<word>::GetTableBytes(param);
+  for (int level = (sse ? -1 : 0); level <= param.max_level_; level++) {
+    res.mod_switch_bytes +=
+        ModSwitchHandler<word>::GetConstantBytes(param, level);
+  }
+
+  // See ContextTables and MultiLevelCiphertext::StaticInit
+  size_t other_table_size =
+      param.LevelToNP(param.max_level_, param.alpha_).GetNumQ();
+  for (int level = 1; level < param.max_level_; level++) {
+    other_table_size += param.LevelToNP(level).GetNumQ();
+  }
+  if (sse) {
+    for (int level = 1; level <= param.default_encryption_level_; level++) {
+      other_table_size += param.LevelToNP(level).GetNumQ();
+    }
+    other_table_size += param.LevelToNP(-1, param.GetSSENumAux()).GetNumQ();
+  }
+  res.other_table_bytes = other_table_size * sizeof(word);
+
+  // See UserInterface::PrepareEvk
+  auto evk_bytes = [&](int max_level) {
+    NPInfo np = param.GetEvkNP(max_level);
+    size_t beta = DivCeil(np.GetNumQ(), np.num_aux_);
+    return 2 * beta * np.GetNumTotal() * param.degree_ * sizeof(word);
+  };
+  res.evk_bytes[EvkMap<word>::kMultiplicationKeyIndex] =
+      evk_bytes(param.max_level_);
+  res.evk_bytes[EvkMap<word>::kConjugationKeyIndex] =
+      evk_bytes(param.max_level_);
+  if (sse) {
+    res.evk_bytes[EvkMap<word>::kDenseToSparseKeyIndex] = evk_bytes(-1);
+    res.evk_bytes[EvkMap<word>::kSparseToDenseKeyIndex] =
+        evk_bytes(param.max_level_);
+  }
+  for (const auto &[rot_idx, level] : evk_request) {
+    if (rot_idx == 0) continue;
+    res.evk_bytes[Abs(rot_idx)] = evk_bytes(level);
+  }
+
+  res.peak_temporary_bytes = GetKeySwitchBytes(param);
+  return res;
+}
+
 template <typename word>
 void Context<word>::AssertSameScale(const double &scale1,
                                     const double &scale2) const {
@@ -61,16 +139,21 @@ void Context<word>::AssertSameScale(const double &scale1,
 
 template <typename word>
 std::shared_ptr<Context<word>> Context<word>::Create(
-    const Parameter<word> &param) {
-  return std::shared_ptr<Context<word>>(new Context<word>(param));
+    const Parameter<word> &param, TableCache *tables /*= nullptr*/,
+    const MemoryBinConfig *bin_config /*= nullptr*/) {
+  return std::shared_ptr<Context<word>>(
+      new Context<word>(param, tables, bin_config));
 }
 
 template <typename word>
-Context<word>::Context(const Parameter<word> &param)
+ContextTables<word>::ContextTables(const Parameter<word> &param,
+                                   TableCache *tables /*= nullptr*/,
+                                   const MemoryBinConfig *bin_config
+                                   /*= nullptr*/)
     : param_{param},
-      memory_pool_(param_),
+      memory_pool_(param_, bin_config),
       elem_handler_(param_),
-      ntt_handler_(param_),
+      ntt_handler_(param_, tables),
       encoder_(param_, ntt_handler_) {
   // 0. Set some static variables
   Container<word>::SetDegree(param_.degree_);
@@ -124,10 +207,61 @@ Context<word>::Context(const Parameter<word> &param)
 }
 
 template <typename word>
-Context<word>::~Context() {
+ContextTables<word>::~ContextTables() {
   MultiLevelCiphertext<word>::StaticDestroy();
 }
 
+template <typename word>
+Context<word>::Context(const Parameter<word> &param,
+                       TableCache *tables /*= nullptr*/,
+                       const MemoryBinConfig *bin_config /*= nullptr*/)
+    : Context(std::make_shared<const ContextTables<word>>(param, tables,
+                                                          bin_config)) {}
+
+template <typename word>
+Context<word>::Context(std::shared_ptr<const ContextTables<word>> tables)
+    : tables_{std::move(tables)},
+      param_{tables_->param_},
+      elem_handler_{tables_->elem_handler_},
+      ntt_handler_{tables_->ntt_handler_},
+      mod_switch_handlers_{tables_->mod_switch_handlers_},
+      encoder_{tables_->encoder_},
+      constant_cache_(encoder_),
+      p_prod_{tables_->p_prod_},
+      p_prod_dts_{tables_->p_prod_dts_},
+      level_down_consts_{tables_->level_down_consts_} {}
+
+template <typename word>
+Context<word>::~Context() = default;
+
+template <typename word>
+MemoryPoolStats Context<word>::GetMemoryStats() const {
+  CheckTrue(tables_->memory_pool_.IsCurrent(),
+            "GetMemoryStats: The memory pool of a newer Context is in use, "
+            "so the recent allocations are not counted");
+  return tables_->memory_pool_.GetStats();
+}
+
+template <typename word>
+void Context<word>::ResetPeakMemoryStats() const {
+  tables_->memory_pool_.ResetPeakStats();
+}
+
+template <typename word>
+void Context<word>::DumpMemoryStats(std::ostream &os) const {
+  GetMemoryStats().Dump(os);
+}
+
+template <typename word>
+void Context<word>::StartMemoryTrace() const {
+  tables_->memory_pool_.StartTrace();
+}
+
+template <typename word>
+MemoryTrace Context<word>::StopMemoryTrace() const {
+  return tables_->memory_pool_.StopTrace();
+}
+
 template <typename word>
 void Context<word>::Copy(Ct &res, const Ct &a) const {
   if (&res == &a) return;
@@ -384,9 +518,11 @@ void Context<word>::MultUnsafe(Ct &res, const Ct &a, const Ct &b,
 
   // In-place operation are not possible if the levels are different
   if ((&res == &a && a_level != level) || (&res == &b && b_level != level)) {
-    Ct tmp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &tmp = scope.TakeCt();
     MultUnsafe(tmp, a, b, level);
-    res = std::move(tmp);
+    // The previous buffers of res are given back instead
+    std::swap(res, tmp);
     return;
   }
 
@@ -423,9 +559,10 @@ void Context<word>::MultUnsafe(Ct &res, const Ct &a, const Pt &b,
 
   // In-place operation are not possible if the levels are different
   if (&res == &a && a_level != level) {
-    Ct tmp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &tmp = scope.TakeCt();
     MultUnsafe(tmp, a, b, level);
-    res = std::move(tmp);
+    std::swap(res, tmp);
     return;
   }
 
@@ -467,9 +604,10 @@ void Context<word>::MultUnsafe(Ct &res, const Ct &a, const Const &b,
 
   // In-place operation are not possible if the levels are different
   if (&res == &a && a_level != level) {
-    Ct tmp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &tmp = scope.TakeCt();
     MultUnsafe(tmp, a, b, level);
-    res = std::move(tmp);
+    std::swap(res, tmp);
     return;
   }
 
@@ -510,9 +648,10 @@ void Context<word>::Permute(Ct &res, const Ct &a, int rot_dist) const {
   }
   // in-place operation is not supported
   if (&res == &a) {
-    Ct tmp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &tmp = scope.TakeCt();
     Permute(tmp, a, rot_idx);
-    res = std::move(tmp);
+    std::swap(res, tmp);
     return;
   }
 
@@ -531,9 +670,10 @@ void Context<word>::PermuteConjugate(Ct &res, const Ct &a) const {
   static constexpr int conj_rot_idx = -1;
   // in-place operation is not supported
   if (&res == &a) {
-    Ct tmp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &tmp = scope.TakeCt();
     PermuteConjugate(tmp, a);
-    res = std::move(tmp);
+    std::swap(res, tmp);
     return;
   }
 
@@ -591,7 +731,8 @@ void Context<word>::MultKey(Ct &res, const Ct &a, const Evk &key) const {
   const auto &mod_switcher =
       level == -1 ? GetDtSModSwitchHandler() : mod_switch_handlers_.at(level);
 
-  Ct accum;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &accum = scope.TakeCt();
   MultKeyNoModDown(accum, a, key);
 
   // Prepare result
@@ -667,18 +808,18 @@ void Context<word>::MultKeyNoModDown(Ct &accum, const Ct &a,
       level == -1 ? GetDtSModSwitchHandler() : mod_switch_handlers_.at(level);
 
   // Mod-up result preparation
-  std::vector<Dv> mod_up_result;
-  std::vector<DvView<word>> mod_up_result_view;
+  std::vector<int> mod_up_sizes;
   for (int i = 0; i < beta; i++) {
     int prime_index_end = Min((i + 1) * num_aux, padded_num_q);
-    if (prime_index_end <= prime_offset) {
-      mod_up_result.emplace_back(0);
-      mod_up_result_view.push_back(mod_up_result[i].View(0));
-    } else {
-      mod_up_result.emplace_back((num_q + num_aux) * param_.degree_);
-      mod_up_result_view.push_back(
-          mod_up_result[i].View(num_aux * param_.degree_));
-    }
+    bool skipped = (prime_index_end <= prime_offset);
+    mod_up_sizes.push_back(skipped ? 0 : (num_q + num_aux) * param_.degree_);
+  }
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  std::vector<Dv> &mod_up_result = scope.TakeDvs(mod_up_sizes);
+  std::vector<DvView<word>> mod_up_result_view;
+  for (int i = 0; i < beta; i++) {
+    int front_size = (mod_up_sizes[i] == 0) ? 0 : num_aux * param_.degree_;
+    mod_up_result_view.push_back(mod_up_result[i].View(front_size));
   }
 
   DvConstView<word> p_prod =
@@ -718,7 +859,8 @@ void Context<word>::RelinearizeRescale(Ct &res, const Ct &a,
 
   int level = param_.NPToLevel(a.GetNP());
 
-  Ct accum;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &accum = scope.TakeCt();
   MultKeyNoModDown(accum, a, key);
 
   // Prepare result
@@ -740,9 +882,10 @@ template <typename word>
 void Context<word>::Rescale(Ct &res, const Ct &a) const {
   if (&res == &a) {
     Warn("Rescale is not adequate for in-place operations");
-    Ct temp;
+    typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+    Ct &temp = scope.TakeCt();
     Rescale(temp, a);
-    res = std::move(temp);
+    std::swap(res, temp);
     return;
   }
   AssertTrue(a.GetNP().num_aux_ == 0,
@@ -785,14 +928,16 @@ void Context<word>::HRot(Ct &res, const Ct &a, const Evk &rot_key,
     return;
   }
 
-  Ct tmp;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &tmp = scope.TakeCt();
   MultKey(tmp, a, rot_key);
   Permute(res, tmp, rot_dist);
 }
 
 template <typename word>
 void Context<word>::HConj(Ct &res, const Ct &a, const Evk &conj_key) const {
-  Ct tmp;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &tmp = scope.TakeCt();
   MultKey(tmp, a, conj_key);
   PermuteConjugate(res, tmp);
 }
@@ -813,7 +958,8 @@ void Context<word>::HRotAdd(Ct &res, const Ct &a, const Ct &b,
     return;
   }
 
-  Ct tmp;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &tmp = scope.TakeCt();
   MultKey(tmp, a, rot_key);
 
   NPInfo np = a.GetNP();
@@ -841,7 +987,8 @@ void Context<word>::HConjAdd(Ct &res, const Ct &a, const Ct &b,
   res.SetNumSlots(num_slots);
   res.SetScale(a.GetScale());
 
-  Ct tmp;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &tmp = scope.TakeCt();
   MultKey(tmp, a, conj_key);
 
   NPInfo np = a.GetNP();
@@ -915,7 +1062,9 @@ void Context<word>::MadUnsafe(Ct &res, const Ct &a, const Const &b) const {
 
 template <typename word>
 void Context<word>::LevelDown(Ct &res, const Ct &a, int target_level) const {
-  Ct mult_temp, next;
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  Ct &mult_temp = scope.TakeCt();
+  Ct &next = scope.TakeCt();
   int level = param_.NPToLevel(a.GetNP());
   const Ct *prev_res = &a;
   AssertTrue(level >= target_level, "Invalid target level for LevelDown");
@@ -927,6 +1076,83 @@ void Context<word>::LevelDown(Ct &res, const Ct &a, int target_level) const {
   Copy(res, *prev_res);
 }
 
+template <typename word>
+void Context<word>::Compact(Ct &res, const Ct &a, double precision_bits,
+                            double max_abs_message /*= 1.0*/,
+                            bool drop_limbs /*= true*/) const {
+  AssertTrue(!a.HasRx(), "Compact: Rx should be removed before compaction");
+  AssertTrue(a.GetNP().num_aux_ == 0, "Compact: ModDown required");
+  AssertTrue(max_abs_message > 0, "Compact: Invalid message bound");
+
+  auto log_modulus = [&](const NPInfo &np) {
+    double res = 0;
+    for (word prime : param_.GetPrimeVector(np)) res += std::log2(prime);
+    return res;
+  };
+  // Decryption is correct as long as |scale * message + error| < Q / 2. One
+  // more bit is reserved for the error.
+  auto fits = [&](const NPInfo &np, double scale) {
+    return log_modulus(np) >= std::log2(scale * max_abs_message) + 2;
+  };
+  // The rescaling error of a slot is a sum of degree terms of variance
+  // (h + 1) / 12, for the Hamming weight h of the secret. We take 6 sigma.
+  double noise_bits =
+      std::log2(6.0) +
+      0.5 * std::log2(param_.degree_ *
+                      (param_.GetDenseHammingWeight() + 1.0) / 12.0);
+
+  // 1. Level down (with rescaling) as long as the precision is kept.
+  int level = param_.NPToLevel(a.GetNP());
+  int target_level = level;
+  double target_scale = a.GetScale();
+  if (level > 0 && level < static_cast<int>(level_down_consts_.size())) {
+    double scale = a.GetScale();
+    for (int i = level; i > 0; i--) {
+      scale *= param_.GetScale(i) / param_.GetRescalePrimeProd(i);
+      if (std::log2(scale) - noise_bits < precision_bits ||
+          !fits(param_.LevelToNP(i - 1), scale)) {
+        break;
+      }
+      target_level = i - 1;
+      target_scale = scale;
+    }
+  }
+  if (target_level < level || !drop_limbs) {
+    LevelDown(res, a, target_level);
+  }
+  if (!drop_limbs) return;
+  const Ct &src = (target_level < level) ? res : a;
+
+  // 2. Drop the limbs not needed for decryption. The primes of a lower level
+  // (of at most as many terminal and main primes) are a contiguous range of
+  // the primes of the source, as in MultiLevelPlaintext.
+  NPInfo src_np = src.GetNP();
+  NPInfo np = src_np;
+  for (int i = -1; i < target_level; i++) {
+    NPInfo candidate = param_.LevelToNP(i);
+    if (candidate.num_main_ <= src_np.num_main_ &&
+        candidate.num_ter_ <= src_np.num_ter_ &&
+        candidate.GetNumTotal() < np.GetNumTotal() &&
+        fits(candidate, target_scale)) {
+      np = candidate;
+      break;
+    }
+  }
+
+  int degree = param_.degree_;
+  int offset = (src_np.num_ter_ - np.num_ter_) * degree;
+  Ct trimmed(np);
+  trimmed.SetScale(src.GetScale());
+  trimmed.SetNumSlots(src.GetNumSlots());
+  cudaMemcpyAsync(trimmed.bx_.data(), src.bx_.data() + offset,
+                  trimmed.bx_.size() * sizeof(word), cudaMemcpyDeviceToDevice,
+                  trimmed.bx_.stream());
+  cudaMemcpyAsync(trimmed.ax_.data(), src.ax_.data() + offset,
+                  trimmed.ax_.size() * sizeof(word), cudaMemcpyDeviceToDevice,
+                  trimmed.ax_.stream());
+  res = std::move(trimmed);
+}
+
 template <typename word>
 void Context<word>::AddLowerLevelsUntil(MultiLevelCiphertext<word> &ml_ct,
                                         int min_level) const {
@@ -948,6 +1174,8 @@ void Context<word>::AddLowerLevelsUntil(MultiLevelCiphertext<word> &ml_ct,
   }
 }
 
+template struct ContextTables<uint32_t>;
+template struct ContextTables<uint64_t>;
 template class Context<uint32_t>;
 template class Context<uint64_t>;
 
@@ -0,0 +1,26 @@
+#include "core/ContextFactory.h"
+
+namespace cheddar {
+
+template <typename word>
+ContextFactory<word>::ContextFactory(const Parameter<word> &param,
+                                     TableCache *tables /*= nullptr*/,
+                                     const MemoryBinConfig *bin_config
+                                     /*= nullptr*/)
+    : tables_{std::make_shared<const ContextTables<word>>(param, tables,
+                                                          bin_config)} {}
+
+template <typename word>
+std::shared_ptr<Context<word>> ContextFactory<word>::Create() const {
+  return std::shared_ptr<Context<word>>(new Context<word>(tables_));
+}
+
+template <typename word>
+int ContextFactory<word>::GetNumContexts() const {
+  return tables_.use_count() - 1;
+}
+
+template class ContextFactory<uint32_t>;
+template class ContextFactory<uint64_t>;
+
+}  // namespace cheddar
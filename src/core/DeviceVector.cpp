@@ -101,9 +101,22 @@ DvConstView<word> DeviceVector<word>::ConstView(
 
 template <typename word>
 void CopyHostToDevice(DeviceVector<word> &dst, const HostVector<word> &src) {
+  CopyHostToDeviceAsync(dst, src);
+#ifndef USE_CPU_BACKEND
+  // A copy from pinned memory is not staged, so src is read until it is done.
+  if (HostStagingPool::Global().IsPinned()) cudaStreamSynchronize(dst.stream());
+#endif
+}
+
+template <typename word>
+void CopyHostToDeviceAsync(DeviceVector<word> &dst,
+                           const HostVector<word> &src) {
   dst.resize(src.size());
   cudaMemcpyAsync(dst.data(), src.data(), src.size() * sizeof(word),
                   cudaMemcpyHostToDevice, dst.stream());
+#ifndef USE_CPU_BACKEND
+  HostStagingPool::Global().RecordTransfer(src.data(), dst.stream());
+#endif
 }
 
 template <typename word>
@@ -111,6 +124,10 @@ void CopyDeviceToHost(HostVector<word> &dst, const DeviceVector<word> &src) {
   dst.resize(src.size());
   cudaMemcpyAsync(dst.data(), src.data(), src.size() * sizeof(word),
                   cudaMemcpyDeviceToHost, src.stream());
+#ifndef USE_CPU_BACKEND
+  // Unlike a copy to pageable memory, a copy to pinned memory does not block.
+  if (HostStagingPool::Global().IsPinned()) cudaStreamSynchronize(src.stream());
+#endif
 }
 
 template <typename word>
@@ -167,6 +184,22 @@ template void CopyHostToDevice(DeviceVector<const uint32_t *> &dst,
                                const HostVector<const uint32_t *> &src);
 template void CopyHostToDevice(DeviceVector<const uint64_t *> &dst,
                                const HostVector<const uint64_t *> &src);
+template void CopyHostToDeviceAsync(DeviceVector<int32_t> &dst,
+                                    const HostVector<int32_t> &src);
+template void CopyHostToDeviceAsync(DeviceVector<int64_t> &dst,
+                                    const HostVector<int64_t> &src);
+template void CopyHostToDeviceAsync(DeviceVector<uint32_t> &dst,
+                                    const HostVector<uint32_t> &src);
+template void CopyHostToDeviceAsync(DeviceVector<uint64_t> &dst,
+                                    const HostVector<uint64_t> &src);
+template void CopyHostToDeviceAsync(DeviceVector<uint32_t *> &dst,
+                                    const HostVector<uint32_t *> &src);
+template void CopyHostToDeviceAsync(DeviceVector<uint64_t *> &dst,
+                                    const HostVector<uint64_t *> &src);
+template void CopyHostToDeviceAsync(DeviceVector<const uint32_t *> &dst,
+                                    const HostVector<const uint32_t *> &src);
+template void CopyHostToDeviceAsync(DeviceVector<const uint64_t *> &dst,
+                                    const HostVector<const uint64_t *> &src);
 template void CopyDeviceToHost(HostVector<int32_t> &dst,
                                const DeviceVector<int32_t> &src);
 template void CopyDeviceToHost(HostVector<int64_t> &dst,
@@ -0,0 +1,1246 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "common/AlignedAllocator.h"
+#include "common/Assert.h"
+#include "common/BasicSimd.h"
+#include "common/CommonUtils.h"
+#include "common/ConstantMemory.cuh"
+#include "common/DoubleWord.h"
+#include "common/PtrList.h"
+#include "common/ThreadPool.h"
+#include "core/ElementWise.h"
+
+namespace {
+// https://artificial-mind.net/blog/2020/10/31/constexpr-for
+template <int Start, int End, int Inc = 1, class Func>
+constexpr void constexpr_for(Func &&func) {
+  if constexpr (Start < End) {
+    func(std::integral_constant<decltype(Start), Start>());
+    constexpr_for<Start + Inc, End, Inc>(std::forward<Func>(func));
+  }
+}
+}  // namespace
+
+namespace cheddar {
+namespace kernel {
+
+// ----- ElementWise functions (host) ----- //
+
+// Host counterparts of the kernels in ElementWise.cu. The work is split into
+// (polynomial, limb, coefficient tile) tasks that run on the global
+// ThreadPool, and every task works on its tile with the array operations of
+// basic::simd. The extra_ offsets of the pointer lists are applied to the
+// auxiliary limbs only, exactly as in the CUDA kernels.
+//
+// As in the CUDA kernels, every output coefficient only depends on the inputs
+// at the same position (or on permuted sources, which never alias dst), so
+// dst may alias any of the other sources. basic::simd allows this, and
+// accumulations of more than two operands go through a tile-local buffer so
+// that no source is overwritten before it is read.
+
+namespace {
+
+// Number of coefficients handled by a single task. A tile of a few operands
+// fits in L1/L2, and there are still enough tasks to keep all threads busy.
+constexpr int kTileSize = 2048;
+
+/**
+ * @brief Calls func(j, prime_index, begin, end) for every coefficient tile
+ * [begin, end) of limb prime_index of polynomial j, for all j < num_poly and
+ * prime_index < num_primes, in parallel.
+ */
+template <typename Func>
+void ForEachTile(int num_poly, int num_primes, Func &&func) {
+  int degree = cm_degree();
+  int tile_size = std::min(degree, kTileSize);
+  int num_tiles = degree / tile_size;
+  ThreadPool::Global().ParallelFor(
+      0, num_poly * num_primes * num_tiles, [&](int i) {
+        int tile = i % num_tiles;
+        int limb = i / num_tiles;
+        func(limb / num_primes, limb % num_primes, tile * tile_size,
+             (tile + 1) * tile_size);
+      });
+}
+
+// ----- Tile functions ----- //
+
+// dst = src[indices]
+template <typename word>
+CHEDDAR_HOST_TARGET_CLONES void GatherTile(word *dst, const word *src,
+                                           const int *indices, int n) {
+#pragma GCC ivdep
+  for (int x = 0; x < n; x++) {
+    dst[x] = src[indices[x]];
+  }
+}
+
+template <typename word>
+void TensorTile(word *dst_bx, word *dst_ax, word *dst_rx, const word *src1_bx,
+                const word *src1_ax, const word *src2_bx, const word *src2_ax,
+                int n, const basic::Modulus<word> &mod) {
+  alignas(kHostAlignment) word b1_plus_a1[kTileSize];
+  alignas(kHostAlignment) word b2_plus_a2[kTileSize];
+  alignas(kHostAlignment) word b1_times_b2[kTileSize];
+  alignas(kHostAlignment) word a1_times_a2[kTileSize];
+
+  // karatsuba multiplication
+  basic::simd::Add(b1_plus_a1, src1_bx, src1_ax, n, mod);
+  basic::simd::Add(b2_plus_a2, src2_bx, src2_ax, n, mod);
+  basic::simd::MultMontgomery(b1_times_b2, src1_bx, src2_bx, n, mod);
+  basic::simd::MultMontgomery(a1_times_a2, src1_ax, src2_ax, n, mod);
+  // The sources are all read by now, so dst may alias them.
+  basic::simd::MultMontgomery(dst_ax, b1_plus_a1, b2_plus_a2, n, mod);
+  basic::simd::Sub(dst_ax, dst_ax, b1_times_b2, n, mod);
+  basic::simd::Sub(dst_ax, dst_ax, a1_times_a2, n, mod);
+  std::memcpy(dst_bx, b1_times_b2, n * sizeof(word));
+  std::memcpy(dst_rx, a1_times_a2, n * sizeof(word));
+}
+
+template <typename word>
+void TensorSquareTile(word *dst_bx, word *dst_ax, word *dst_rx,
+                      const word *src1_bx, const word *src1_ax, int n,
+                      const basic::Modulus<word> &mod) {
+  alignas(kHostAlignment) word b1_times_b1[kTileSize];
+  alignas(kHostAlignment) word b1_times_a1[kTileSize];
+  basic::simd::MultMontgomery(b1_times_b1, src1_bx, src1_bx, n, mod);
+  basic::simd::MultMontgomery(b1_times_a1, src1_bx, src1_ax, n, mod);
+  basic::simd::MultMontgomery(dst_rx, src1_ax, src1_ax, n, mod);
+  basic::simd::Add(dst_ax, b1_times_a1, b1_times_a1, n, mod);
+  std::memcpy(dst_bx, b1_times_b1, n * sizeof(word));
+}
+
+}  // namespace
+
+// dst = src_1 + src_2 + ... + src_last;
+template <typename word, int num_poly>
+void Sum(OutputPtrList<word, num_poly> dst, const word *primes,
+         int num_q_primes, int num_primes,
+         const std::vector<InputPtrList<word, num_poly>> &srcs) {
+  int degree = cm_degree();
+  int num_srcs = srcs.size();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    const basic::Modulus<word> &mod = moduli[prime_index];
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int n = end - begin;
+    auto src_tile = [&](int k) {
+      return srcs[k].ptrs_[j] + offset + (aux_part ? srcs[k].extra_ : 0);
+    };
+    word *dst_tile = dst.ptrs_[j] + offset;
+    if (num_srcs == 2) {
+      basic::simd::Add(dst_tile, src_tile(0), src_tile(1), n, mod);
+      return;
+    }
+    alignas(kHostAlignment) word acc[kTileSize];
+    basic::simd::Add(acc, src_tile(0), src_tile(1), n, mod);
+    for (int k = 2; k < num_srcs; k++) {
+      basic::simd::Add(acc, acc, src_tile(k), n, mod);
+    }
+    std::memcpy(dst_tile, acc, n * sizeof(word));
+  });
+}
+
+// dst = src_1 - src_2;
+template <typename word, int num_poly>
+void Sub(OutputPtrList<word, num_poly> dst, const word *primes,
+         int num_q_primes, int num_primes,
+         const InputPtrList<word, num_poly> src1,
+         const InputPtrList<word, num_poly> src2) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src1_offset = offset + (aux_part ? src1.extra_ : 0);
+    int src2_offset = offset + (aux_part ? src2.extra_ : 0);
+    basic::simd::Sub(dst.ptrs_[j] + offset, src1.ptrs_[j] + src1_offset,
+                     src2.ptrs_[j] + src2_offset, end - begin,
+                     moduli[prime_index]);
+  });
+}
+
+// dst = -src;
+template <typename word, int num_poly>
+void Neg(OutputPtrList<word, num_poly> dst, const word *primes,
+         int num_q_primes, int num_primes,
+         const InputPtrList<word, num_poly> src) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src_offset = offset + (aux_part ? src.extra_ : 0);
+    basic::simd::Negate(dst.ptrs_[j] + offset, src.ptrs_[j] + src_offset,
+                        end - begin, moduli[prime_index]);
+  });
+}
+
+// dst = src_1 * src_2;
+template <typename word, int num_poly>
+void Mult(OutputPtrList<word, num_poly> dst, const word *primes,
+          int num_q_primes, int num_primes,
+          const InputPtrList<word, num_poly> src1,
+          const InputPtrList<word, num_poly> src2) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src1_offset = offset + (aux_part ? src1.extra_ : 0);
+    int src2_offset = offset + (aux_part ? src2.extra_ : 0);
+    basic::simd::MultMontgomery(dst.ptrs_[j] + offset,
+                                src1.ptrs_[j] + src1_offset,
+                                src2.ptrs_[j] + src2_offset, end - begin,
+                                moduli[prime_index]);
+  });
+}
+
+enum class ConstOp { Add, Sub, SubOpposite };
+
+// dst = src + const_src, src - const_src, or const_src - src;
+template <typename word, int num_poly, ConstOp op>
+void ConstArith(OutputPtrList<word, num_poly> dst, const word *primes,
+                int num_q_primes, int num_primes,
+                const InputPtrList<word, num_poly> src,
+                const InputPtrList<word, 1> const_src) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src_offset = offset + (aux_part ? src.extra_ : 0);
+    int const_src_index = prime_index + (aux_part ? const_src.extra_ : 0);
+    word *dst_tile = dst.ptrs_[j] + offset;
+    const word *src_tile = src.ptrs_[j] + src_offset;
+    const word const_value = const_src.ptrs_[0][const_src_index];
+    const basic::Modulus<word> &mod = moduli[prime_index];
+    if constexpr (op == ConstOp::Add) {
+      basic::simd::AddConst(dst_tile, src_tile, const_value, end - begin, mod);
+    } else if constexpr (op == ConstOp::Sub) {
+      basic::simd::SubConst(dst_tile, src_tile, const_value, end - begin, mod);
+    } else {
+      basic::simd::SubOppositeConst(dst_tile, src_tile, const_value,
+                                    end - begin, mod);
+    }
+  });
+}
+
+// CAccum/PAccum, optionally with src0 (CPAccumAdd in ElementWise.cu)
+// dst = src0 + common_1 * src_1 + ... + common_last * src_last;
+template <typename word, int num_poly, bool const_accum>
+void CPAccum(OutputPtrList<word, num_poly> dst, const word *primes,
+             int num_q_primes, int num_primes,
+             const InputPtrList<word, num_poly> *src0,
+             const std::vector<CPAccumInputPtrList<word, num_poly>> &srcs) {
+  int degree = cm_degree();
+  int num_srcs = srcs.size();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    const basic::Modulus<word> &mod = moduli[prime_index];
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int n = end - begin;
+    word *dst_tile = dst.ptrs_[j] + offset;
+
+    // acc (+)= common_k * src_k
+    auto accumulate = [&](word *acc, int k, bool first) {
+      const auto &src = srcs[k];
+      const word *src_tile = src.ptrs_[j] + offset + (aux_part ? src.extra_ : 0);
+      // CAccum vs. PAccum
+      int common_index = const_accum ? prime_index : offset;
+      if (aux_part) common_index += src.common_extra_;
+      if constexpr (const_accum) {
+        const word common_value = src.common_ptr_[common_index];
+        if (first) {
+          basic::simd::MultMontgomeryConst(acc, src_tile, common_value, n,
+                                           mod);
+        } else {
+          basic::simd::MultMontgomeryConstAccum(acc, src_tile, common_value,
+                                                n, mod);
+        }
+      } else {
+        const word *common_tile = src.common_ptr_ + common_index;
+        if (first) {
+          basic::simd::MultMontgomery(acc, common_tile, src_tile, n, mod);
+        } else {
+          basic::simd::MultMontgomeryAccum(acc, common_tile, src_tile, n,
+                                           mod);
+        }
+      }
+    };
+
+    if (src0 == nullptr && num_srcs == 1) {
+      accumulate(dst_tile, 0, true);
+      return;
+    }
+    alignas(kHostAlignment) word acc[kTileSize];
+    int k = 0;
+    if (src0 != nullptr) {
+      const word *src0_tile =
+          src0->ptrs_[j] + offset + (aux_part ? src0->extra_ : 0);
+      std::memcpy(acc, src0_tile, n * sizeof(word));
+    } else {
+      accumulate(acc, k++, true);
+    }
+    for (; k < num_srcs; k++) accumulate(acc, k, false);
+    std::memcpy(dst_tile, acc, n * sizeof(word));
+  });
+}
+
+// dst = src0 + permute(src1, r1) + ... + permute(src_last, r_last);
+// src0 is optional. {src1, r1} embedded in a single PtrList
+template <typename word, int num_poly>
+void PermuteAccum(OutputPtrList<word, num_poly> dst, const word *primes,
+                  int num_q_primes, int num_primes,
+                  const InputPtrList<word, num_poly> *src0,
+                  const std::vector<PermuteInputPtrList<word, num_poly>> &srcs) {
+  int log_degree = cm_log_degree();
+  int degree = 1 << log_degree;
+  int num_srcs = srcs.size();
+  // Source indices of every permutation, shared by all limbs
+  std::vector<int> src_indices(static_cast<size_t>(num_srcs) * degree);
+  ThreadPool::Global().ParallelFor(
+      0, num_srcs * degree,
+      [&](int i) {
+        int k = i / degree;
+        uint32_t x = i % degree;
+        uint32_t x_idx_rev = basic::BitReverse(x, log_degree + 1) + 1;
+        src_indices[i] = basic::BitReverse(
+            x_idx_rev * srcs[k].galois_factor_ - 1, log_degree + 1);
+      },
+      kTileSize);
+
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int y_offset = prime_index << log_degree;
+    int n = end - begin;
+    word *dst_tile = dst.ptrs_[j] + y_offset + begin;
+    auto src_limb = [&](int k) {
+      return srcs[k].ptrs_[j] + y_offset + (aux_part ? srcs[k].extra_ : 0);
+    };
+    auto indices = [&](int k) {
+      return src_indices.data() + static_cast<size_t>(k) * degree + begin;
+    };
+
+    // Permuted sources never alias dst, so a single permutation is gathered
+    // in place.
+    if (src0 == nullptr && num_srcs == 1) {
+      GatherTile(dst_tile, src_limb(0), indices(0), n);
+      return;
+    }
+    alignas(kHostAlignment) word acc[kTileSize];
+    int k = 0;
+    if (src0 != nullptr) {
+      const word *src0_tile =
+          src0->ptrs_[j] + y_offset + begin + (aux_part ? src0->extra_ : 0);
+      std::memcpy(acc, src0_tile, n * sizeof(word));
+    } else {
+      GatherTile(acc, src_limb(k), indices(k), n);
+      k++;
+    }
+    alignas(kHostAlignment) word permuted[kTileSize];
+    for (; k < num_srcs; k++) {
+      GatherTile(permuted, src_limb(k), indices(k), n);
+      basic::simd::Add(acc, acc, permuted, n, moduli[prime_index]);
+    }
+    std::memcpy(dst_tile, acc, n * sizeof(word));
+  });
+}
+
+// (dst_bx, dst_ax, dst_rx) = (b1 * b2, b1 * a2 + a1 * b2, a1 * a2);
+template <typename word>
+void Tensor(OutputPtrList<word, 3> dst, const word *primes,
+            int num_q_primes, int num_primes, const InputPtrList<word, 2> src1,
+            const InputPtrList<word, 2> src2) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(1, num_primes, [&](int, int prime_index, int begin, int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src1_offset = offset + (aux_part ? src1.extra_ : 0);
+    int src2_offset = offset + (aux_part ? src2.extra_ : 0);
+    TensorTile(dst.ptrs_[0] + offset, dst.ptrs_[1] + offset,
+               dst.ptrs_[2] + offset, src1.ptrs_[0] + src1_offset,
+               src1.ptrs_[1] + src1_offset, src2.ptrs_[0] + src2_offset,
+               src2.ptrs_[1] + src2_offset, end - begin, moduli[prime_index]);
+  });
+}
+
+// (dst_bx, dst_ax, dst_rx) = (b1 * b1, 2 * b1 * a1, a1 * a1);
+template <typename word>
+void TensorSquare(OutputPtrList<word, 3> dst, const word *primes,
+                  int num_q_primes, int num_primes,
+                  const InputPtrList<word, 2> src1) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(1, num_primes, [&](int, int prime_index, int begin, int end) {
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree + begin;
+    int src1_offset = offset + (aux_part ? src1.extra_ : 0);
+    TensorSquareTile(dst.ptrs_[0] + offset, dst.ptrs_[1] + offset,
+                     dst.ptrs_[2] + offset, src1.ptrs_[0] + src1_offset,
+                     src1.ptrs_[1] + src1_offset, end - begin,
+                     moduli[prime_index]);
+  });
+}
+
+// Special kernels for bootstrapping
+
+template <typename word>
+void ModUpToMax1(word *dst, const word *primes, int num_primes,
+                 const word *src) {
+  int degree = cm_degree();
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(1, num_primes, [&](int, int prime_index, int begin, int end) {
+    word *dst_limb = dst + prime_index * degree;
+    basic::simd::Reduce(dst_limb + begin, src + begin, end - begin,
+                        moduli[prime_index]);
+  });
+}
+
+template <typename word>
+void ModUpToMax2(word *dst, const word *primes, int num_primes, const word q0,
+                 const word q1, const word *src) {
+  using d_word = make_double_word_t<word>;
+  using signed_d_word = make_signed_double_word_t<word>;
+
+  int degree = cm_degree();
+  signed_d_word q_prod = basic::detail::__mult_wide(q0, q1);
+  signed_d_word half_q_prod = (q_prod >> 1);
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+
+  ForEachTile(1, num_primes, [&](int, int prime_index, int begin, int end) {
+    const basic::Modulus<word> &mod = moduli[prime_index];
+    word *dst_limb = dst + prime_index * degree;
+    for (int x = begin; x < end; x++) {
+      signed_d_word res = basic::detail::__mult_wide(src[x], q1) +
+                          basic::detail::__mult_wide(src[x + degree], q0);
+
+      // res is in range [0, 2 * q0q1 - 1]
+      // convert it into (-q0q1 / 2, q0q1 / 2)
+      if (res >= q_prod) res -= q_prod;
+      if (res > half_q_prod) res -= q_prod;
+      if (res < 0) {
+        word reduced = mod.ReduceWide(static_cast<d_word>(-res));
+        dst_limb[x] = basic::Negate(reduced, mod.Value());
+      } else {
+        dst_limb[x] = mod.ReduceWide(static_cast<d_word>(res));
+      }
+    }
+  });
+}
+
+template <typename word, int num_poly>
+void MultImaginaryUnit(OutputPtrList<word, num_poly> dst, const word *primes,
+                       int num_q_primes, int num_primes,
+                       const InputPtrList<word, num_poly> src,
+                       const InputPtrList<word, 1> i_unit) {
+  int degree = cm_degree();
+  int half_degree = degree / 2;
+  std::vector<basic::Modulus<word>> moduli(primes, primes + num_primes);
+  ForEachTile(num_poly, num_primes, [&](int j, int prime_index, int begin,
+                                        int end) {
+    const basic::Modulus<word> &mod = moduli[prime_index];
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index * degree;
+    int src_offset = offset + (aux_part ? src.extra_ : 0);
+    int i_unit_index = offset + (aux_part ? i_unit.extra_ : 0);
+
+    const word psi_n_over_2 = i_unit.ptrs_[0][i_unit_index];
+    const word neg_psi_n_over_2 = mod.Value() - psi_n_over_2;
+    word *dst_limb = dst.ptrs_[j] + offset;
+    const word *src_limb = src.ptrs_[j] + src_offset;
+    // psi^(N/2) for the lower half, -psi^(N/2) for the upper half
+    int mid = std::clamp(half_degree, begin, end);
+    basic::simd::MultMontgomeryConst(dst_limb + begin, src_limb + begin,
+                                     psi_n_over_2, mid - begin, mod);
+    basic::simd::MultMontgomeryConst(dst_limb + mid, src_limb + mid,
+                                     neg_psi_n_over_2, end - mid, mod);
+  });
+}
+
+}  // namespace kernel
+
+template <typename word>
+ElementWiseHandler<word>::ElementWiseHandler(const Parameter<word> &param)
+    : param_{param} {
+  AssertTrue(param_.degree_ % kernel_block_dim_ == 0,
+             "Invalid kernel block dim");
+  if (!cm_populated_) {
+    PopulateConstantMemory(param_);
+    cm_populated_ = true;
+  }
+}
+
+template <typename word>
+void ElementWiseHandler<word>::AssertNPMatch(std::vector<DvView<word>> &dst,
+                                             const NPInfo &np) const {
+  int num_q_primes = np.num_main_ + np.num_ter_;
+  int num_total_primes = np.GetNumTotal();
+  for (const auto &dv_view : dst) {
+    AssertTrue(dv_view.QSize() == num_q_primes * param_.degree_,
+               "QSize mismatch");
+    AssertTrue(dv_view.TotalSize() == num_total_primes * param_.degree_,
+               "TotalSize mismatch");
+  }
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Add(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const std::vector<DvConstView<word>> &src2) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()) &&
+                 num_poly == static_cast<int>(src2.size()),
+             "Add: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Add: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    std::vector<InputPtrList<word, j>> src_ptr_list{src1, src2};
+    src_ptr_list[0].extra_ = src1.at(0).QSize() - q_size;
+    src_ptr_list[1].extra_ = src2.at(0).QSize() - q_size;
+
+    kernel::Sum<word, j>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                         src_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Sub(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const std::vector<DvConstView<word>> &src2) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()) &&
+                 num_poly == static_cast<int>(src2.size()),
+             "Sub: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Sub: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, j> src2_ptr_list(src2);
+    src2_ptr_list.extra_ = src2.at(0).QSize() - q_size;
+
+    kernel::Sub<word, j>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                         src1_ptr_list, src2_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Neg(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "Neg: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Neg: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+
+    kernel::Neg<word, j>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                         src1_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Mult(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const std::vector<DvConstView<word>> &src2) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()) &&
+                 num_poly == static_cast<int>(src2.size()),
+             "Mult: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Mult: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, j> src2_ptr_list(src2);
+    src2_ptr_list.extra_ = src2.at(0).QSize() - q_size;
+
+    kernel::Mult<word, j>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                          src1_ptr_list, src2_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::PMult(std::vector<DvView<word>> &dst,
+                                     const NPInfo &np,
+                                     const std::vector<DvConstView<word>> &src1,
+                                     const DvConstView<word> &src2) const {
+  CPAccumWorker<false>(dst, np, {src1}, {src2});
+}
+
+template <typename word>
+void ElementWiseHandler<word>::AddConst(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const DvConstView<word> &src_const) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "AddConst: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "AddConst: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, 1> src_const_ptr_list(src_const);
+    src_const_ptr_list.extra_ = src_const.QSize() - num_q_primes;
+
+    kernel::ConstArith<word, j, kernel::ConstOp::Add>(
+        dst_ptr_list, primes, num_q_primes, np.GetNumTotal(), src1_ptr_list,
+        src_const_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::SubConst(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const DvConstView<word> &src_const) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "SubConst: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "SubConst: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, 1> src_const_ptr_list(src_const);
+    src_const_ptr_list.extra_ = src_const.QSize() - num_q_primes;
+
+    kernel::ConstArith<word, j, kernel::ConstOp::Sub>(
+        dst_ptr_list, primes, num_q_primes, np.GetNumTotal(), src1_ptr_list,
+        src_const_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::SubOppositeConst(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const DvConstView<word> &src_const) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "SubOppositeConst: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "SubOppositeConst: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, 1> src_const_ptr_list(src_const);
+    src_const_ptr_list.extra_ = src_const.QSize() - num_q_primes;
+
+    kernel::ConstArith<word, j, kernel::ConstOp::SubOpposite>(
+        dst_ptr_list, primes, num_q_primes, np.GetNumTotal(), src1_ptr_list,
+        src_const_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::MultConst(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const DvConstView<word> &src_const) const {
+  CPAccumWorker<true>(dst, np, {src1}, {src_const});
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Tensor(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const std::vector<DvConstView<word>> &src2) const {
+  // Check the size of the vectors
+  AssertTrue(dst.size() == 3 && src1.size() == 2 && src2.size() == 2,
+             "Tensor: Invalid number of polynomials");
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  OutputPtrList<word, 3> dst_ptr_list(dst);
+  InputPtrList<word, 2> src1_ptr_list(src1);
+  src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+
+  if (src1.at(0).data() == src2.at(0).data() &&
+      src1.at(1).data() == src2.at(1).data()) {
+    kernel::TensorSquare<word>(dst_ptr_list, primes, num_q_primes,
+                               np.GetNumTotal(), src1_ptr_list);
+  } else {
+    InputPtrList<word, 2> src2_ptr_list(src2);
+    src2_ptr_list.extra_ = src2.at(0).QSize() - q_size;
+    kernel::Tensor<word>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                         src1_ptr_list, src2_ptr_list);
+  }
+}
+
+template <typename word>
+uint32_t ElementWiseHandler<word>::PermuteAmountToGaloisFactor(
+    int permute_amount) const {
+  if (permute_amount == -1) {
+    return 2 * param_.degree_ - 1;
+  }
+  AssertTrue(permute_amount >= 0 && permute_amount <= param_.degree_ / 2,
+             "Permute: Invalid permute amount");
+  return param_.GetGaloisFactor(permute_amount);
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Permute(
+    std::vector<DvView<word>> &dst, const NPInfo &np, int permute_amount,
+    const std::vector<DvConstView<word>> &src1) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "Permute: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Permute: Invalid number of polynomials");
+  for (int i = 0; i < num_poly; i++) {
+    AssertTrue(dst.at(i).data() != src1.at(i).data(),
+               "Permute does not support inplace operation");
+  }
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  auto galois_factor = PermuteAmountToGaloisFactor(permute_amount);
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    std::vector<PermuteInputPtrList<word, j>> src_ptr_list{src1};
+    src_ptr_list[0].extra_ = src1.at(0).QSize() - q_size;
+    src_ptr_list[0].galois_factor_ = galois_factor;
+
+    // A single permutation is an accumulation of one source
+    kernel::PermuteAccum<word, j>(dst_ptr_list, primes, num_q_primes,
+                                  np.GetNumTotal(), nullptr, src_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::PermuteAccum(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<int> &permute_amounts,
+    const std::vector<std::vector<DvConstView<word>>> &srcs) const {
+  if (kOptimizeAutomorphism) {
+    PermuteAccumWorker(dst, np, permute_amounts, srcs);
+    return;
+  }
+
+  // Naive repetition of Permute and add
+  int num_poly = dst.size();
+  int num_accum = permute_amounts.size();
+
+  bool has_extra_ct = (static_cast<int>(srcs.size()) == num_accum + 1);
+  AssertTrue(num_accum == static_cast<int>(srcs.size()) || has_extra_ct,
+             "PermuteAccum: Incompatible srcs/permute_amounts size");
+
+  std::vector<DeviceVector<word>> tmp;
+  std::vector<DvView<word>> tmp_view;
+  std::vector<DvConstView<word>> tmp_const_view;
+  std::vector<DvConstView<word>> dst_const_view;
+  for (int i = 0; i < num_poly; i++) {
+    tmp.emplace_back(dst.at(i).TotalSize());
+    tmp_view.push_back(tmp.at(i).View(dst.at(i).AuxSize()));
+    tmp_const_view.push_back(tmp.at(i).ConstView(dst.at(i).AuxSize()));
+    dst_const_view.emplace_back(dst.at(i));
+  }
+
+  // first iteration
+  int per = permute_amounts.at(0);
+  const std::vector<DvConstView<word>> *prev_accum = &(srcs.at(0));
+  if (per != 0) {
+    if (has_extra_ct) {
+      Permute(tmp_view, np, per, srcs.at(0));
+      Add(dst, np, tmp_const_view, srcs.back());
+    } else {
+      Permute(tmp_view, np, per, srcs.at(0));
+    }
+    prev_accum = &dst_const_view;
+  } else {
+    if (has_extra_ct) {
+      Add(dst, np, *prev_accum, srcs.back());
+      prev_accum = &dst_const_view;
+    }
+  }
+  for (int i = 1; i < num_accum; i++) {
+    per = permute_amounts.at(i);
+    if (per != 0) {
+      Permute(tmp_view, np, per, srcs.at(i));
+      Add(dst, np, tmp_const_view, *prev_accum);
+    } else {
+      Add(dst, np, srcs.at(i), *prev_accum);
+    }
+    prev_accum = &dst_const_view;
+  }
+}
+
+template <typename word>
+void ElementWiseHandler<word>::PermuteAccumWorker(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<int> &permute_amounts,
+    const std::vector<std::vector<DvConstView<word>>> &srcs) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "PermuteAccum: Invalid number of polynomials");
+
+  int num_accum = permute_amounts.size();
+
+  if (num_accum > max_num_accum_) {
+    // Prepare temporary result DV
+    std::vector<DeviceVector<word>> temp;
+    std::vector<DvView<word>> temp_view;
+    std::vector<DvConstView<word>> temp_const_view;
+    for (int i = 0; i < num_poly; i++) {
+      temp.emplace_back(dst.at(i).TotalSize());
+      temp_view.push_back(temp.at(i).View(dst.at(i).AuxSize()));
+      temp_const_view.push_back(temp.at(i).ConstView(dst.at(i).AuxSize()));
+    }
+
+    // Split the srcs/permute_amounts into front and back
+    std::vector<std::vector<DvConstView<word>>> srcs_front(
+        srcs.begin(), srcs.begin() + max_num_accum_);
+    srcs_front.push_back(temp_const_view);
+    std::vector<std::vector<DvConstView<word>>> srcs_back(
+        srcs.begin() + max_num_accum_, srcs.end());
+    std::vector<int> permute_front(permute_amounts.begin(),
+                                   permute_amounts.begin() + max_num_accum_);
+    std::vector<int> permute_back(permute_amounts.begin() + max_num_accum_,
+                                  permute_amounts.end());
+
+    // Recursive call to accumulate the front and back
+    PermuteAccum(temp_view, np, permute_back, srcs_back);
+    PermuteAccum(dst, np, permute_front, srcs_front);
+    return;
+  }
+
+  // Some sanity checks
+  int num_ct = srcs.size();
+  bool has_extra_ct = (num_ct == num_accum + 1);
+
+  AssertTrue(num_accum > 0 && (num_accum == num_ct || has_extra_ct),
+             "PermuteAccum: Invalid number of accumulations");
+  for (int i = 0; i < num_accum; i++) {
+    const auto &src = srcs.at(i);
+    AssertTrue(num_poly == static_cast<int>(src.size()),
+               "PermuteAccum: Incompatible dst/src size");
+    for (int j = 0; j < num_poly; j++) {
+      AssertTrue(dst.at(j).data() != src.at(j).data(),
+                 "PermuteAccum does not support inplace operation");
+    }
+  }
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+
+    // Prepare PtrList objects
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    std::vector<PermuteInputPtrList<word, j>> src_ptr_list;
+    for (int i = 0; i < num_accum; i++) {
+      const auto &src_i = srcs.at(i);
+      src_ptr_list.emplace_back(src_i);
+      src_ptr_list.back().extra_ = src_i.at(0).QSize() - q_size;
+      src_ptr_list.back().galois_factor_ =
+          PermuteAmountToGaloisFactor(permute_amounts.at(i));
+    }
+
+    if (has_extra_ct) {
+      InputPtrList<word, j> extra_ct(srcs.back());
+      extra_ct.extra_ = srcs.back().at(0).QSize() - q_size;
+      kernel::PermuteAccum<word, j>(dst_ptr_list, primes, num_q_primes,
+                                    np.GetNumTotal(), &extra_ct, src_ptr_list);
+    } else {
+      kernel::PermuteAccum<word, j>(dst_ptr_list, primes, num_q_primes,
+                                    np.GetNumTotal(), nullptr, src_ptr_list);
+    }
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::Accum(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<std::vector<DvConstView<word>>> &srcs) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "Accum: Invalid number of polynomials");
+
+  int num_accum = srcs.size();
+
+  if (num_accum > max_num_accum_) {
+    // Prepare temporary result DV
+    std::vector<DeviceVector<word>> temp;
+    std::vector<DvView<word>> temp_view;
+    std::vector<DvConstView<word>> temp_const_view;
+    for (int i = 0; i < num_poly; i++) {
+      temp.emplace_back(dst.at(i).TotalSize());
+      temp_view.push_back(temp.at(i).View(dst.at(i).AuxSize()));
+      temp_const_view.push_back(temp.at(i).ConstView(dst.at(i).AuxSize()));
+    }
+
+    // Split the srcs/permute_amounts into front and back
+    std::vector<std::vector<DvConstView<word>>> srcs_front(
+        srcs.begin(), srcs.begin() + max_num_accum_ - 1);
+    srcs_front.push_back(temp_const_view);
+    std::vector<std::vector<DvConstView<word>>> srcs_back(
+        srcs.begin() + max_num_accum_ - 1, srcs.end());
+
+    // Recursive call to accumulate the front and back
+    Accum(temp_view, np, srcs_back);
+    Accum(dst, np, srcs_front);
+    return;
+  }
+
+  // Some sanity checks
+  AssertTrue(num_accum > 1, "Accum: Invalid number of accumulations");
+  for (int i = 0; i < num_accum; i++) {
+    const auto &src = srcs.at(i);
+    AssertTrue(num_poly == static_cast<int>(src.size()),
+               "Accum: Incompatible dst/src size");
+  }
+
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+
+    // Preparing PtrList objects
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    std::vector<InputPtrList<word, j>> src_ptr_list;
+    for (int i = 0; i < num_accum; i++) {
+      const auto &src_i = srcs.at(i);
+      src_ptr_list.emplace_back(src_i);
+      src_ptr_list.back().extra_ = src_i.at(0).QSize() - q_size;
+    }
+
+    kernel::Sum<word, j>(dst_ptr_list, primes, num_q_primes, np.GetNumTotal(),
+                         src_ptr_list);
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::CAccum(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<std::vector<DvConstView<word>>> &ct_srcs,
+    const std::vector<DvConstView<word>> &common_srcs) const {
+  if (kMergeCMult) {
+    CPAccumWorker<true>(dst, np, ct_srcs, common_srcs);
+    return;
+  }
+
+  // Naive repetition of CMult and add
+  int num_poly = dst.size();
+  int num_accum = common_srcs.size();
+  bool has_extra_ct = (ct_srcs.size() == (common_srcs.size() + 1));
+  AssertTrue(num_accum == static_cast<int>(ct_srcs.size()) || has_extra_ct,
+             "CPAccum: Incompatible ct_srcs/common_srcs size");
+
+  std::vector<DeviceVector<word>> tmp;
+  std::vector<DvView<word>> tmp_view;
+  std::vector<DvConstView<word>> tmp_const_view;
+  std::vector<DvConstView<word>> dst_const_view;
+  for (int i = 0; i < num_poly; i++) {
+    tmp.emplace_back(dst.at(i).TotalSize());
+    tmp_view.push_back(tmp.at(i).View(dst.at(i).AuxSize()));
+    tmp_const_view.push_back(tmp.at(i).ConstView(dst.at(i).AuxSize()));
+    dst_const_view.emplace_back(dst.at(i));
+  }
+
+  // first iteration
+  if (has_extra_ct) {
+    MultConst(tmp_view, np, ct_srcs.at(0), common_srcs.at(0));
+    Add(dst, np, tmp_const_view, ct_srcs.back());
+  } else {
+    MultConst(dst, np, ct_srcs.at(0), common_srcs.at(0));
+  }
+  for (int i = 1; i < num_accum; i++) {
+    MultConst(tmp_view, np, ct_srcs.at(i), common_srcs.at(i));
+    Add(dst, np, tmp_const_view, dst_const_view);
+  }
+}
+
+template <typename word>
+void ElementWiseHandler<word>::PAccum(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<std::vector<DvConstView<word>>> &ct_srcs,
+    const std::vector<DvConstView<word>> &common_srcs) const {
+  if (kMergePMult) {
+    CPAccumWorker<false>(dst, np, ct_srcs, common_srcs);
+    return;
+  }
+
+  // Naive repetition of PMult and add
+  int num_poly = dst.size();
+  int num_accum = common_srcs.size();
+  bool has_extra_ct = (ct_srcs.size() == (common_srcs.size() + 1));
+  AssertTrue(num_accum == static_cast<int>(ct_srcs.size()) || has_extra_ct,
+             "CPAccum: Incompatible ct_srcs/common_srcs size");
+
+  std::vector<DeviceVector<word>> tmp;
+  std::vector<DvView<word>> tmp_view;
+  std::vector<DvConstView<word>> tmp_const_view;
+  std::vector<DvConstView<word>> dst_const_view;
+  for (int i = 0; i < num_poly; i++) {
+    tmp.emplace_back(dst.at(i).TotalSize());
+    tmp_view.push_back(tmp.at(i).View(dst.at(i).AuxSize()));
+    tmp_const_view.push_back(tmp.at(i).ConstView(dst.at(i).AuxSize()));
+    dst_const_view.emplace_back(dst.at(i));
+  }
+
+  // first iteration
+  if (has_extra_ct) {
+    PMult(tmp_view, np, ct_srcs.at(0), common_srcs.at(0));
+    Add(dst, np, tmp_const_view, ct_srcs.back());
+  } else {
+    PMult(dst, np, ct_srcs.at(0), common_srcs.at(0));
+  }
+  for (int i = 1; i < num_accum; i++) {
+    PMult(tmp_view, np, ct_srcs.at(i), common_srcs.at(i));
+    Add(dst, np, tmp_const_view, dst_const_view);
+  }
+}
+
+template <typename word>
+template <bool const_accum>
+void ElementWiseHandler<word>::CPAccumWorker(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<std::vector<DvConstView<word>>> &ct_srcs,
+    const std::vector<DvConstView<word>> &common_srcs) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "CPAccum: Invalid number of polynomials");
+
+  int num_accum = common_srcs.size();
+  bool has_extra_ct = (ct_srcs.size() == (common_srcs.size() + 1));
+  AssertTrue(num_accum == static_cast<int>(ct_srcs.size()) || has_extra_ct,
+             "CPAccum: Incompatible ct_srcs/common_srcs size");
+
+  if (num_accum > max_num_accum_) {
+    // Prepare temporary result DV
+    std::vector<DeviceVector<word>> temp;
+    std::vector<DvView<word>> temp_view;
+    std::vector<DvConstView<word>> temp_const_view;
+    for (int i = 0; i < num_poly; i++) {
+      int aux_size = dst.at(i).AuxSize();
+      temp.emplace_back(dst.at(i).TotalSize());
+      temp_view.push_back(temp.at(i).View(aux_size));
+      temp_const_view.push_back(temp.at(i).ConstView(aux_size));
+    }
+
+    // Split the ct_srcs/common_srcs into front and back
+    std::vector<std::vector<DvConstView<word>>> ct_srcs_front(
+        ct_srcs.begin(), ct_srcs.begin() + max_num_accum_);
+    ct_srcs_front.push_back(temp_const_view);
+    std::vector<std::vector<DvConstView<word>>> ct_srcs_back(
+        ct_srcs.begin() + max_num_accum_, ct_srcs.end());
+    std::vector<DvConstView<word>> common_srcs_front(
+        common_srcs.begin(), common_srcs.begin() + max_num_accum_);
+    std::vector<DvConstView<word>> common_srcs_back(
+        common_srcs.begin() + max_num_accum_, common_srcs.end());
+
+    // Recursive call to accumulate the front and back
+    CPAccumWorker<const_accum>(temp_view, np, ct_srcs_back, common_srcs_back);
+    CPAccumWorker<const_accum>(dst, np, ct_srcs_front, common_srcs_front);
+    return;
+  }
+
+  // Some sanity checks
+  AssertTrue(num_accum > 0, "CPAccum: Invalid number of accumulations");
+  for (const auto &ct_src : ct_srcs) {
+    AssertTrue(num_poly == static_cast<int>(ct_src.size()),
+               "CPAccum: Incompatible dst/ct_src size");
+  }
+
+  AssertNPMatch(dst, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+
+    // Preparing PtrList objects
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    std::vector<CPAccumInputPtrList<word, j>> src_ptr_list;
+    for (int i = 0; i < num_accum; i++) {
+      const auto &ct_src_i = ct_srcs.at(i);
+      const auto &common_src_i = common_srcs.at(i);
+      src_ptr_list.emplace_back(ct_src_i, common_src_i);
+      src_ptr_list.back().extra_ = ct_src_i.at(0).QSize() - q_size;
+      src_ptr_list.back().common_extra_ = common_src_i.QSize();
+      if constexpr (const_accum) {  // CAccum
+        src_ptr_list.back().common_extra_ -= num_q_primes;
+      } else {  // PAccum
+        src_ptr_list.back().common_extra_ -= q_size;
+      }
+    }
+
+    if (has_extra_ct) {
+      InputPtrList<word, j> src0(ct_srcs.back());
+      src0.extra_ = ct_srcs.back().at(0).QSize() - q_size;
+      kernel::CPAccum<word, j, const_accum>(dst_ptr_list, primes, num_q_primes,
+                                            np.GetNumTotal(), &src0,
+                                            src_ptr_list);
+    } else {
+      kernel::CPAccum<word, j, const_accum>(dst_ptr_list, primes, num_q_primes,
+                                            np.GetNumTotal(), nullptr,
+                                            src_ptr_list);
+    }
+  });
+}
+
+template <typename word>
+void ElementWiseHandler<word>::ModUpToMax(DvView<word> &dst,
+                                          const DvConstView<word> &src1) const {
+  int num_aux = dst.AuxSize() / param_.degree_;
+  NPInfo max_np = param_.LevelToNP(param_.max_level_, num_aux);
+  NPInfo min_np = param_.LevelToNP(-1);
+  std::vector<word> base_primes = param_.GetPrimeVector(min_np);
+  auto dst_temp = std::vector<DvView<word>>{dst};
+  AssertNPMatch(dst_temp, max_np);
+
+  const word *primes = param_.GetPrimesPtr(max_np);
+  int num_primes = max_np.GetNumTotal();
+
+  if (base_primes.size() == 2) {
+    kernel::ModUpToMax2<word>(dst.data(), primes, num_primes,
+                              base_primes.at(0), base_primes.at(1),
+                              src1.data());
+  } else if (base_primes.size() == 1) {
+    kernel::ModUpToMax1<word>(dst.data(), primes, num_primes, src1.data());
+  } else {
+    Fail("ModUpToMax: Invalid base primes size");
+  }
+}
+
+template <typename word>
+void ElementWiseHandler<word>::MultImaginaryUnit(
+    std::vector<DvView<word>> &dst, const NPInfo &np,
+    const std::vector<DvConstView<word>> &src1,
+    const DvConstView<word> &src_i_unit) const {
+  // Check the size of the vectors
+  int num_poly = dst.size();
+  AssertTrue(num_poly == static_cast<int>(src1.size()),
+             "MultImaginaryUnit: Incompatible dst/src size");
+  AssertTrue(num_poly > 0 && num_poly <= max_num_poly_,
+             "MultImaginaryUnit: Invalid number of polynomials");
+  AssertNPMatch({dst}, np);
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * param_.degree_;
+
+  constexpr_for<1, max_num_poly_ + 1>([&](auto j) {
+    if (num_poly != j) return;
+    OutputPtrList<word, j> dst_ptr_list(dst);
+    InputPtrList<word, j> src1_ptr_list(src1);
+    src1_ptr_list.extra_ = src1.at(0).QSize() - q_size;
+    InputPtrList<word, 1> i_unit(src_i_unit);
+    i_unit.extra_ = src_i_unit.QSize() - q_size;
+
+    kernel::MultImaginaryUnit<word, j>(dst_ptr_list, primes, num_q_primes,
+                                       np.GetNumTotal(), src1_ptr_list,
+                                       i_unit);
+  });
+}
+
+// explicit instantiation
+template class ElementWiseHandler<uint32_t>;
+template class ElementWiseHandler<uint64_t>;
+
+}  // namespace cheddar
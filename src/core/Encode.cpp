@@ -1,23 +1,84 @@
 #include "core/Encode.h"
 
+#include <cmath>
+#include <cstdint>
+
 #include "common/Assert.h"
+#include "common/BasicSimd.h"
 #include "common/CommonUtils.h"
 #include "common/PrimeUtils.h"
-#include "core/BigInt.h"
+#include "common/ThreadPool.h"
+#include "core/DoubleModReducer.h"
 
 namespace cheddar {
 
+namespace {
+
+// Special FFT butterflies over n consecutive pairs (x[j], y[j]) with
+// twiddles w[j]. The complex products are written out so that the loops
+// vectorize (std::complex multiplication does not, because of its NaN
+// handling).
+
+// (x, y) <- (x + y * w, x - y * w)
+CHEDDAR_HOST_TARGET_CLONES void ButterflyFFT(Complex *__restrict__ x_ptr,
+                                             Complex *__restrict__ y_ptr,
+                                             const Complex *__restrict__ w_ptr,
+                                             int n) {
+  double *x = reinterpret_cast<double *>(x_ptr);
+  double *y = reinterpret_cast<double *>(y_ptr);
+  const double *w = reinterpret_cast<const double *>(w_ptr);
+  for (int j = 0; j < n; j++) {
+    double yw_real = y[2 * j] * w[2 * j] - y[2 * j + 1] * w[2 * j + 1];
+    double yw_imag = y[2 * j] * w[2 * j + 1] + y[2 * j + 1] * w[2 * j];
+    double x_real = x[2 * j];
+    double x_imag = x[2 * j + 1];
+    x[2 * j] = x_real + yw_real;
+    x[2 * j + 1] = x_imag + yw_imag;
+    y[2 * j] = x_real - yw_real;
+    y[2 * j + 1] = x_imag - yw_imag;
+  }
+}
+
+// (x, y) <- (x + y, (x - y) * conj(w))
+CHEDDAR_HOST_TARGET_CLONES void ButterflyIFFT(Complex *__restrict__ x_ptr,
+                                              Complex *__restrict__ y_ptr,
+                                              const Complex *__restrict__ w_ptr,
+                                              int n) {
+  double *x = reinterpret_cast<double *>(x_ptr);
+  double *y = reinterpret_cast<double *>(y_ptr);
+  const double *w = reinterpret_cast<const double *>(w_ptr);
+  for (int j = 0; j < n; j++) {
+    double diff_real = x[2 * j] - y[2 * j];
+    double diff_imag = x[2 * j + 1] - y[2 * j + 1];
+    x[2 * j] += y[2 * j];
+    x[2 * j + 1] += y[2 * j + 1];
+    y[2 * j] = diff_real * w[2 * j] + diff_imag * w[2 * j + 1];
+    y[2 * j + 1] = diff_imag * w[2 * j] - diff_real * w[2 * j + 1];
+  }
+}
+
+}  // namespace
+
 template <typename word>
 Encoder<word>::Encoder(const Parameter<word> &param,
                        const NTTHandler<word> &ntt_handler)
     : param_{param},
       ntt_handler_{ntt_handler},
       M_{param.degree_ * 2},
-      twiddle_factors_(param.degree_ * 2) {
+      twiddle_factors_(param.degree_ * 2),
+      fft_twiddles_(param.degree_ / 2) {
   for (int i = 0; i < param.degree_ * 2; i++) {
     // e^(2*pi*sqrt(-1)*i/M)
     twiddle_factors_[i] = std::polar(1.0, 2.0 * M_PI * i / M_);
   }
+  for (int stride = 1; stride < param.degree_ / 2; stride *= 2) {
+    int st8 = stride << 3;
+    int gap = M_ / st8;
+    for (int j = 0; j < stride; j++) {
+      int twiddle_index = (param.GetGaloisFactor(j) % st8) * gap;
+      fft_twiddles_[stride + j] = twiddle_factors_[twiddle_index];
+    }
+  }
 }
 
 template <typename word>
@@ -43,17 +104,38 @@ void Encoder<word>::EncodeWorker(Plaintext<word> &ptxt, int level, double scale,
 }
 
 template <typename word>
-void Encoder<word>::Decode(std::vector<Complex> &message,
-                           const Plaintext<word> &ptxt) const {
-  // Message padding
-  Plaintext<word> tmp;
-  NPInfo np = ptxt.GetNP();
-  AssertTrue(np.num_aux_ == 0, "Decode: Aux primes not supported");
+void Encoder<word>::EncodeMultiLevel(MultiLevelPlaintext<word> &ptxt,
+                                     int min_level, int max_level,
+                                     double scale,
+                                     const std::vector<Complex> &message) const {
+  int msg_length = message.size();
+  int num_slots = 1 << Log2Ceil<int>(msg_length);
+  std::vector<Complex> padded_msg(num_slots);
+  std::copy(message.begin(), message.end(), padded_msg.begin());
+  SpecialIFFT(padded_msg);
+
+  // Every limb (and its NTT) only depends on its own prime, so the union
+  // plaintext holds the plaintexts of all the levels.
+  NPInfo np = MultiLevelPlaintext<word>::UnionNP(param_, min_level, max_level);
+  HostVector<word> mx(np.GetNumTotal() * param_.degree_, 0);
+  ComplexVectorToRNS(mx.data(), np, scale, padded_msg);
+
+  Plaintext<word> base(np);
+  base.SetNumSlots(num_slots);
+  base.SetScale(scale);
+  CopyHostToDeviceAsync(base.mx_, mx);
+  auto mx_temp = base.View();
+  ntt_handler_.NTT(mx_temp, np, base.ConstView(), true);
+  ptxt = MultiLevelPlaintext<word>(param_, min_level, max_level,
+                                   std::move(base));
+}
+
+template <typename word>
+HostVector<word> Encoder<word>::ICRTConstants(const NPInfo &np) const {
   auto primes = param_.GetPrimeVector(np);
   int num_total_primes = np.GetNumTotal();
   word degree = param_.degree_;
 
-  // Create iCRT constants
   HostVector<word> icrt1(num_total_primes);
   for (int i = 0; i < num_total_primes; i++) {
     word mod_prime = primes[i];
@@ -66,9 +148,20 @@ void Encoder<word>::Decode(std::vector<Complex> &message,
     // deliberately not using the Montgomery form here
     icrt1[i] = primeutil::InvMod(prod, mod_prime);
   }
+  return icrt1;
+}
 
-  DeviceVector<word> icrt1_dv(num_total_primes);
-  CopyHostToDevice(icrt1_dv, icrt1);
+template <typename word>
+void Encoder<word>::Decode(std::vector<Complex> &message,
+                           const Plaintext<word> &ptxt) const {
+  // Message padding
+  Plaintext<word> tmp;
+  NPInfo np = ptxt.GetNP();
+  AssertTrue(np.num_aux_ == 0, "Decode: Aux primes not supported");
+
+  // Create iCRT constants
+  DeviceVector<word> icrt1_dv(np.GetNumTotal());
+  CopyHostToDevice(icrt1_dv, ICRTConstants(np));
 
   tmp.ModifyNP(np);
   tmp.SetNumSlots(ptxt.GetNumSlots());
@@ -81,6 +174,107 @@ void Encoder<word>::Decode(std::vector<Complex> &message,
   SpecialFFT(message);
 }
 
+template <typename word>
+void Encoder<word>::EncodeBatch(
+    std::vector<Plaintext<word>> &ptxts, int level, double scale,
+    const std::vector<std::vector<Complex>> &messages,
+    int num_aux /*= 0*/) const {
+  int batch_size = messages.size();
+  NPInfo np = param_.LevelToNP(level, num_aux);
+  int poly_size = np.GetNumTotal() * param_.degree_;
+  int chunk_size = std::max(1, kMaxBatchWords / poly_size);
+  ptxts.resize(batch_size);
+
+  for (int chunk_begin = 0; chunk_begin < batch_size;
+       chunk_begin += chunk_size) {
+    int chunk_end = std::min(batch_size, chunk_begin + chunk_size);
+    HostVector<word> mx(static_cast<size_t>(chunk_end - chunk_begin) *
+                            poly_size,
+                        0);
+
+    ThreadPool::Global().ParallelFor(chunk_begin, chunk_end, [&](int b) {
+      const std::vector<Complex> &message = messages[b];
+      int num_slots = 1 << Log2Ceil<int>(message.size());
+      thread_local std::vector<Complex> padded_msg;
+      padded_msg.assign(num_slots, Complex(0, 0));
+      std::copy(message.begin(), message.end(), padded_msg.begin());
+      SpecialIFFT(padded_msg);
+      ComplexVectorToRNS(mx.data() + (b - chunk_begin) * poly_size, np, scale,
+                         padded_msg);
+    });
+
+    // A single host-to-device transfer for the whole chunk, overlapped with
+    // the encoding of the next chunk
+    DeviceVector<word> mx_dv;
+    CopyHostToDeviceAsync(mx_dv, mx);
+    for (int b = chunk_begin; b < chunk_end; b++) {
+      Plaintext<word> &ptxt = ptxts[b];
+      ptxt.ModifyNP(np);
+      ptxt.SetNumSlots(1 << Log2Ceil<int>(messages[b].size()));
+      ptxt.SetScale(scale);
+      DvConstView<word> src(mx_dv.data() + (b - chunk_begin) * poly_size,
+                            poly_size, np.num_aux_ * param_.degree_);
+      auto mx_temp = ptxt.View();
+      ntt_handler_.NTT(mx_temp, np, src, true);
+    }
+  }
+}
+
+template <typename word>
+void Encoder<word>::DecodeBatch(
+    std::vector<std::vector<Complex>> &messages,
+    const std::vector<Plaintext<word>> &ptxts) const {
+  int batch_size = ptxts.size();
+  messages.resize(batch_size);
+
+  int chunk_begin = 0;
+  while (chunk_begin < batch_size) {
+    // Gather plaintexts while the INTT results fit in one transfer
+    std::vector<int> offsets{0};
+    int chunk_end = chunk_begin;
+    while (chunk_end < batch_size) {
+      NPInfo np = ptxts[chunk_end].GetNP();
+      AssertTrue(np.num_aux_ == 0, "DecodeBatch: Aux primes not supported");
+      int poly_size = np.GetNumTotal() * param_.degree_;
+      bool fits = offsets.back() <= kMaxBatchWords - poly_size;
+      if (chunk_end > chunk_begin && !fits) break;
+      offsets.push_back(offsets.back() + poly_size);
+      chunk_end++;
+    }
+
+    DeviceVector<word> intt_dv(offsets.back());
+    std::map<NPKey, DeviceVector<word>> icrt_dvs;
+    for (int b = chunk_begin; b < chunk_end; b++) {
+      const Plaintext<word> &ptxt = ptxts[b];
+      NPInfo np = ptxt.GetNP();
+      NPKey key{np.num_main_, np.num_ter_, np.num_aux_};
+      auto it = icrt_dvs.find(key);
+      if (it == icrt_dvs.end()) {
+        it = icrt_dvs.emplace(key, DeviceVector<word>(np.GetNumTotal())).first;
+        CopyHostToDevice(it->second, ICRTConstants(np));
+      }
+      int offset = offsets[b - chunk_begin];
+      DvView<word> dst(intt_dv.data() + offset,
+                       offsets[b - chunk_begin + 1] - offset);
+      ntt_handler_.INTTAndMultConst(dst, np, ptxt.ConstView(),
+                                    it->second.ConstView());
+    }
+
+    // A single device-to-host transfer for the whole chunk
+    HostVector<word> intt_res;
+    CopyDeviceToHost(intt_res, intt_dv);
+
+    ThreadPool::Global().ParallelFor(chunk_begin, chunk_end, [&](int b) {
+      const Plaintext<word> &ptxt = ptxts[b];
+      RNSToComplexVector(messages[b],
+                         intt_res.data() + offsets[b - chunk_begin],
+                         ptxt.GetNP(), ptxt.GetNumSlots(), ptxt.GetScale());
+      SpecialFFT(messages[b]);
+    });
+    chunk_begin = chunk_end;
+  }
+}
+
 template <typename word>
 void Encoder<word>::SpecialIFFT(std::vector<Complex> &data) const {
   int num_slots = data.size();
@@ -88,23 +282,25 @@ void Encoder<word>::SpecialIFFT(std::vector<Complex> &data) const {
              "Power of 2 num slots only");
 
   for (int stride = num_slots / 2; stride >= 1; stride /= 2) {
-    int stride_group_size = stride * 2;
-    int st8 = stride << 3;
-    int gap = M_ / st8;
-    for (int i = 0; i < num_slots; i += stride_group_size) {
-      for (int j = 0; j < stride; j++) {
-        int twiddle_index = (st8 - (param_.GetGaloisFactor(j) % st8)) * gap;
-        auto x = data[i + j] + data[i + j + stride];
-        auto y = data[i + j] - data[i + j + stride];
-        y *= twiddle_factors_[twiddle_index];
-        data[i + j] = x;
-        data[i + j + stride] = y;
-      }
+    const Complex *twiddles = fft_twiddles_.data() + stride;
+    for (int i = 0; i < num_slots; i += 2 * stride) {
+      ButterflyIFFT(&data[i], &data[i + stride], twiddles, stride);
     }
   }
-  BitReverseVector(data);
-  for (int i = 0; i < num_slots; ++i) {
-    data[i] /= num_slots;
+
+  // Bit reversal fused with the normalization (num_slots is a power of 2, so
+  // multiplying by the inverse is exact)
+  int log_slots = Log2Ceil(num_slots);
+  double inv_num_slots = 1.0 / num_slots;
+  for (int i = 0; i < num_slots; i++) {
+    int j = BitReverseInt(i, log_slots);
+    if (i < j) {
+      Complex tmp = data[i];
+      data[i] = data[j] * inv_num_slots;
+      data[j] = tmp * inv_num_slots;
+    } else if (i == j) {
+      data[i] *= inv_num_slots;
+    }
   }
 }
 
@@ -116,18 +312,9 @@ void Encoder<word>::SpecialFFT(std::vector<Complex> &data) const {
   BitReverseVector(data);
 
   for (int stride = 1; stride < num_slots; stride *= 2) {
-    int stride_group_size = stride * 2;
-    int st8 = stride << 3;
-    int gap = M_ / st8;
-    for (int i = 0; i < num_slots; i += stride_group_size) {
-      for (int j = 0; j < stride; j++) {
-        int twiddle_index = (param_.GetGaloisFactor(j) % st8) * gap;
-        auto x = data[i + j];
-        auto y = data[i + j + stride];
-        y *= twiddle_factors_[twiddle_index];
-        data[i + j] = x + y;
-        data[i + j + stride] = x - y;
-      }
+    const Complex *twiddles = fft_twiddles_.data() + stride;
+    for (int i = 0; i < num_slots; i += 2 * stride) {
+      ButterflyFFT(&data[i], &data[i + stride], twiddles, stride);
     }
   }
 }
@@ -137,6 +324,20 @@ void Encoder<word>::ComplexVectorToPlaintext(Plaintext<word> &ptxt, int level,
                                              double scale,
                                              const std::vector<Complex> &data,
                                              int num_aux /*= 0*/) const {
+  NPInfo np = param_.LevelToNP(level, num_aux);
+  HostVector<word> mx(np.GetNumTotal() * param_.degree_, 0);
+  ComplexVectorToRNS(mx.data(), np, scale, data);
+
+  ptxt.ModifyNP(np);
+  ptxt.SetNumSlots(data.size());
+  ptxt.SetScale(scale);
+  CopyHostToDeviceAsync(ptxt.mx_, mx);
+}
+
+template <typename word>
+void Encoder<word>::ComplexVectorToRNS(word *mx, const NPInfo &np,
+                                       double scale,
+                                       const std::vector<Complex> &data) const {
   int num_slots = data.size();
   int degree = param_.degree_;
   int half_degree = degree / 2;
@@ -147,56 +348,126 @@ void Encoder<word>::ComplexVectorToPlaintext(Plaintext<word> &ptxt, int level,
   AssertTrue(num_slots <= half_degree,
              "ComplexVectorToPlaintext: Too many slots");
 
-  NPInfo np = param_.LevelToNP(level, num_aux);
   auto primes = param_.GetPrimeVector(np);
   int num_total_primes = np.GetNumTotal();
-  HostVector<word> mx(num_total_primes * degree, 0);
 
-  std::vector<BigInt> big_primes;
-
-  for (int j = 0; j < num_total_primes; j++) {
-    big_primes.emplace_back(static_cast<uint64_t>(primes[j]));
+  // Scaled values are truncated toward zero. Those that fit in int64_t, which
+  // is practically all of them, are reduced with Montgomery arithmetic. The
+  // rest fall back to DoubleModReducer. Non-finite values are rejected. values
+  // holds the real parts followed by the imaginary parts.
+  // The scratch buffers are reused across calls on the same thread.
+  constexpr double kInt64Bound = 0x1p63;
+  thread_local std::vector<int64_t> values;
+  thread_local std::vector<int> big_value_indices;
+  values.assign(2 * num_slots, 0);
+  big_value_indices.clear();
+  for (int i = 0; i < 2 * num_slots; i++) {
+    Complex value = data[i % num_slots] * scale;
+    double x = (i < num_slots) ? value.real() : value.imag();
+    if (std::fabs(x) < kInt64Bound) {
+      values[i] = static_cast<int64_t>(x);
+    } else {
+      AssertTrue(std::isfinite(x),
+                 "ComplexVectorToPlaintext: Non-finite value in the message");
+      big_value_indices.push_back(i);
+    }
   }
 
-  for (int i = 0; i < num_slots; i++) {
-    Complex value = data[i] * scale;
-    double real = value.real();
-    double imag = value.imag();
+  // values[i] goes to coefficient i * gap (real parts) or
+  // (i - num_slots) * gap + half_degree (imaginary parts)
+  auto coeff_index = [&](int i) {
+    return (i < num_slots) ? i * gap : (i - num_slots) * gap + half_degree;
+  };
+
+  const int64_t *values_ptr = values.data();
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int j) {
+    basic::Modulus<word> mod(primes[j]);
+    word *mx_limb = mx + j * degree;
+    if (gap == 1) {
+      basic::simd::ReduceInt64(mx_limb, values_ptr, degree, mod);
+      return;
+    }
+    thread_local std::vector<word> residues;
+    residues.resize(2 * num_slots);
+    basic::simd::ReduceInt64(residues.data(), values_ptr, 2 * num_slots, mod);
+    for (int i = 0; i < 2 * num_slots; i++) {
+      mx_limb[coeff_index(i)] = residues[i];
+    }
+  });
 
-    BigInt big_real(real);
-    BigInt big_imag(imag);
+  for (int i : big_value_indices) {
+    Complex value = data[i % num_slots] * scale;
+    DoubleModReducer big_value((i < num_slots) ? value.real() : value.imag());
+    for (int j = 0; j < num_total_primes; j++) {
+      mx[coeff_index(i) + j * degree] =
+          static_cast<word>(big_value.Reduce(primes[j]));
+    }
+  }
+}
 
-    int real_degree_index = i * gap;
-    int imag_degree_index = real_degree_index + half_degree;
+template <typename word>
+struct Encoder<word>::GarnerTable {
+  std::vector<basic::Modulus<word>> moduli;
+  // (Q / q_i) mod q_i, to undo the iCRT constants applied in Decode
+  std::vector<word> crt_hat_mont;
+  // P_i^(-1) mod q_i
+  std::vector<word> prefix_inv_mont;
+  // P_j mod q_i at [i * L + j], for j < i
+  std::vector<word> prefix_mont;
+};
 
-    BigInt real_tmp(0.0);
-    BigInt imag_tmp(0.0);
+template <typename word>
+std::shared_ptr<const typename Encoder<word>::GarnerTable>
+Encoder<word>::GetGarnerTable(const NPInfo &np) const {
+  NPKey key{np.num_main_, np.num_ter_, np.num_aux_};
+  std::lock_guard<std::mutex> lock(garner_tables_mutex_);
+  auto it = garner_tables_.find(key);
+  if (it != garner_tables_.end()) return it->second;
 
-    for (int j = 0; j < num_total_primes; j++) {
-      const BigInt &prime = big_primes[j];
-      BigInt::Mod(real_tmp, big_real, prime);
-      BigInt::Mod(imag_tmp, big_imag, prime);
-      word real_mod = real_tmp.GetUnsigned();
-      word imag_mod = imag_tmp.GetUnsigned();
-      mx[real_degree_index + j * param_.degree_] = real_mod;
-      mx[imag_degree_index + j * param_.degree_] = imag_mod;
+  auto primes = param_.GetPrimeVector(np);
+  int num_primes = np.GetNumTotal();
+  auto table = std::make_shared<GarnerTable>();
+  for (word prime : primes) table->moduli.emplace_back(prime);
+  table->crt_hat_mont.resize(num_primes);
+  table->prefix_inv_mont.resize(num_primes);
+  table->prefix_mont.resize(num_primes * num_primes, 0);
+  for (int i = 0; i < num_primes; i++) {
+    const basic::Modulus<word> &mod = table->moduli[i];
+    word prefix = 1;
+    word crt_hat = 1;
+    for (int j = 0; j < num_primes; j++) {
+      if (j == i) continue;
+      word q_j = mod.Reduce(primes[j]);
+      if (j < i) {
+        table->prefix_mont[i * num_primes + j] = mod.ToMontgomery(prefix);
+        prefix = mod.MultMod(prefix, q_j);
+      }
+      crt_hat = mod.MultMod(crt_hat, q_j);
     }
+    table->prefix_inv_mont[i] =
+        mod.ToMontgomery(primeutil::InvMod(prefix, primes[i]));
+    table->crt_hat_mont[i] = mod.ToMontgomery(crt_hat);
   }
-
-  ptxt.ModifyNP(np);
-  ptxt.SetNumSlots(num_slots);
-  ptxt.SetScale(scale);
-  CopyHostToDevice(ptxt.mx_, mx);
+  garner_tables_.emplace(key, table);
+  return table;
 }
 
 template <typename word>
 void Encoder<word>::PlaintextToComplexVector(
     std::vector<Complex> &data, const Plaintext<word> &ptxt) const {
-  int num_slots = ptxt.GetNumSlots();
-  double scale = ptxt.GetScale();
-  NPInfo np = ptxt.GetNP();
+  HostVector<word> intt_res;
+  CopyDeviceToHost(intt_res, ptxt.mx_);
+  RNSToComplexVector(data, intt_res.data(), ptxt.GetNP(), ptxt.GetNumSlots(),
+                     ptxt.GetScale());
+}
+
+template <typename word>
+void Encoder<word>::RNSToComplexVector(std::vector<Complex> &data,
+                                       const word *intt_res, const NPInfo &np,
+                                       int num_slots, double scale) const {
+  using signed_word = make_signed_t<word>;
+
   int num_total_primes = np.GetNumTotal();
-  auto primes = param_.GetPrimeVector(np);
   int degree = param_.degree_;
   int half_degree = degree / 2;
   int gap = half_degree / num_slots;
@@ -208,50 +479,67 @@ void Encoder<word>::PlaintextToComplexVector(
 
   data.resize(num_slots);
 
-  HostVector<word> intt_res;
-  CopyDeviceToHost(intt_res, ptxt.mx_);
-
-  std::vector<BigInt> big_primes;
-  BigInt prime_prod(static_cast<uint64_t>(1));
-  for (int i = 0; i < num_total_primes; i++) {
-    big_primes.emplace_back(static_cast<uint64_t>(primes[i]));
-    BigInt::Mult(prime_prod, prime_prod, big_primes[i]);
-  }
-  BigInt half_prime_prod(static_cast<uint64_t>(0));
-  BigInt::Div2(half_prime_prod, prime_prod);
-
-  BigInt tmp(static_cast<uint64_t>(0));
-  for (int i = 0; i < num_slots; i++) {
-    BigInt real_icrt(static_cast<uint64_t>(0));
-    BigInt imag_icrt(static_cast<uint64_t>(0));
-    for (int j = 0; j < num_total_primes; j++) {
-      BigInt real_value(static_cast<uint64_t>(intt_res[j * degree + i * gap]));
-      BigInt imag_value(
-          static_cast<uint64_t>(intt_res[j * degree + i * gap + half_degree]));
-      BigInt prod(static_cast<uint64_t>(1));
-      for (int k = 0; k < num_total_primes; k++) {
-        if (j == k) continue;
-        BigInt::Mult(prod, prod, big_primes[k]);
+  auto table = GetGarnerTable(np);
+  const auto &moduli = table->moduli;
+
+  // Garner's algorithm computes the mixed-radix digits u_i of each
+  // coefficient with word-sized Montgomery arithmetic. The digits are then
+  // balanced into [-(q_i - 1) / 2, (q_i - 1) / 2] (carrying upwards), which
+  // yields the representative of x in (-Q / 2, Q / 2), and evaluated in long
+  // double without cancellation.
+  auto reconstruct = [&](int coeff_index, word *digits,
+                         signed_word *balanced) {
+    for (int i = 0; i < num_total_primes; i++) {
+      const basic::Modulus<word> &mod = moduli[i];
+      word q_i = mod.Value();
+      word res = mod.MultMontgomery(intt_res[i * degree + coeff_index],
+                                    table->crt_hat_mont[i]);
+      const word *prefix_mont =
+          table->prefix_mont.data() + i * num_total_primes;
+      for (int j = 0; j < i; j++) {
+        // digits[j] < q_j < 2^(word_size - 1) is fine for MultMontgomery
+        word prod = mod.MultMontgomery(digits[j], prefix_mont[j]);
+        res = (res >= prod) ? res - prod : res + q_i - prod;
       }
-      BigInt::Mult(tmp, real_value, prod);
-      BigInt::Add(real_icrt, real_icrt, tmp);
-      BigInt::Mult(tmp, imag_value, prod);
-      BigInt::Add(imag_icrt, imag_icrt, tmp);
+      digits[i] = mod.MultMontgomery(res, table->prefix_inv_mont[i]);
     }
-    BigInt::NormalizeMod(real_icrt, real_icrt, prime_prod, half_prime_prod);
-    BigInt::NormalizeMod(imag_icrt, imag_icrt, prime_prod, half_prime_prod);
-
-    double real = real_icrt.GetDouble() / scale;
-    double imag = imag_icrt.GetDouble() / scale;
-    data[i] = Complex(real, imag);
-  }
+    word carry = 0;
+    for (int i = 0; i < num_total_primes; i++) {
+      word q_i = moduli[i].Value();
+      word digit = digits[i] + carry;
+      carry = (digit > (q_i >> 1)) ? 1 : 0;
+      balanced[i] = static_cast<signed_word>(digit) -
+                    static_cast<signed_word>(carry ? q_i : 0);
+    }
+    long double value = 0;
+    for (int i = num_total_primes - 1; i >= 0; i--) {
+      value = value * moduli[i].Value() + balanced[i];
+    }
+    return static_cast<double>(value / scale);
+  };
+
+  constexpr int kSlotBlock = 64;
+  int num_blocks = DivCeil(num_slots, kSlotBlock);
+  ThreadPool::Global().ParallelFor(0, num_blocks, [&](int block) {
+    thread_local std::vector<word> digits;
+    thread_local std::vector<signed_word> balanced;
+    digits.resize(num_total_primes);
+    balanced.resize(num_total_primes);
+    int slot_end = std::min(num_slots, (block + 1) * kSlotBlock);
+    for (int i = block * kSlotBlock; i < slot_end; i++) {
+      double real = reconstruct(i * gap, digits.data(), balanced.data());
+      double imag = reconstruct(i * gap + half_degree, digits.data(),
+                                balanced.data());
+      data[i] = Complex(real, imag);
+    }
+  });
 }
 
 template <typename word>
 void Encoder<word>::EncodeConstant(Constant<word> &constant, int level,
                                    double scale, double number,
                                    int num_aux /*= 0*/) const {
-  BigInt big_int(number * scale);
+  DoubleModReducer big_value(number * scale);
   NPInfo np = param_.LevelToNP(level, num_aux);
   int num_total_primes = np.GetNumTotal();
 
@@ -260,18 +548,14 @@ void Encoder<word>::EncodeConstant(Constant<word> &constant, int level,
   HostVector<word> cx(num_total_primes);
 
   for (int i = 0; i < num_total_primes; i++) {
-    BigInt prime(static_cast<uint64_t>(primes[i]));
-
-    BigInt big_mod(static_cast<uint64_t>(0));
-    BigInt::Mod(big_mod, big_int, prime);
-
-    word result = big_mod.GetUnsigned();
-    cx[i] = primeutil::ToMontgomery(result, primes[i]);
+    basic::Modulus<word> mod(primes[i]);
+    word result = static_cast<word>(big_value.Reduce(primes[i]));
+    cx[i] = mod.ToMontgomery(result);
   }
 
   constant.ModifyNP(np);
   constant.SetScale(scale);
-  CopyHostToDevice(constant.cx_, cx);
+  CopyHostToDeviceAsync(constant.cx_, cx);
 }
 
 template <typename word>
@@ -5,36 +5,44 @@
 namespace cheddar {
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetEvk(int key_idx) const {
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetEvk(int key_idx) const {
   auto it = this->find(key_idx);
-  AssertTrue(it != this->end(),
+  // The keys in the map are owned by the map (a non-owning pointer).
+  if (it != this->end()) return EvkPtr(EvkPtr(), &it->second);
+  EvkPtr evk = (store_ != nullptr) ? store_->Find(key_idx) : nullptr;
+  AssertTrue(evk != nullptr,
              "GetEvk: Key not found for index " + std::to_string(key_idx));
-  return it->second;
+  return evk;
 }
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetRotationKey(int rot_idx) const {
+void EvkMap<word>::AttachStore(std::shared_ptr<const EvkStore<word>> store) {
+  store_ = std::move(store);
+}
+
+template <typename word>
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetRotationKey(int rot_idx) const {
   AssertTrue(rot_idx > 0, "GetRotationKey: Invalid rotation index");
   return GetEvk(rot_idx);
 }
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetMultiplicationKey() const {
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetMultiplicationKey() const {
   return GetEvk(kMultiplicationKeyIndex);
 }
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetConjugationKey() const {
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetConjugationKey() const {
   return GetEvk(kConjugationKeyIndex);
 }
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetDenseToSparseKey() const {
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetDenseToSparseKey() const {
   return GetEvk(kDenseToSparseKeyIndex);
 }
 
 template <typename word>
-const EvaluationKey<word> &EvkMap<word>::GetSparseToDenseKey() const {
+typename EvkMap<word>::EvkPtr EvkMap<word>::GetSparseToDenseKey() const {
   return GetEvk(kSparseToDenseKeyIndex);
 }
 
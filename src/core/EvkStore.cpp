@@ -0,0 +1,193 @@
+#include "core/EvkStore.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+namespace {
+
+uint64_t AlignUp(uint64_t bytes) {
+  return (bytes + kSerialAlignment - 1) / kSerialAlignment * kSerialAlignment;
+}
+
+}  // namespace
+
+template <typename word>
+void EvkStore<word>::Write(const std::string &path,
+                           const Parameter<word> &param,
+                           const std::unordered_map<int, Evk> &keys) {
+  Serializer<word> serializer(param);
+
+  // Sorted by the key index, so that the output is deterministic
+  std::map<int, const Evk *> sorted_keys;
+  for (const auto &[key_idx, evk] : keys) sorted_keys.emplace(key_idx, &evk);
+
+  StoreHeader header{};
+  header.magic = StoreHeader::kMagic;
+  header.version = StoreHeader::kVersion;
+  header.word_bytes = sizeof(word);
+  header.num_entries = sorted_keys.size();
+
+  std::vector<IndexEntry> entries;
+  uint64_t offset =
+      AlignUp(sizeof(StoreHeader) + sorted_keys.size() * sizeof(IndexEntry));
+  for (const auto &[key_idx, evk] : sorted_keys) {
+    IndexEntry entry{};
+    entry.key_idx = key_idx;
+    entry.level = param.NPToLevel(evk->GetNP());
+    entry.offset = offset;
+    entry.bytes = serializer.GetSerializedSize(*evk);
+    entries.push_back(entry);
+    offset += entry.bytes;
+  }
+
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  AssertTrue(os.is_open(), "EvkStore: Cannot open " + path);
+  os.write(reinterpret_cast<const char *>(&header), sizeof(StoreHeader));
+  os.write(reinterpret_cast<const char *>(entries.data()),
+           entries.size() * sizeof(IndexEntry));
+  static const char kZeros[kSerialAlignment] = {};
+  uint64_t index_end =
+      sizeof(StoreHeader) + entries.size() * sizeof(IndexEntry);
+  os.write(kZeros, AlignUp(index_end) - index_end);
+  for (const auto &[_, evk] : sorted_keys) serializer.Serialize(os, *evk);
+  AssertTrue(os.good(), "EvkStore: Failed to write " + path);
+}
+
+template <typename word>
+EvkStore<word>::EvkStore(const Parameter<word> &param, const std::string &path,
+                         uint64_t budget_bytes)
+    : serializer_(param), file_(path), budget_bytes_{budget_bytes} {
+  const char *data = static_cast<const char *>(file_.data());
+  size_t size = file_.size();
+  AssertTrue(size >= sizeof(StoreHeader), "EvkStore: Invalid file " + path);
+  StoreHeader header;
+  std::memcpy(&header, data, sizeof(StoreHeader));
+  AssertTrue(header.magic == StoreHeader::kMagic &&
+                 header.version == StoreHeader::kVersion,
+             "EvkStore: Not a key store " + path);
+  AssertTrue(header.word_bytes == sizeof(word),
+             "EvkStore: Word size mismatch");
+  uint64_t index_end =
+      sizeof(StoreHeader) + header.num_entries * sizeof(IndexEntry);
+  AssertTrue(header.num_entries >= 0 && index_end <= size,
+             "EvkStore: Truncated index");
+  for (int i = 0; i < header.num_entries; i++) {
+    IndexEntry entry;
+    std::memcpy(&entry, data + sizeof(StoreHeader) + i * sizeof(IndexEntry),
+                sizeof(IndexEntry));
+    AssertTrue(entry.offset + entry.bytes <= size,
+               "EvkStore: Truncated key " + std::to_string(entry.key_idx));
+    AssertTrue(index_.emplace(entry.key_idx, entry).second,
+               "EvkStore: Duplicate key " + std::to_string(entry.key_idx));
+  }
+}
+
+template <typename word>
+typename EvkStore<word>::EvkPtr EvkStore<word>::Find(int key_idx) const {
+  auto found = index_.find(key_idx);
+  if (found == index_.end()) return nullptr;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto resident = resident_.find(key_idx);
+  if (resident != resident_.end()) {
+    stats_.hits++;
+    lru_.splice(lru_.begin(), lru_, resident->second.lru_it);
+    return resident->second.evk;
+  }
+
+  const IndexEntry &entry = found->second;
+  auto evk = std::make_shared<Evk>();
+  const char *data = static_cast<const char *>(file_.data());
+  serializer_.Deserialize(*evk, data + entry.offset, entry.bytes);
+  EvkPtr res = std::move(evk);
+
+  lru_.push_front(key_idx);
+  resident_.emplace(key_idx, Resident{res, entry.bytes, lru_.begin()});
+  resident_bytes_ += entry.bytes;
+  stats_.loads++;
+  Evict();
+  return res;
+}
+
+template <typename word>
+bool EvkStore<word>::Contains(int key_idx) const {
+  return index_.find(key_idx) != index_.end();
+}
+
+template <typename word>
+int EvkStore<word>::GetLevel(int key_idx) const {
+  auto found = index_.find(key_idx);
+  AssertTrue(found != index_.end(),
+             "EvkStore: Key not found for index " + std::to_string(key_idx));
+  return found->second.level;
+}
+
+template <typename word>
+void EvkStore<word>::SetBudget(uint64_t budget_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  budget_bytes_ = budget_bytes;
+  Evict();
+}
+
+template <typename word>
+uint64_t EvkStore<word>::GetBudget() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return budget_bytes_;
+}
+
+template <typename word>
+uint64_t EvkStore<word>::GetResidentBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resident_bytes_;
+}
+
+template <typename word>
+typename EvkStore<word>::Stats EvkStore<word>::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+template <typename word>
+void EvkStore<word>::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    auto resident = resident_.find(*it);
+    if (IsPinned(resident->second)) {
+      it++;
+      continue;
+    }
+    resident_bytes_ -= resident->second.bytes;
+    resident_.erase(resident);
+    it = lru_.erase(it);
+  }
+}
+
+template <typename word>
+bool EvkStore<word>::IsPinned(const Resident &resident) {
+  return resident.evk.use_count() > 1;
+}
+
+template <typename word>
+void EvkStore<word>::Evict() const {
+  // From the least recently used key, skipping the pinned ones
+  auto it = lru_.end();
+  while (resident_bytes_ > budget_bytes_ && it != lru_.begin()) {
+    it--;
+    auto resident = resident_.find(*it);
+    if (IsPinned(resident->second)) continue;
+    resident_bytes_ -= resident->second.bytes;
+    resident_.erase(resident);
+    it = lru_.erase(it);
+    stats_.evictions++;
+  }
+}
+
+template class EvkStore<uint32_t>;
+template class EvkStore<uint64_t>;
+
+}  // namespace cheddar
@@ -0,0 +1,188 @@
+#include "core/HostStagingPool.h"
+
+#include <sys/mman.h>
+
+#include <cstdlib>
+#include <iterator>
+#include <string>
+
+#include "common/AlignedAllocator.h"
+#include "common/Assert.h"
+
+namespace cheddar {
+
+HostStagingPool &HostStagingPool::Global() {
+  // Never destroyed, as static HostVectors may be freed after this.
+  static HostStagingPool *pool = new HostStagingPool();
+  return *pool;
+}
+
+size_t HostStagingPool::GetClassSize(size_t bytes) {
+  if (bytes <= kMinClassSize) return kMinClassSize;
+  // Four classes per power of two: 2^k * {1, 1.25, 1.5, 1.75}
+  size_t base = kMinClassSize;
+  while (base * 2 < bytes) base *= 2;
+  size_t step = base / 4;
+  return (bytes + step - 1) / step * step;
+}
+
+HostStagingPool::HostStagingPool() {
+#ifndef USE_CPU_BACKEND
+  int num_devices = 0;
+  pinned_available_ =
+      (cudaGetDeviceCount(&num_devices) == cudaSuccess && num_devices > 0);
+  if (!pinned_available_) cudaGetLastError();
+#endif
+}
+
+void *HostStagingPool::AllocateUpstream(Block &block) {
+  void *ptr = nullptr;
+#ifndef USE_CPU_BACKEND
+  block.pending = false;
+  if (pinned_available_) {
+    if (cudaMallocHost(&ptr, block.size) == cudaSuccess) {
+      block.pinned = true;
+      cudaEventCreateWithFlags(&block.event, cudaEventDisableTiming);
+      return ptr;
+    }
+    // Fall back to pageable memory (e.g., the pinned memory limit is hit).
+    cudaGetLastError();
+  }
+#endif
+  block.pinned = false;
+  if (block.size < kHugePageSize) return AlignedAlloc(block.size);
+
+  size_t padded_size =
+      (block.size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  ptr = std::aligned_alloc(kHugePageSize, padded_size);
+  AssertTrue(ptr != nullptr, "HostStagingPool: Out of host memory while "
+                             "allocating " + std::to_string(block.size) +
+                             " bytes");
+#ifdef MADV_HUGEPAGE
+  // Only a hint; ignored where transparent huge pages are disabled
+  madvise(ptr, padded_size, MADV_HUGEPAGE);
+#endif
+  return ptr;
+}
+
+void HostStagingPool::FreeUpstream(void *ptr, const Block &block) {
+#ifndef USE_CPU_BACKEND
+  if (block.pinned) {
+    if (block.pending) cudaEventSynchronize(block.event);
+    cudaEventDestroy(block.event);
+    cudaFreeHost(ptr);
+    return;
+  }
+#endif
+  std::free(ptr);
+}
+
+void *HostStagingPool::TakeFreeLocked(size_t size) {
+  auto free_list = free_lists_.find(size);
+  if (free_list == free_lists_.end()) return nullptr;
+  auto &ptrs = free_list->second;
+  // The most recently freed buffers are tried first.
+  for (auto it = ptrs.rbegin(); it != ptrs.rend(); ++it) {
+    void *ptr = *it;
+#ifndef USE_CPU_BACKEND
+    Block &block = blocks_.at(ptr);
+    if (block.pending) {
+      if (cudaEventQuery(block.event) != cudaSuccess) continue;
+      block.pending = false;
+    }
+#endif
+    ptrs.erase(std::next(it).base());
+    cached_bytes_ -= size;
+    return ptr;
+  }
+  // All the buffers of this size class are still being transferred.
+  return nullptr;
+}
+
+void *HostStagingPool::Allocate(size_t bytes) {
+  if (bytes == 0) return nullptr;
+  size_t size = GetClassSize(bytes);
+  std::unique_lock<std::mutex> lock(mutex_);
+  void *ptr = TakeFreeLocked(size);
+  if (ptr != nullptr) return ptr;
+  lock.unlock();
+
+  Block block{};
+  block.size = size;
+  ptr = AllocateUpstream(block);
+  lock.lock();
+  blocks_.emplace(ptr, block);
+  return ptr;
+}
+
+void HostStagingPool::Deallocate(void *ptr, size_t bytes) {
+  if (ptr == nullptr) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto block = blocks_.find(ptr);
+  AssertTrue(
+      block != blocks_.end() && block->second.size == GetClassSize(bytes),
+      "HostStagingPool: Invalid deallocation");
+  size_t size = block->second.size;
+  if (size > cache_limit_) {
+    FreeUpstream(ptr, block->second);
+    blocks_.erase(block);
+    return;
+  }
+  free_lists_[size].push_back(ptr);
+  cached_bytes_ += size;
+  TrimLocked(cache_limit_);
+}
+
+#ifndef USE_CPU_BACKEND
+void HostStagingPool::RecordTransfer(const void *ptr, cudaStream_t stream) {
+  if (ptr == nullptr) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto block = blocks_.find(const_cast<void *>(ptr));
+  AssertTrue(block != blocks_.end(),
+             "HostStagingPool: Transfer from an unknown buffer");
+  Block &b = block->second;
+  if (!b.pinned) return;
+  // One event per buffer: when a transfer is still pending (possibly on
+  // another stream), the event is recorded after both transfers.
+  if (b.pending) cudaStreamWaitEvent(stream, b.event, 0);
+  cudaEventRecord(b.event, stream);
+  b.pending = true;
+}
+#endif
+
+void HostStagingPool::TrimLocked(size_t limit) {
+  // Larger buffers are freed first.
+  for (auto free_list = free_lists_.rbegin();
+       free_list != free_lists_.rend() && cached_bytes_ > limit;
+       ++free_list) {
+    auto &ptrs = free_list->second;
+    while (!ptrs.empty() && cached_bytes_ > limit) {
+      void *ptr = ptrs.back();
+      ptrs.pop_back();
+      auto block = blocks_.find(ptr);
+      cached_bytes_ -= block->second.size;
+      FreeUpstream(ptr, block->second);
+      blocks_.erase(block);
+    }
+  }
+}
+
+void HostStagingPool::Release() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TrimLocked(0);
+}
+
+void HostStagingPool::SetCacheLimit(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_limit_ = bytes;
+  TrimLocked(cache_limit_);
+}
+
+size_t HostStagingPool::GetCachedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+bool HostStagingPool::IsPinned() const { return pinned_available_; }
+
+}  // namespace cheddar
@@ -0,0 +1,41 @@
+#include "core/MemoryFootprint.h"
+
+#include <iomanip>
+
+namespace cheddar {
+
+size_t MemoryFootprint::GetTableBytes() const {
+  return twiddle_bytes + mod_switch_bytes + other_table_bytes;
+}
+
+size_t MemoryFootprint::GetEvkBytes() const {
+  size_t res = 0;
+  for (const auto &[_, bytes] : evk_bytes) res += bytes;
+  return res;
+}
+
+size_t MemoryFootprint::GetTotalBytes() const {
+  return GetTableBytes() + boot_plaintext_bytes + GetEvkBytes() +
+         peak_temporary_bytes;
+}
+
+void MemoryFootprint::Dump(std::ostream &os) const {
+  constexpr double kMB = 1 << 20;
+  auto print_row = [&](const char *name, size_t bytes) {
+    os << std::setw(20) << name << std::setw(14) << bytes / kMB << " MB"
+       << std::endl;
+  };
+  auto flags = os.flags();
+  os << std::fixed << std::setprecision(2);
+  print_row("twiddle factors", twiddle_bytes);
+  print_row("mod switch", mod_switch_bytes);
+  print_row("other tables", other_table_bytes);
+  print_row("boot plaintexts", boot_plaintext_bytes);
+  print_row("evaluation keys", GetEvkBytes());
+  print_row("peak temporaries", peak_temporary_bytes);
+  print_row("total", GetTotalBytes());
+  os << "(" << evk_bytes.size() << " evaluation keys)" << std::endl;
+  os.flags(flags);
+}
+
+}  // namespace cheddar
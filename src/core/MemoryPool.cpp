@@ -1,10 +1,296 @@
 #include "core/MemoryPool.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "common/Assert.h"
+
 namespace cheddar {
 
+namespace {
+
+// The live pools in the order of their construction
+std::mutex &LivePoolsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<MemoryPool *> &LivePools() {
+  static std::vector<MemoryPool *> pools;
+  return pools;
+}
+
+}  // namespace
+
+namespace detail {
+
+void MemoryStatsRecorder::AddBin(size_t bin_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto &bins = stats_.bins;
+  auto bin = std::lower_bound(
+      bins.begin(), bins.end(), bin_size,
+      [](const MemoryBinStats &a, size_t size) { return a.bin_size < size; });
+  if (bin != bins.end() && bin->bin_size == bin_size) return;
+  MemoryBinStats new_bin;
+  new_bin.bin_size = bin_size;
+  bins.insert(bin, new_bin);
+}
+
+MemoryBinStats &MemoryStatsRecorder::FindBin(size_t bytes) {
+  // The same rule as the binning resources: the smallest bin that fits
+  auto &bins = stats_.bins;
+  auto bin = std::lower_bound(
+      bins.begin(), bins.end(), bytes,
+      [](const MemoryBinStats &a, size_t size) { return a.bin_size < size; });
+  return (bin == bins.end()) ? stats_.fall_through : *bin;
+}
+
+void MemoryStatsRecorder::RecordAllocate(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tracing_) trace_.events.push_back(static_cast<int64_t>(bytes));
+  live_by_size_[bytes]++;
+  MemoryBinStats &bin = FindBin(bytes);
+  bin.num_allocations++;
+  bin.num_live++;
+  bin.live_bytes += bytes;
+  bin.peak_live_bytes = std::max(bin.peak_live_bytes, bin.live_bytes);
+  stats_.live_bytes += bytes;
+  stats_.peak_live_bytes = std::max(stats_.peak_live_bytes, stats_.live_bytes);
+  stats_.live_binned_bytes += (bin.bin_size == 0) ? bytes : bin.bin_size;
+}
+
+void MemoryStatsRecorder::RecordDeallocate(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tracing_) trace_.events.push_back(-static_cast<int64_t>(bytes));
+  auto live = live_by_size_.find(bytes);
+  if (live != live_by_size_.end() && --live->second == 0) {
+    live_by_size_.erase(live);
+  }
+  MemoryBinStats &bin = FindBin(bytes);
+  bin.num_live--;
+  bin.live_bytes -= bytes;
+  stats_.live_bytes -= bytes;
+  stats_.live_binned_bytes -= (bin.bin_size == 0) ? bytes : bin.bin_size;
+}
+
+void MemoryStatsRecorder::RecordUpstreamAllocate(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.num_upstream_allocations++;
+  stats_.upstream_live_bytes += bytes;
+  stats_.upstream_peak_bytes =
+      std::max(stats_.upstream_peak_bytes, stats_.upstream_live_bytes);
+}
+
+void MemoryStatsRecorder::RecordUpstreamDeallocate(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.upstream_live_bytes -= bytes;
+}
+
+MemoryPoolStats MemoryStatsRecorder::Get() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void MemoryStatsRecorder::ResetPeak() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &bin : stats_.bins) bin.peak_live_bytes = bin.live_bytes;
+  stats_.fall_through.peak_live_bytes = stats_.fall_through.live_bytes;
+  stats_.peak_live_bytes = stats_.live_bytes;
+  stats_.upstream_peak_bytes = stats_.upstream_live_bytes;
+}
+
+void MemoryStatsRecorder::StartTrace() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tracing_ = true;
+  trace_.events.clear();
+  for (const auto &[size, count] : live_by_size_) {
+    trace_.events.insert(trace_.events.end(), count,
+                         static_cast<int64_t>(size));
+  }
+}
+
+MemoryTrace MemoryStatsRecorder::StopTrace() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AssertTrue(tracing_, "MemoryPool: Not tracing");
+  tracing_ = false;
+  return std::move(trace_);
+}
+
+}  // namespace detail
+
+namespace {
+
+// The allocations and deallocations of a range of sizes: (time, +1 or -1)
+using SizeEvents = std::vector<std::pair<int64_t, int>>;
+
+int GetPeakLive(const SizeEvents &events) {
+  int live = 0;
+  int peak = 0;
+  for (const auto &[_, delta] : events) {
+    // Deallocations of the requests made before the trace are ignored.
+    live = std::max(0, live + delta);
+    peak = std::max(peak, live);
+  }
+  return peak;
+}
+
+SizeEvents MergeEvents(const SizeEvents &a, const SizeEvents &b) {
+  SizeEvents res(a.size() + b.size());
+  std::merge(a.begin(), a.end(), b.begin(), b.end(), res.begin());
+  return res;
+}
+
+}  // namespace
+
+MemoryBinConfig MemoryBinConfig::FromTrace(
+    const MemoryTrace &trace,
+    int max_num_bins /*= kDefaultMaxNumBins*/) {
+  AssertTrue(max_num_bins > 0, "MemoryBinConfig: Invalid max_num_bins");
+  std::map<size_t, SizeEvents> events_by_size;
+  int64_t time = 0;
+  for (int64_t event : trace.events) {
+    size_t size = static_cast<size_t>(event > 0 ? event : -event);
+    events_by_size[size].emplace_back(time++, event > 0 ? 1 : -1);
+  }
+
+  // Start with a bin per size, then merge adjacent bins.
+  struct Group {
+    size_t size;
+    int peak;
+    SizeEvents events;
+
+    size_t GetCost() const { return size * peak; }
+  };
+  std::vector<Group> groups;
+  for (auto &[size, events] : events_by_size) {
+    int peak = GetPeakLive(events);
+    groups.push_back(Group{size, peak, std::move(events)});
+  }
+  while (groups.size() > 1) {
+    int best = -1;
+    int best_peak = 0;
+    int64_t best_delta = 0;
+    for (size_t i = 0; i + 1 < groups.size(); i++) {
+      int peak = GetPeakLive(MergeEvents(groups[i].events,
+                                         groups[i + 1].events));
+      int64_t delta = static_cast<int64_t>(groups[i + 1].size * peak) -
+                      static_cast<int64_t>(groups[i].GetCost() +
+                                           groups[i + 1].GetCost());
+      if (best < 0 || delta < best_delta) {
+        best = i;
+        best_peak = peak;
+        best_delta = delta;
+      }
+    }
+    bool too_many = static_cast<int>(groups.size()) > max_num_bins;
+    if (best_delta >= 0 && !too_many) break;
+    groups[best + 1].peak = best_peak;
+    groups[best + 1].events =
+        MergeEvents(groups[best].events, groups[best + 1].events);
+    groups.erase(groups.begin() + best);
+  }
+
+  MemoryBinConfig config;
+  for (const auto &group : groups) {
+    config.bins.push_back(Bin{group.size, group.peak});
+  }
+  return config;
+}
+
+MemoryBinConfig MemoryBinConfig::Load(const std::string &path) {
+  std::ifstream is(path);
+  AssertTrue(is.is_open(), "MemoryBinConfig: Cannot open " + path);
+  MemoryBinConfig config;
+  std::string line;
+  while (std::getline(is, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    Bin bin;
+    AssertTrue(static_cast<bool>(fields >> bin.size >> bin.num_reserved) &&
+                   bin.size > 0 && bin.num_reserved >= 0,
+               "MemoryBinConfig: Invalid line \"" + line + "\" in " + path);
+    AssertTrue(config.bins.empty() || config.bins.back().size < bin.size,
+               "MemoryBinConfig: Bins should be in the increasing order");
+    config.bins.push_back(bin);
+  }
+  return config;
+}
+
+void MemoryBinConfig::Save(const std::string &path) const {
+  std::ofstream os(path, std::ios::trunc);
+  AssertTrue(os.is_open(), "MemoryBinConfig: Cannot open " + path);
+  os << "# bin size (bytes), number of reserved blocks" << std::endl;
+  for (const auto &bin : bins) {
+    os << bin.size << " " << bin.num_reserved << std::endl;
+  }
+  AssertTrue(os.good(), "MemoryBinConfig: Failed to write " + path);
+}
+
+size_t MemoryBinConfig::GetReservedBytes() const {
+  size_t res = 0;
+  for (const auto &bin : bins) res += bin.size * bin.num_reserved;
+  return res;
+}
+
+double MemoryPoolStats::GetFragmentation() const {
+  if (upstream_live_bytes == 0) return 0;
+  return 1.0 - static_cast<double>(live_bytes) / upstream_live_bytes;
+}
+
+void MemoryPoolStats::Dump(std::ostream &os) const {
+  constexpr double kMB = 1 << 20;
+  auto print_row = [&](const std::string &name, const MemoryBinStats &bin) {
+    os << std::setw(14) << name << std::setw(12) << bin.num_allocations
+       << std::setw(10) << bin.num_live << std::setw(14)
+       << bin.live_bytes / kMB << std::setw(14) << bin.peak_live_bytes / kMB
+       << std::endl;
+  };
+  auto flags = os.flags();
+  os << std::fixed << std::setprecision(2);
+  os << std::setw(14) << "bin (bytes)" << std::setw(12) << "allocs"
+     << std::setw(10) << "live" << std::setw(14) << "live (MB)"
+     << std::setw(14) << "peak (MB)" << std::endl;
+  for (const auto &bin : bins) print_row(std::to_string(bin.bin_size), bin);
+  print_row("larger", fall_through);
+  os << "live: " << live_bytes / kMB << " MB (" << live_binned_bytes / kMB
+     << " MB in bins), peak: " << peak_live_bytes / kMB << " MB" << std::endl;
+  os << "upstream: " << upstream_live_bytes / kMB
+     << " MB, peak: " << upstream_peak_bytes / kMB
+     << " MB, allocations: " << num_upstream_allocations << std::endl;
+  os << "fragmentation: " << GetFragmentation() * 100 << "% (rounding: "
+     << (live_binned_bytes - live_bytes) / kMB << " MB, free in bins: "
+     << (upstream_live_bytes - std::min(upstream_live_bytes,
+                                        live_binned_bytes)) / kMB
+     << " MB)" << std::endl;
+  os.flags(flags);
+}
+
+template <typename word>
+MemoryPool::MemoryPool(const Parameter<word> &param,
+                       const MemoryBinConfig *bin_config /*= nullptr*/)
+    : base_(),
+      upstream_stats_(&base_, &recorder_, true),
+      memory_pool_(&upstream_stats_),
+      stats_(&memory_pool_, &recorder_, false) {
+  if (bin_config == nullptr) {
+    AddDefaultBins(param);
+  } else {
+    for (const auto &bin : bin_config->bins) {
+      AddBin(bin.size, bin.num_reserved);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(LivePoolsMutex());
+  LivePools().push_back(this);
+  MakeCurrent();
+}
+
 template <typename word>
-MemoryPool::MemoryPool(const Parameter<word> &param)
-    : base_(), memory_pool_(&base_) {
+void MemoryPool::AddDefaultBins(const Parameter<word> &param) {
   // Hueristically add bins to save memory and speed-up bootstrapping.
   const int degree = param.degree_;
   const int word_size = param.word_size_;
@@ -15,31 +301,92 @@ MemoryPool::MemoryPool(const Parameter<word> &param)
   int next_threshold = limb_size;
   // Should be: 512, 2048, 8192, 32768, 131072
   for (; bin_size < next_threshold; bin_size *= 4) {
-    memory_pool_.add_bin(bin_size);
+    AddBin(bin_size);
   }
   bin_size = next_threshold;
   int chunk_size = param.alpha_ * limb_size;
   for (; bin_size < chunk_size; bin_size *= 2) {
     // Maybe one more bin will be added
-    memory_pool_.add_bin(bin_size);
+    AddBin(bin_size);
   }
   // Finally, about dnum additional bins;
   bin_size = chunk_size;
   int max_size = (param.L_ + param.alpha_) * limb_size;
   for (; bin_size < max_size; bin_size += chunk_size) {
-    memory_pool_.add_bin(bin_size);
+    AddBin(bin_size);
   }
-  memory_pool_.add_bin(max_size);
-
-  rmm::mr::set_current_device_resource(&memory_pool_);
+  AddBin(max_size);
 }
 
 MemoryPool::~MemoryPool() {
+  std::lock_guard<std::mutex> lock(LivePoolsMutex());
+  auto &pools = LivePools();
+  pools.erase(std::find(pools.begin(), pools.end(), this));
+  if (!IsCurrent()) return;
+  if (!pools.empty()) {
+    pools.back()->MakeCurrent();
+    return;
+  }
   // reset to cuda_device_resource
+#ifdef USE_CPU_BACKEND
+  SetCurrentHostMemoryResource(nullptr);
+#else
   rmm::mr::set_current_device_resource(nullptr);
+#endif
 }
 
-template MemoryPool::MemoryPool(const Parameter<uint32_t> &param);
-template MemoryPool::MemoryPool(const Parameter<uint64_t> &param);
+void MemoryPool::MakeCurrent() {
+#ifdef USE_CPU_BACKEND
+  SetCurrentHostMemoryResource(&stats_);
+#else
+  rmm::mr::set_current_device_resource(&stats_);
+#endif
+}
+
+bool MemoryPool::IsCurrent() const {
+#ifdef USE_CPU_BACKEND
+  return GetCurrentHostMemoryResource() == &stats_;
+#else
+  return rmm::mr::get_current_device_resource() == &stats_;
+#endif
+}
+
+void MemoryPool::AddBin(size_t bin_size, int num_reserved /*= 0*/) {
+  recorder_.AddBin(bin_size);
+#ifdef USE_CPU_BACKEND
+  memory_pool_.add_bin(bin_size);
+  // Fill the free list of the bin
+  std::vector<void *> blocks;
+  for (int i = 0; i < num_reserved; i++) {
+    blocks.push_back(memory_pool_.allocate(bin_size));
+  }
+  for (void *block : blocks) memory_pool_.deallocate(block, bin_size);
+#else
+  if (num_reserved == 0) {
+    memory_pool_.add_bin(bin_size);
+    return;
+  }
+  // The reserved blocks are allocated from the upstream at once, and the
+  // bin grows by as many blocks when they run out.
+  using FixedSizeResource =
+      rmm::mr::fixed_size_memory_resource<detail::StatsResourceAdaptor>;
+  reserved_bins_.push_back(std::make_unique<FixedSizeResource>(
+      &upstream_stats_, bin_size, num_reserved));
+  memory_pool_.add_bin(bin_size, reserved_bins_.back().get());
+#endif
+}
+
+MemoryPoolStats MemoryPool::GetStats() const { return recorder_.Get(); }
+
+void MemoryPool::ResetPeakStats() const { recorder_.ResetPeak(); }
+
+void MemoryPool::StartTrace() const { recorder_.StartTrace(); }
+
+MemoryTrace MemoryPool::StopTrace() const { return recorder_.StopTrace(); }
+
+template MemoryPool::MemoryPool(const Parameter<uint32_t> &param,
+                                const MemoryBinConfig *bin_config);
+template MemoryPool::MemoryPool(const Parameter<uint64_t> &param,
+                                const MemoryBinConfig *bin_config);
 
 }  // namespace cheddar
\ No newline at end of file
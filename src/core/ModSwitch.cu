@@ -1,12 +1,20 @@
 #include <algorithm>
+#include <vector>
 
 #include "common/Assert.h"
+#ifdef USE_CPU_BACKEND
+#include "common/AlignedAllocator.h"
+#include "common/BasicSimd.h"
+#include "common/ThreadPool.h"
+#else
 #include "common/Basic.cuh"
+#endif
 #include "common/CommonUtils.h"
 #include "common/ConstantMemory.cuh"
 #include "common/DoubleWord.h"
 #include "common/PrimeUtils.h"
 #include "core/ModSwitch.h"
+#include "core/Workspace.h"
 
 // kernel constants
 #define kUnrollNumber 4
@@ -20,6 +28,95 @@
 namespace cheddar {
 namespace kernel {
 
+#ifdef USE_CPU_BACKEND
+// Host version of the kernel below. The base conversion is a small matrix
+// (dst_len x src_len bconv_table) times a large matrix (src_len x degree src)
+// product, which we block over coefficients: each task takes a tile of
+// kHostTileSize coefficients of every src limb, which stays in L1, and
+// produces the same tile of every dst limb, kLimbBatching dst limbs at a
+// time. Partial sums are accumulated lazily in double words and normalized
+// with the same schedule (every kMaxNumAccum terms) as the kernel, using the
+// wide operations of basic::simd. inv_primes is unused, as basic::Modulus
+// carries its own constants.
+constexpr int kHostTileSize = 256;
+
+template <typename word>
+void ModSwitchMatrixMult(word *dst, const word *primes,
+                         const make_signed_t<word> *inv_primes,
+                         const int src_len, const int dst_len,
+                         const int skip_start, const int skip_end,
+                         const make_signed_t<word> *src,
+                         const make_signed_t<word> *bconv_table) {
+  using signed_word = make_signed_t<word>;
+  using signed_d_word = make_signed_double_word_t<word>;
+  // Only the 32-bit version needs intermediate normalization
+  constexpr bool kNormalize = std::is_same_v<word, uint32_t>;
+
+  int log_degree = cm_log_degree();
+  int degree = 1 << log_degree;
+  int tile_size = Min(degree, kHostTileSize);
+  std::vector<basic::Modulus<word>> moduli;
+  moduli.reserve(dst_len);
+  for (int k = 0; k < dst_len; k++) {
+    int prime_index = k;
+    if (prime_index >= skip_start) prime_index += (skip_end - skip_start);
+    moduli.emplace_back(primes[prime_index]);
+  }
+
+  ThreadPool::Global().ParallelFor(0, degree / tile_size, [&](int tile) {
+    int x_offset = tile * tile_size;
+    alignas(kHostAlignment) signed_d_word accum[kLimbBatching][kHostTileSize];
+
+    for (int k_start = 0; k_start < dst_len; k_start += kLimbBatching) {
+      int num_rows = Min(kLimbBatching, dst_len - k_start);
+      int prime_indices[kLimbBatching];
+      signed_d_word prime_th[kLimbBatching];
+      for (int r = 0; r < num_rows; r++) {
+        int prime_index = k_start + r;
+        if (prime_index >= skip_start) {
+          prime_index += (skip_end - skip_start);
+        }
+        prime_indices[r] = prime_index;
+        prime_th[r] = primes[prime_index];
+        prime_th[r] <<= (sizeof(word) * 8);
+        std::fill_n(accum[r], tile_size, 0);
+      }
+
+      for (int i = 0; i < src_len; i++) {
+        const signed_word *src_tile = src + (i << log_degree) + x_offset;
+        for (int r = 0; r < num_rows; r++) {
+          basic::simd::MultAccumWide<word>(
+              accum[r], src_tile, bconv_table[(k_start + r) * src_len + i],
+              tile_size);
+        }
+        if constexpr (kNormalize) {
+          if ((i + 1) % kMaxNumAccum == 0) {
+            for (int r = 0; r < num_rows; r++) {
+              basic::simd::NormalizeWide<word>(accum[r], prime_th[r],
+                                               tile_size);
+            }
+          }
+        }
+      }
+
+      for (int r = 0; r < num_rows; r++) {
+        // The remainder after the last normalization may exceed the input
+        // range of the Montgomery reduction
+        if constexpr (kNormalize) {
+          if (src_len % kMaxNumAccum != 0) {
+            basic::simd::NormalizeWide<word>(accum[r], prime_th[r],
+                                             tile_size);
+          }
+        }
+        int prime_index = prime_indices[r];
+        basic::simd::ReduceMontgomeryWide(
+            dst + (prime_index << log_degree) + x_offset, accum[r], tile_size,
+            moduli[k_start + r]);
+      }
+    }
+  });
+}
+#else
 template <typename word>
 __global__ void ModSwitchMatrixMult(word *dst, const word *primes,
                                     const make_signed_t<word> *inv_primes,
@@ -169,6 +266,7 @@ __global__ void ModSwitchMatrixMult(word *dst, const word *primes,
         dst + (prime_index << log_degree) + degree_index, res_tmp);
   }
 }
+#endif
 
 }  // namespace kernel
 
@@ -317,6 +415,59 @@ ModSwitchHandler<word>::ModSwitchHandler(
   }
 }
 
+template <typename word>
+size_t ModSwitchHandler<word>::GetConstantBytes(const Parameter<word> &param,
+                                                int level) {
+  // The sizes of the constants populated by the constructor
+  int num_aux = level == -1 ? param.GetSSENumAux() : param.alpha_;
+  int beta = level == -1 ? 1
+                         : DivCeil(param.LevelToNP(level).num_main_ +
+                                       param.GetMaxNumTer(),
+                                   num_aux);
+  NPInfo np = param.LevelToNP(level, num_aux);
+  int num_q_primes = np.GetNumQ();
+  int num_total_primes = np.GetNumTotal();
+  int padded_num_q_primes = np.num_main_ + param.GetMaxNumTer();
+  if (level == -1) padded_num_q_primes = num_q_primes;
+  int num_pad = padded_num_q_primes - num_q_primes;
+
+  // PopulateModSwitchConstants and PopulateModDownEpilogueConstants
+  auto mod_switch_size = [](size_t src_len, size_t dst_len) {
+    return src_len + src_len * dst_len;
+  };
+  auto epilogue_size = [](size_t dst_len, size_t restore_len) {
+    return dst_len + (kFuseModDownEpilogue ? dst_len - restore_len : 0);
+  };
+
+  // ModUp constants
+  size_t size = num_q_primes;
+  for (int i = 0; i < beta; i++) {
+    int src_start = i * num_aux;
+    int src_end = Min((i + 1) * num_aux, padded_num_q_primes);
+    if (src_end <= num_pad) continue;
+    int src_len = src_end - Max(num_pad, src_start);
+    size += static_cast<size_t>(src_len) * (num_total_primes - src_len);
+  }
+
+  // ModDown constants (the epilogue padding is not kept)
+  size += mod_switch_size(num_aux, num_q_primes) + num_q_primes;
+  if (level == -1 || level == 0) return size * sizeof(word);
+
+  // Rescale and ModDownAndRescale constants
+  NPInfo next_np = param.LevelToNP(level - 1, num_aux);
+  int next_num_q_primes = next_np.GetNumQ();
+  int main_diff = np.num_main_ - next_np.num_main_;
+  int ter_diff = np.num_ter_ - next_np.num_ter_;
+  int rescale_len = (ter_diff > 0) ? ter_diff : main_diff;
+  int restore_len = (ter_diff > 0) ? -main_diff : -ter_diff;
+  size += mod_switch_size(rescale_len, next_num_q_primes) +
+          epilogue_size(next_num_q_primes, restore_len);
+  size += mod_switch_size(rescale_len + num_aux, next_num_q_primes) +
+          epilogue_size(next_num_q_primes, restore_len);
+  if (!kFuseModDownEpilogue) size += num_total_primes;
+  return size * sizeof(word);
+}
+
 template <typename word>
 void ModSwitchHandler<word>::PopulateModSwitchConstants(
     DeviceVector<word> &const1, DeviceVector<make_signed_t<word>> &const2,
@@ -439,7 +590,8 @@ void ModSwitchHandler<word>::ModUp(std::vector<DvView<word>> &dst,
   AssertTrue(static_cast<int>(dst.size()) == beta_, "ModUp dst size mismatch");
 
   // Do NTT
-  DeviceVector<word> src_intt(num_q_primes * degree);
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  DeviceVector<word> &src_intt = scope.TakeDv(num_q_primes * degree);
   DvView<word> src_intt_view = src_intt.View(0, 0);
   ntt_handler_.INTTAndMultConst(src_intt_view, np, src,
                                 mod_up1_.ConstView(0, 0), true);
@@ -487,6 +639,15 @@ void ModSwitchHandler<word>::ModUp(std::vector<DvView<word>> &dst,
     int dst_len = num_q_primes - src_len + num_aux_;
     DvView<word> &dst_i = dst.at(i);
 
+    const signed_word *src_ptr = reinterpret_cast<const signed_word *>(
+        src_intt.data() + prime_index_start * degree);
+
+#ifdef USE_CPU_BACKEND
+    kernel::ModSwitchMatrixMult<word>(dst_i.data(), primes, inv_primes,
+                                      src_len, dst_len, prime_index_start,
+                                      prime_index_end, src_ptr,
+                                      mod_up2_.at(i).data());
+#else
     dim3 grid_dim(degree / kUnrollNumber / kNumThreadsX,
                   DivCeil(dst_len, kLimbBatching * kNumThreadsY));
     dim3 block_dim(kNumThreadsX, kNumThreadsY);
@@ -497,12 +658,10 @@ void ModSwitchHandler<word>::ModUp(std::vector<DvView<word>> &dst,
     smem_size +=
         kMaxNumAccum * (kUnrollNumber * kNumThreadsX) * sizeof(signed_word);
 
-    const signed_word *src_ptr = reinterpret_cast<const signed_word *>(
-        src_intt.data() + prime_index_start * degree);
-
     kernel::ModSwitchMatrixMult<word><<<grid_dim, block_dim, smem_size>>>(
         dst_i.data(), primes, inv_primes, src_len, dst_len, prime_index_start,
         prime_index_end, src_ptr, mod_up2_.at(i).data());
+#endif
     ntt_handler_.NTTForModUp(dst_i, np, prime_index_start, prime_index_end,
                              dst_i);
   }
@@ -594,7 +753,8 @@ void ModSwitchHandler<word>::ModDownWorker(DvView<word> &dst,
           : src;
 
   // Performing INTTForModDown
-  DeviceVector<word> src_intt(src_len * degree);
+  typename Workspace<word>::Scope scope(Workspace<word>::GetActive());
+  DeviceVector<word> &src_intt = scope.TakeDv(src_len * degree);
 
   DvView<word> src_intt_view = src_intt.View(0, 0);
   DvConstView<word> const1 =
@@ -618,6 +778,10 @@ void ModSwitchHandler<word>::ModDownWorker(DvView<word> &dst,
                                            : mod_down_rescale2_.data()));
 
   // Do matrix multiplication
+#ifdef USE_CPU_BACKEND
+  kernel::ModSwitchMatrixMult<word>(dst.data(), primes, inv_primes, src_len,
+                                    dst_len, 0, 0, src_ptr, bconv_table);
+#else
   dim3 grid_dim(degree / kUnrollNumber / kNumThreadsX,
                 DivCeil(dst_len, kLimbBatching * kNumThreadsY));
   dim3 block_dim(kNumThreadsX, kNumThreadsY);
@@ -631,6 +795,7 @@ void ModSwitchHandler<word>::ModDownWorker(DvView<word> &dst,
   kernel::ModSwitchMatrixMult<word><<<grid_dim, block_dim, smem_size>>>(
       dst.data(), primes, inv_primes, src_len, dst_len, 0, 0, src_ptr,
       bconv_table);
+#endif
 
   // Prepare the constants for ModDownEpilogue
   int pad_start = 0;
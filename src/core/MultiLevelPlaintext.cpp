@@ -0,0 +1,84 @@
+#include "core/MultiLevelPlaintext.h"
+
+#include <algorithm>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+template <typename word>
+NPInfo MultiLevelPlaintext<word>::UnionNP(const Parameter<word> &param,
+                                          int min_level, int max_level) {
+  AssertTrue(min_level >= 0 && min_level <= max_level &&
+                 max_level <= param.max_level_,
+             "MultiLevelPlaintext: Invalid level range");
+  NPInfo res;
+  for (int level = min_level; level <= max_level; level++) {
+    NPInfo np = param.LevelToNP(level);
+    res.num_main_ = std::max(res.num_main_, np.num_main_);
+    res.num_ter_ = std::max(res.num_ter_, np.num_ter_);
+  }
+  return res;
+}
+
+template <typename word>
+MultiLevelPlaintext<word>::MultiLevelPlaintext(const Parameter<word> &param,
+                                               int min_level, int max_level,
+                                               Pt &&base)
+    : param_{&param},
+      min_level_{min_level},
+      max_level_{max_level},
+      base_{std::move(base)} {
+  AssertTrue(base_.GetNP() == UnionNP(param, min_level, max_level),
+             "MultiLevelPlaintext: Base plaintext NP mismatch");
+}
+
+template <typename word>
+int MultiLevelPlaintext<word>::GetMaxLevel() const {
+  AssertTrue(param_ != nullptr, "MultiLevelPlaintext: Not initialized.");
+  return max_level_;
+}
+
+template <typename word>
+int MultiLevelPlaintext<word>::GetMinLevel() const {
+  AssertTrue(param_ != nullptr, "MultiLevelPlaintext: Not initialized.");
+  return min_level_;
+}
+
+template <typename word>
+const Plaintext<word> &MultiLevelPlaintext<word>::AtLevel(int level) {
+  AssertTrue(param_ != nullptr, "MultiLevelPlaintext: Not initialized.");
+  AssertTrue(level >= min_level_ && level <= max_level_,
+             "Level does not exist");
+  auto found = level_map_.find(level);
+  if (found != level_map_.end()) return found->second;
+
+  // The primes of the level are q_primes_[max_ter - num_ter, max_ter +
+  // num_main), which is a contiguous range of the primes of base_.
+  NPInfo np = param_->LevelToNP(level);
+  int degree = param_->degree_;
+  int offset = (base_.GetNP().num_ter_ - np.num_ter_) * degree;
+
+  Pt &pt = level_map_.try_emplace(level, np).first->second;
+  pt.SetScale(base_.GetScale());
+  pt.SetNumSlots(base_.GetNumSlots());
+  cudaMemcpyAsync(pt.mx_.data(), base_.mx_.data() + offset,
+                  pt.mx_.size() * sizeof(word), cudaMemcpyDeviceToDevice,
+                  pt.mx_.stream());
+  return pt;
+}
+
+template <typename word>
+bool MultiLevelPlaintext<word>::Exists(int level) const {
+  return param_ != nullptr && level >= min_level_ && level <= max_level_;
+}
+
+template <typename word>
+void MultiLevelPlaintext<word>::Clear() {
+  level_map_.clear();
+}
+
+template class MultiLevelPlaintext<uint32_t>;
+template class MultiLevelPlaintext<uint64_t>;
+
+}  // namespace cheddar
@@ -6,6 +6,7 @@
 #include "common/PtrList.h"
 #include "core/NTT.h"
 #include "core/NTTUtils.cuh"
+#include "core/TableCache.h"
 
 namespace {
 // https://artificial-mind.net/blog/2020/10/31/constexpr-for
@@ -1129,7 +1130,16 @@ void NTTHandler<word>::INTTForModDown(
 
 template <typename word>
 int NTTHandler<word>::GetLsbSize() const {
-  int log_degree = param_.log_degree_;
+  return GetLsbSize(param_.log_degree_);
+}
+
+template <typename word>
+int NTTHandler<word>::GetMsbSize() const {
+  return GetMsbSize(param_.log_degree_);
+}
+
+template <typename word>
+int NTTHandler<word>::GetLsbSize(int log_degree) {
   int lsb_size = 0;
   constexpr_for<min_log_degree_, max_log_degree_ + 1>([&](auto j) {
     if (j == log_degree)
@@ -1140,9 +1150,8 @@ int NTTHandler<word>::GetLsbSize() const {
 }
 
 template <typename word>
-int NTTHandler<word>::GetMsbSize() const {
-  int log_degree = param_.log_degree_;
-  int lsb_size = GetLsbSize();
+int NTTHandler<word>::GetMsbSize(int log_degree) {
+  int lsb_size = GetLsbSize(log_degree);
   return (1 << log_degree) / lsb_size;
 }
 
@@ -1222,12 +1231,38 @@ int NTTHandler<word>::GetBlockDim(NTTType type, Phase phase) const {
 }
 
 template <typename word>
-NTTHandler<word>::NTTHandler(const Parameter<word> &param) : param_(param) {
+NTTHandler<word>::NTTHandler(const Parameter<word> &param,
+                             TableCache *tables /*= nullptr*/)
+    : param_(param) {
   if (!cm_populated_) {
     PopulateConstantMemory(param_);
     cm_populated_ = true;
   }
+  if (tables != nullptr && tables->Load("ntt", GetTables())) return;
   PopulateTwiddleFactors();
+  if (tables != nullptr) tables->Store("ntt", GetTables());
+}
+
+template <typename word>
+size_t NTTHandler<word>::GetTableBytes(const Parameter<word> &param) {
+  // See PopulateTwiddleFactors
+  NPInfo np = param.LevelToNP(param.max_level_, param.alpha_);
+  size_t num_total_primes = np.GetNumTotal();
+  size_t per_prime =
+      2 * param.degree_ + 2 * GetMsbSize(param.log_degree_) + 3;
+  return num_total_primes * per_prime * sizeof(word);
+}
+
+template <typename word>
+std::vector<std::pair<std::string, DeviceVector<word> *>>
+NTTHandler<word>::GetTables() {
+  return {{"twiddle_factors", &twiddle_factors_},
+          {"twiddle_factors_msb", &twiddle_factors_msb_},
+          {"inv_twiddle_factors", &inv_twiddle_factors_},
+          {"inv_twiddle_factors_msb", &inv_twiddle_factors_msb_},
+          {"inv_degree", &inv_degree_},
+          {"inv_degree_mont", &inv_degree_mont_},
+          {"montgomery_converter", &montgomery_converter_}};
 }
 
 template <typename word>
@@ -0,0 +1,736 @@
+#include <vector>
+
+#include "common/Assert.h"
+#include "common/BasicSimd.h"
+#include "common/CommonUtils.h"
+#include "common/PrimeUtils.h"
+#include "common/ThreadPool.h"
+#include "core/NTT.h"
+#include "core/TableCache.h"
+
+namespace cheddar {
+namespace kernel {
+namespace {
+
+constexpr int kWordBits(int word_size) { return word_size * 8; }
+
+/**
+ * @brief Computes the Shoup companion floor(w * 2^word_size / q) of a
+ * constant w in [0, q).
+ */
+template <typename word>
+word ShoupPrecompute(const word w, const word q) {
+  make_double_word_t<word> t = w;
+  t <<= kWordBits(sizeof(word));
+  return static_cast<word>(t / q);
+}
+
+/**
+ * @brief Computes a * w mod q in [0, 2q) for any a in [0, 2^word_size) using
+ * the precomputed w_pre = ShoupPrecompute(w, q).
+ */
+template <typename word>
+__attribute__((always_inline)) inline word MultShoupLazy(const word a,
+                                                         const word w,
+                                                         const word w_pre,
+                                                         const word q) {
+  using dword = make_double_word_t<word>;
+  word hi = static_cast<word>((static_cast<dword>(a) * w_pre) >>
+                              kWordBits(sizeof(word)));
+  return a * w - hi * q;
+}
+
+// [0, 2q) --> [0, q), branch-free (a - q wraps around if a < q)
+template <typename word>
+__attribute__((always_inline)) inline word ReduceOnce(const word a,
+                                                      const word q) {
+  word b = a - q;
+  return b < a ? b : a;
+}
+
+// [-q, q) as a signed word --> [0, q), branch-free (a + q wraps around iff
+// a is negative)
+template <typename word>
+__attribute__((always_inline)) inline word FromSigned(const word a,
+                                                      const word q) {
+  word b = a + q;
+  return b < a ? b : a;
+}
+
+/**
+ * @brief Computes a = a + bw, b = a - bw
+ *
+ * @param a in range [0, 2q), output in range [0, 2q)
+ * @param b any number, output in range [0, 2q)
+ */
+template <typename word>
+__attribute__((always_inline)) inline void ButterflyNTT(word &a, word &b,
+                                                        const word w,
+                                                        const word w_pre,
+                                                        const word q) {
+  word u = ReduceOnce(a, q);
+  word v = ReduceOnce(MultShoupLazy(b, w, w_pre, q), q);
+  a = u + v;
+  b = u - v + q;
+}
+
+/**
+ * @brief Computes a = a + b, b = (a - b)w
+ *
+ * @param a in range [0, 2q), output in range [0, 2q)
+ * @param b in range [0, 2q), output in range [0, 2q)
+ */
+template <typename word>
+__attribute__((always_inline)) inline void ButterflyINTT(word &a, word &b,
+                                                         const word w,
+                                                         const word w_pre,
+                                                         const word q) {
+  word u = ReduceOnce(a, q);
+  word v = ReduceOnce(b, q);
+  a = u + v;
+  b = MultShoupLazy(u - v + q, w, w_pre, q);
+}
+
+// The butterflies of the last (NTT) or first (INTT) kTileLogSize stages stay
+// within blocks of kTileSize consecutive coefficients, which is too short for
+// vectorizing along the coefficients. Instead, kTileSize such blocks are
+// transposed into a tile and processed with one block per vector lane. The
+// twiddle factors of these stages are stored permuted (refer to
+// PermuteTileTwiddleFactors) so that the lanes read them contiguously.
+constexpr int kTileLogSize = 4;
+constexpr int kTileSize = 1 << kTileLogSize;
+
+/**
+ * @brief Index of the twiddle factor for group g of block b in the stage with
+ * m groups (m >= degree / kTileSize) after permutation.
+ */
+inline int TileTwiddleIndex(int m, int degree, int b, int g) {
+  int num_groups_per_block = m / (degree / kTileSize);
+  int chunk = b / kTileSize;
+  int lane = b % kTileSize;
+  return m + (chunk * num_groups_per_block + g) * kTileSize + lane;
+}
+
+/**
+ * @brief Permutes the entries [degree / kTileSize, degree) of a bit-reversed
+ * twiddle factor table into the order used by the tile stages. Entries below
+ * degree / kTileSize are used by the regular stages and left as they are.
+ */
+template <typename word>
+void PermuteTileTwiddleFactors(word *tw, int degree) {
+  std::vector<word> orig(tw, tw + degree);
+  for (int m = degree / kTileSize; m < degree; m <<= 1) {
+    int num_groups_per_block = m / (degree / kTileSize);
+    for (int b = 0; b < degree / kTileSize; b++) {
+      for (int g = 0; g < num_groups_per_block; g++) {
+        tw[TileTwiddleIndex(m, degree, b, g)] =
+            orig[m + b * num_groups_per_block + g];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Converts a constant c in Montgomery form to the standard form
+ * c * 2^(-word_size) mod q, i.e., the value a Montgomery multiplication with
+ * c actually multiplies by.
+ */
+template <typename word>
+word FromMontgomery(const word c, const word q,
+                    const make_signed_t<word> q_inv) {
+  using signed_word = make_signed_t<word>;
+  using signed_dword = make_signed_double_word_t<word>;
+  signed_word temp = static_cast<signed_word>(c) * q_inv;
+  signed_word hi = static_cast<signed_word>(
+      (static_cast<signed_dword>(temp) * static_cast<signed_word>(q)) >>
+      kWordBits(sizeof(word)));
+  signed_word res = -hi;
+  if (res < 0) res += q;
+  return static_cast<word>(res);
+}
+
+/**
+ * @brief Negacyclic Cooley-Tukey NTT of a single limb with Harvey's lazy
+ * butterflies. The twiddle factors are indexed in the same bit-reversed order
+ * as the GPU kernels. Values are kept in [0, 2q) between stages so that
+ * 31-bit primes also work with 32-bit words. dst and src may alias.
+ *
+ * @param dst output in range [0, q)
+ * @param src input in range [-q, q) (as signed words)
+ * @param pre_mult if non-zero, src is first multiplied by this constant
+ */
+template <typename word>
+CHEDDAR_HOST_TARGET_CLONES void ForwardNTTLimb(
+    word *dst, const word *src, const word *tw, const word *tw_pre,
+    int log_degree, const word q, const word pre_mult,
+    const word pre_mult_pre) {
+  int degree = 1 << log_degree;
+  if (pre_mult != 0) {
+    for (int j = 0; j < degree; j++) {
+      dst[j] = MultShoupLazy(FromSigned(src[j], q), pre_mult, pre_mult_pre, q);
+    }
+  } else {
+    for (int j = 0; j < degree; j++) {
+      dst[j] = FromSigned(src[j], q);
+    }
+  }
+
+  int m = 1;
+  for (int t = degree >> 1; t >= kTileSize; m <<= 1, t >>= 1) {
+    for (int i = 0; i < m; i++) {
+      word w = tw[m + i];
+      word w_pre = tw_pre[m + i];
+      word *__restrict__ x = dst + 2 * i * t;
+      word *__restrict__ y = x + t;
+      for (int j = 0; j < t; j++) {
+        ButterflyNTT(x[j], y[j], w, w_pre, q);
+      }
+    }
+  }
+
+  // Tile stages (m = degree / kTileSize here)
+  alignas(64) word tile[kTileSize][kTileSize];
+  int num_chunks = degree / (kTileSize * kTileSize);
+  for (int c = 0; c < num_chunks; c++) {
+    word *chunk = dst + c * kTileSize * kTileSize;
+    for (int l = 0; l < kTileSize; l++) {
+      for (int r = 0; r < kTileSize; r++) {
+        tile[r][l] = chunk[l * kTileSize + r];
+      }
+    }
+    for (int t = kTileSize / 2, stage_m = m; t >= 1; t >>= 1, stage_m <<= 1) {
+      int num_groups_per_block = kTileSize / (2 * t);
+      int tw_offset = stage_m + c * num_groups_per_block * kTileSize;
+      for (int g = 0; g < num_groups_per_block; g++) {
+        const word *w = tw + tw_offset + g * kTileSize;
+        const word *w_pre = tw_pre + tw_offset + g * kTileSize;
+        for (int j = 0; j < t; j++) {
+          word *__restrict__ x = tile[2 * g * t + j];
+          word *__restrict__ y = tile[2 * g * t + j + t];
+          for (int l = 0; l < kTileSize; l++) {
+            ButterflyNTT(x[l], y[l], w[l], w_pre[l], q);
+          }
+        }
+      }
+    }
+    for (int l = 0; l < kTileSize; l++) {
+      for (int r = 0; r < kTileSize; r++) {
+        chunk[l * kTileSize + r] = ReduceOnce(tile[r][l], q);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Negacyclic Gentleman-Sande INTT of a single limb (without the 1/N
+ * scaling), followed by a multiplication with post_mult. dst and src may
+ * alias.
+ *
+ * @param dst output in range [0, q), or in [-(q-1)/2, (q-1)/2] (as signed
+ * words) if normalize is set
+ * @param src input in range [-q, q) (as signed words)
+ */
+template <typename word>
+CHEDDAR_HOST_TARGET_CLONES void InverseNTTLimb(
+    word *dst, const word *src, const word *tw, const word *tw_pre,
+    int log_degree, const word q, const word post_mult,
+    const word post_mult_pre, bool normalize) {
+  int degree = 1 << log_degree;
+
+  // Tile stages
+  alignas(64) word tile[kTileSize][kTileSize];
+  int num_chunks = degree / (kTileSize * kTileSize);
+  for (int c = 0; c < num_chunks; c++) {
+    const word *src_chunk = src + c * kTileSize * kTileSize;
+    for (int l = 0; l < kTileSize; l++) {
+      for (int r = 0; r < kTileSize; r++) {
+        tile[r][l] = FromSigned(src_chunk[l * kTileSize + r], q);
+      }
+    }
+    for (int t = 1, stage_m = degree >> 1; t < kTileSize;
+         t <<= 1, stage_m >>= 1) {
+      int num_groups_per_block = kTileSize / (2 * t);
+      int tw_offset = stage_m + c * num_groups_per_block * kTileSize;
+      for (int g = 0; g < num_groups_per_block; g++) {
+        const word *w = tw + tw_offset + g * kTileSize;
+        const word *w_pre = tw_pre + tw_offset + g * kTileSize;
+        for (int j = 0; j < t; j++) {
+          word *__restrict__ x = tile[2 * g * t + j];
+          word *__restrict__ y = tile[2 * g * t + j + t];
+          for (int l = 0; l < kTileSize; l++) {
+            ButterflyINTT(x[l], y[l], w[l], w_pre[l], q);
+          }
+        }
+      }
+    }
+    word *dst_chunk = dst + c * kTileSize * kTileSize;
+    for (int l = 0; l < kTileSize; l++) {
+      for (int r = 0; r < kTileSize; r++) {
+        dst_chunk[l * kTileSize + r] = tile[r][l];
+      }
+    }
+  }
+
+  for (int m = degree / (2 * kTileSize), t = kTileSize; m >= 1;
+       m >>= 1, t <<= 1) {
+    for (int i = 0; i < m; i++) {
+      word w = tw[m + i];
+      word w_pre = tw_pre[m + i];
+      word *__restrict__ x = dst + 2 * i * t;
+      word *__restrict__ y = x + t;
+      for (int j = 0; j < t; j++) {
+        ButterflyINTT(x[j], y[j], w, w_pre, q);
+      }
+    }
+  }
+
+  word half_q = q >> 1;
+  for (int j = 0; j < degree; j++) {
+    word res = ReduceOnce(MultShoupLazy(dst[j], post_mult, post_mult_pre, q), q);
+    if (normalize) {
+      word neg = res - q;
+      res = res > half_q ? neg : res;
+    }
+    dst[j] = res;
+  }
+}
+
+/**
+ * @brief ModDown epilogue applied on an NTT-ed limb:
+ * dst = (src2 * padding - dst) * inv_p_prod. A null src2 is treated as zero.
+ */
+template <typename word>
+CHEDDAR_HOST_TARGET_CLONES void ModDownEpilogueLimb(
+    word *dst, const word *src2, int degree, const word q, bool has_padding,
+    const word padding, const word padding_pre, const word inv_p_prod,
+    const word inv_p_prod_pre) {
+  for (int j = 0; j < degree; j++) {
+    word res = 0;
+    if (src2 != nullptr) {
+      res = FromSigned(src2[j], q);
+      if (has_padding) {
+        res = ReduceOnce(MultShoupLazy(res, padding, padding_pre, q), q);
+      }
+    }
+    res = res - dst[j] + q;
+    dst[j] = ReduceOnce(MultShoupLazy(res, inv_p_prod, inv_p_prod_pre, q), q);
+  }
+}
+
+}  // namespace
+}  // namespace kernel
+
+// ----- template for each functions ------
+template <typename word>
+void NTTHandler<word>::NTT(DvView<word> &dst, const NPInfo &np,
+                           const DvConstView<word> &src,
+                           bool montgomery_conversion /*= false*/) const {
+  int log_degree = param_.log_degree_;
+  int degree = param_.degree_;
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * degree;
+  int num_total_primes = np.GetNumTotal();
+  AssertTrue(dst.TotalSize() == num_total_primes * degree,
+             "NTT: Invalid dst size");
+
+  const word *primes = param_.GetPrimesPtr(np);
+  const make_signed_t<word> *inv_primes = param_.GetInvPrimesPtr(np);
+  int ter_left = param_.GetMaxNumTer() - np.num_ter_;
+  int main_left = param_.GetMaxNumMain() - np.num_main_;
+  int src_extra = src.QSize() - q_size;
+
+  word *dst_ptr = dst.data();
+  const word *src_ptr = src.data();
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int y_idx) {
+    word prime = primes[y_idx];
+    int tw_y_idx = ter_left + y_idx;
+    const word *src_limb = src_ptr + y_idx * degree;
+    if (y_idx >= num_q_primes) {
+      tw_y_idx += main_left;
+      src_limb += src_extra;
+    }
+    word pre_mult = 0;
+    word pre_mult_pre = 0;
+    if (montgomery_conversion) {
+      pre_mult = kernel::FromMontgomery(montgomery_converter_.data()[tw_y_idx],
+                                        prime, inv_primes[y_idx]);
+      pre_mult_pre = kernel::ShoupPrecompute(pre_mult, prime);
+    }
+    kernel::ForwardNTTLimb<word>(
+        dst_ptr + y_idx * degree, src_limb,
+        shoup_twiddle_factors_.data() + tw_y_idx * degree,
+        shoup_twiddle_factors_pre_.data() + tw_y_idx * degree, log_degree,
+        prime, pre_mult, pre_mult_pre);
+  });
+}
+
+template <typename word>
+void NTTHandler<word>::INTT(DvView<word> &dst, const NPInfo &np,
+                            const DvConstView<word> &src,
+                            bool montgomery_conversion /*= true*/) const {
+  int ter_left = param_.GetMaxNumTer() - np.num_ter_;
+  int main_left = param_.GetMaxNumMain() - np.num_main_;
+  int num_q_primes = np.GetNumQ();
+
+  // Same as INTTAndMultConst with the (per-prime) inverse degree constants
+  const Dv &inv_degree = montgomery_conversion ? inv_degree_ : inv_degree_mont_;
+  int num_const = num_q_primes + np.num_aux_;
+  DvConstView<word> src_const(inv_degree.data() + ter_left,
+                              num_const + main_left, np.num_aux_);
+  AssertTrue(dst.TotalSize() == np.GetNumTotal() * param_.degree_,
+             "INTT: Invalid dst size");
+  INTTAndMultConst(dst, np, src, src_const, false);
+}
+
+template <typename word>
+void NTTHandler<word>::INTTAndMultConst(DvView<word> &dst, const NPInfo &np,
+                                        const DvConstView<word> &src,
+                                        const DvConstView<word> &src_const,
+                                        bool normalize /*= false*/) const {
+  int log_degree = param_.log_degree_;
+  int degree = param_.degree_;
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * degree;
+  int num_total_primes = np.GetNumTotal();
+  AssertTrue(dst.TotalSize() == num_total_primes * degree,
+             "INTTAndMultConst: Invalid dst size");
+
+  const word *primes = param_.GetPrimesPtr(np);
+  const make_signed_t<word> *inv_primes = param_.GetInvPrimesPtr(np);
+  int ter_left = param_.GetMaxNumTer() - np.num_ter_;
+  int main_left = param_.GetMaxNumMain() - np.num_main_;
+  int src_extra = src.QSize() - q_size;
+  int src_const_extra = src_const.QSize() - num_q_primes;
+
+  word *dst_ptr = dst.data();
+  const word *src_ptr = src.data();
+  const word *src_const_ptr = src_const.data();
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int y_idx) {
+    word prime = primes[y_idx];
+    int tw_y_idx = ter_left + y_idx;
+    int src_const_idx = y_idx;
+    const word *src_limb = src_ptr + y_idx * degree;
+    if (y_idx >= num_q_primes) {
+      tw_y_idx += main_left;
+      src_const_idx += src_const_extra;
+      src_limb += src_extra;
+    }
+    word post_mult = kernel::FromMontgomery(src_const_ptr[src_const_idx],
+                                            prime, inv_primes[y_idx]);
+    kernel::InverseNTTLimb<word>(
+        dst_ptr + y_idx * degree, src_limb,
+        shoup_inv_twiddle_factors_.data() + tw_y_idx * degree,
+        shoup_inv_twiddle_factors_pre_.data() + tw_y_idx * degree,
+        log_degree, prime, post_mult,
+        kernel::ShoupPrecompute(post_mult, prime), normalize);
+  });
+}
+
+template <typename word>
+void NTTHandler<word>::NTTForModUp(DvView<word> &dst, const NPInfo &np,
+                                   int skip_start, int skip_end,
+                                   const DvConstView<word> &src) const {
+  int log_degree = param_.log_degree_;
+  int degree = param_.degree_;
+  int num_q_primes = np.GetNumQ();
+  int q_size = num_q_primes * degree;
+  int num_total_primes = np.GetNumTotal();
+  AssertTrue(dst.TotalSize() == num_total_primes * degree,
+             "NTTForModUp: Invalid dst size");
+
+  // Extra handling for skip primes
+  AssertTrue(skip_start >= 0 && skip_start < num_q_primes &&
+                 skip_end >= skip_start && skip_end <= num_q_primes,
+             "NTTForModUp: Invalid skip primes");
+  int num_skip = skip_end - skip_start;
+
+  const word *primes = param_.GetPrimesPtr(np);
+  int ter_left = param_.GetMaxNumTer() - np.num_ter_;
+  int main_left = param_.GetMaxNumMain() - np.num_main_;
+  int src_extra = src.QSize() - q_size;
+
+  // montgomery_conversion is always false (kFuseMontgomery)
+  word *dst_ptr = dst.data();
+  const word *src_ptr = src.data();
+  ThreadPool::Global().ParallelFor(
+      0, num_total_primes - num_skip, [&](int y_idx) {
+        if (y_idx >= skip_start) y_idx += num_skip;
+        int tw_y_idx = ter_left + y_idx;
+        const word *src_limb = src_ptr + y_idx * degree;
+        if (y_idx >= num_q_primes) {
+          tw_y_idx += main_left;
+          src_limb += src_extra;
+        }
+        kernel::ForwardNTTLimb<word>(
+            dst_ptr + y_idx * degree, src_limb,
+            shoup_twiddle_factors_.data() + tw_y_idx * degree,
+            shoup_twiddle_factors_pre_.data() + tw_y_idx * degree, log_degree,
+            primes[y_idx], 0, 0);
+      });
+}
+
+template <typename word>
+void NTTHandler<word>::NTTForModDown(
+    DvView<word> &dst, const NPInfo &np_src1, const NPInfo &np_src2,
+    const DvConstView<word> &src1, const DvConstView<word> &src2,
+    const DvConstView<word> &inv_p_prod,
+    const DvConstView<word> &src2_padding /*= DvConstView<word>(nullptr,
+                                                              0)*/) const {
+  int log_degree = param_.log_degree_;
+  int degree = param_.degree_;
+  int num_total_primes = np_src1.GetNumTotal();
+  AssertTrue(dst.TotalSize() == num_total_primes * degree,
+             "NTTForModDown: Invalid dst size");
+
+  // Special restrictions for NTTForModDown
+  AssertTrue(np_src1.num_aux_ == 0, "NTTForModDown: num_aux should be 0");
+
+  int num_src2_primes = np_src2.GetNumQ();
+  AssertTrue(num_src2_primes <= num_total_primes,
+             "NTTForModDown: Invalid src2 size");
+  AssertTrue(dst.data() != src2.data(),
+             "NTTForModDown: dst and src2 should be different");
+  int src2_start = np_src1.num_ter_ - np_src2.num_ter_;
+  int src2_end = src2_start + num_src2_primes;
+  AssertTrue(src2_end <= num_total_primes, "NTTForModDown: Invalid src2 size");
+
+  const word *primes = param_.GetPrimesPtr(np_src1);
+  const make_signed_t<word> *inv_primes = param_.GetInvPrimesPtr(np_src1);
+  int ter_left = param_.GetMaxNumTer() - np_src1.num_ter_;
+
+  word *dst_ptr = dst.data();
+  const word *src1_ptr = src1.data();
+  const word *src2_ptr = src2.data();
+  const word *inv_p_prod_ptr = inv_p_prod.data();
+  const word *src2_padding_ptr = src2_padding.data();
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int y_idx) {
+    word prime = primes[y_idx];
+    make_signed_t<word> inv_prime = inv_primes[y_idx];
+    int tw_y_idx = ter_left + y_idx;
+    word *dst_limb = dst_ptr + y_idx * degree;
+
+    // montgomery_conversion is always false (kFuseMontgomery)
+    kernel::ForwardNTTLimb<word>(
+        dst_limb, src1_ptr + y_idx * degree,
+        shoup_twiddle_factors_.data() + tw_y_idx * degree,
+        shoup_twiddle_factors_pre_.data() + tw_y_idx * degree, log_degree,
+        prime, 0, 0);
+
+    const word *src2_limb = nullptr;
+    bool has_padding = false;
+    word padding = 0;
+    if (y_idx >= src2_start && y_idx < src2_end) {
+      int src2_y_idx = y_idx - src2_start;
+      src2_limb = src2_ptr + src2_y_idx * degree;
+      if (src2_padding_ptr != nullptr) {
+        has_padding = true;
+        padding = kernel::FromMontgomery(src2_padding_ptr[src2_y_idx], prime,
+                                         inv_prime);
+      }
+    }
+    word inv_p_prod_val =
+        kernel::FromMontgomery(inv_p_prod_ptr[y_idx], prime, inv_prime);
+    kernel::ModDownEpilogueLimb<word>(
+        dst_limb, src2_limb, degree, prime, has_padding, padding,
+        kernel::ShoupPrecompute(padding, prime), inv_p_prod_val,
+        kernel::ShoupPrecompute(inv_p_prod_val, prime));
+  });
+}
+
+// dst = INTT(src) * const_src
+template <typename word>
+void NTTHandler<word>::INTTForModDown(
+    DvView<word> &dst, const NPInfo &np_src, const NPInfo &np_non_intt,
+    const DvConstView<word> &src, const DvConstView<word> &src_const) const {
+  int log_degree = param_.log_degree_;
+  int degree = param_.degree_;
+  int num_total_primes = np_src.GetNumTotal() - np_non_intt.GetNumTotal();
+  AssertTrue(dst.TotalSize() == num_total_primes * degree,
+             "INTTForModDown: Invalid dst size");
+
+  // Specific check for INTTForModDown
+  AssertTrue(np_src.GetNumQ() * degree == src.QSize(),
+             "INTTForModDown: Invalid src size");
+  AssertTrue(np_src.GetNumTotal() * degree == src.TotalSize(),
+             "INTTForModDown: Invalid src size");
+  AssertTrue(np_non_intt.num_aux_ == 0,
+             "INTTForModDown: num_aux should be 0 after moddown");
+  AssertTrue(np_non_intt.IsSubsetOf(np_src),
+             "INTTForModDown: Invalid np combination");
+  AssertTrue(src.data() != dst.data(),
+             "INTTForModDown: src and dst should be different");
+  AssertTrue(src_const.AuxSize() == np_src.num_aux_,
+             "INTTForModDown: Invalid src_const size");
+  AssertTrue(
+      src_const.TotalSize() == np_src.GetNumTotal() - np_non_intt.GetNumTotal(),
+      "INTTForModDown: Invalid src_const size");
+
+  // We either perform INTT on main primes or terminal primes (+ aux primes --
+  // optional) and not both.
+  // Also, it's possible that we don't perform INTT on any q primes.
+  bool intt_on_main = np_src.num_main_ > np_non_intt.num_main_;
+  bool intt_on_ter = np_src.num_ter_ > np_non_intt.num_ter_;
+  AssertTrue(!intt_on_main || !intt_on_ter,
+             "INTTForModDown: Invalid np combination");
+
+  const word *primes;
+  const make_signed_t<word> *inv_primes;
+  const word *src_ptr = src.data();
+  int num_q_primes;
+  int tw_offset;
+  int tw_y_extra;
+  int src_extra;
+  if (!intt_on_ter) {
+    // Case 1: We only perform INTT on the upper part of src
+    num_q_primes = np_src.num_main_ - np_non_intt.num_main_;
+    int num_src_offset_primes = np_src.num_ter_ + np_non_intt.num_main_;
+    primes = param_.GetPrimesPtr(np_src) + num_src_offset_primes;
+    inv_primes = param_.GetInvPrimesPtr(np_src) + num_src_offset_primes;
+    src_ptr += num_src_offset_primes * degree;
+    tw_offset = param_.GetMaxNumTer() + np_non_intt.num_main_;
+    tw_y_extra = param_.GetMaxNumMain() - np_src.num_main_;
+    src_extra = 0;
+  } else {
+    // Case 2. We perform INTT on some of the ter primes and all aux primes
+    num_q_primes = np_src.num_ter_ - np_non_intt.num_ter_;
+    primes = param_.__GetPrimesPtrModDownWithTerPrimes(np_src, np_non_intt);
+    inv_primes =
+        param_.__GetInvPrimesPtrModDownWithTerPrimes(np_src, np_non_intt);
+    tw_offset = param_.GetMaxNumTer() - np_src.num_ter_;
+    tw_y_extra = param_.GetMaxNumMain() + np_non_intt.num_ter_;
+    src_extra = src.QSize() - num_q_primes * degree;
+  }
+
+  word *dst_ptr = dst.data();
+  const word *src_const_ptr = src_const.data();
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int y_idx) {
+    word prime = primes[y_idx];
+    int tw_y_idx = tw_offset + y_idx;
+    const word *src_limb = src_ptr + y_idx * degree;
+    if (y_idx >= num_q_primes) {
+      tw_y_idx += tw_y_extra;
+      src_limb += src_extra;
+    }
+    word post_mult = kernel::FromMontgomery(src_const_ptr[y_idx], prime,
+                                            inv_primes[y_idx]);
+    kernel::InverseNTTLimb<word>(
+        dst_ptr + y_idx * degree, src_limb,
+        shoup_inv_twiddle_factors_.data() + tw_y_idx * degree,
+        shoup_inv_twiddle_factors_pre_.data() + tw_y_idx * degree,
+        log_degree, prime, post_mult,
+        kernel::ShoupPrecompute(post_mult, prime), true);
+  });
+}
+
+template <typename word>
+NTTHandler<word>::NTTHandler(const Parameter<word> &param,
+                             TableCache *tables /*= nullptr*/)
+    : param_(param) {
+  if (tables != nullptr && tables->Load("ntt", GetTables())) return;
+  PopulateTwiddleFactors();
+  if (tables != nullptr) tables->Store("ntt", GetTables());
+}
+
+template <typename word>
+size_t NTTHandler<word>::GetTableBytes(const Parameter<word> &param) {
+  // See PopulateTwiddleFactors: five degree-sized tables and three scalars
+  // per prime
+  NPInfo np = param.LevelToNP(param.max_level_, param.alpha_);
+  size_t num_total_primes = np.GetNumTotal();
+  size_t per_prime = 5 * static_cast<size_t>(param.degree_) + 3;
+  return num_total_primes * per_prime * sizeof(word);
+}
+
+template <typename word>
+std::vector<std::pair<std::string, DeviceVector<word> *>>
+NTTHandler<word>::GetTables() {
+  return {{"twiddle_factors", &twiddle_factors_},
+          {"inv_degree", &inv_degree_},
+          {"inv_degree_mont", &inv_degree_mont_},
+          {"montgomery_converter", &montgomery_converter_},
+          {"shoup_twiddle_factors", &shoup_twiddle_factors_},
+          {"shoup_twiddle_factors_pre", &shoup_twiddle_factors_pre_},
+          {"shoup_inv_twiddle_factors", &shoup_inv_twiddle_factors_},
+          {"shoup_inv_twiddle_factors_pre", &shoup_inv_twiddle_factors_pre_}};
+}
+
+template <typename word>
+void NTTHandler<word>::PopulateTwiddleFactors() {
+  int log_degree = param_.log_degree_;
+  AssertTrue(log_degree >= min_log_degree_ && log_degree <= max_log_degree_,
+             "NTTHandler: Invalid log_degree");
+  int degree = (1 << log_degree);
+  NPInfo np = param_.LevelToNP(param_.max_level_, param_.alpha_);
+  const auto &primes = param_.GetPrimeVector(np);
+  int num_total_primes = np.GetNumTotal();
+
+  Hv h_psi_rev_mont(degree * num_total_primes, 0);
+  Hv h_psi_rev(degree * num_total_primes, 0);
+  Hv h_psi_rev_pre(degree * num_total_primes, 0);
+  Hv h_psi_inv_rev(degree * num_total_primes, 0);
+  Hv h_psi_inv_rev_pre(degree * num_total_primes, 0);
+  Hv h_N_inv(num_total_primes, 0);
+  Hv h_N_inv_mont(num_total_primes, 0);
+  Hv h_mont_convert(num_total_primes, 0);
+
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int i) {
+    std::vector<word> psi_rev(degree);
+    std::vector<word> psi_inv_rev(degree);
+
+    word p = primes[i];
+    basic::Modulus<word> mod(p);
+    word psi = primeutil::FindPrimitiveMthRoot(2 * degree, p);
+    word psi_inv = primeutil::InvMod<word>(psi, p);
+
+    h_N_inv[i] = primeutil::InvMod<word>(degree, p);
+    h_N_inv_mont[i] = primeutil::ToMontgomery<word>(h_N_inv[i], p);
+    h_mont_convert[i] =
+        primeutil::ToMontgomery(primeutil::ToMontgomery<word>(1, p), p);
+
+    psi_rev[0] = 1;
+    psi_inv_rev[0] = 1;
+    for (int j = 1; j < degree; j++) {
+      psi_rev[j] = mod.MultMod(psi_rev[j - 1], psi);
+      psi_inv_rev[j] = mod.MultMod(psi_inv_rev[j - 1], psi_inv);
+    }
+    BitReverseVector(psi_rev);
+    BitReverseVector(psi_inv_rev);
+
+    // Montgomery form table keeps the plain bit-reversed order
+    basic::simd::ToMontgomery(h_psi_rev_mont.data() + i * degree,
+                              psi_rev.data(), degree, mod);
+    kernel::PermuteTileTwiddleFactors(psi_rev.data(), degree);
+    kernel::PermuteTileTwiddleFactors(psi_inv_rev.data(), degree);
+    for (int j = 0; j < degree; j++) {
+      int idx = i * degree + j;
+      h_psi_rev[idx] = psi_rev[j];
+      h_psi_rev_pre[idx] = kernel::ShoupPrecompute(psi_rev[j], p);
+      h_psi_inv_rev[idx] = psi_inv_rev[j];
+      h_psi_inv_rev_pre[idx] = kernel::ShoupPrecompute(psi_inv_rev[j], p);
+    }
+  });
+  CopyHostToDevice<word>(twiddle_factors_, h_psi_rev_mont);
+  CopyHostToDevice<word>(shoup_twiddle_factors_, h_psi_rev);
+  CopyHostToDevice<word>(shoup_twiddle_factors_pre_, h_psi_rev_pre);
+  CopyHostToDevice<word>(shoup_inv_twiddle_factors_, h_psi_inv_rev);
+  CopyHostToDevice<word>(shoup_inv_twiddle_factors_pre_, h_psi_inv_rev_pre);
+  CopyHostToDevice<word>(inv_degree_, h_N_inv);
+  CopyHostToDevice<word>(inv_degree_mont_, h_N_inv_mont);
+  CopyHostToDevice<word>(montgomery_converter_, h_mont_convert);
+}
+
+template <typename word>
+DvConstView<word> NTTHandler<word>::ImaginaryUnitConstView(
+    const NPInfo &np) const {
+  int ter_offset = (param_.GetMaxNumTer() - np.num_ter_) * param_.degree_;
+  int q_size = param_.L_ * param_.degree_ - ter_offset;
+  int aux_size = param_.alpha_ * param_.degree_;
+
+  return DvConstView<word>(twiddle_factors_.data() + ter_offset + 1,
+                           q_size + aux_size, aux_size);
+}
+
+template class NTTHandler<uint32_t>;
+template class NTTHandler<uint64_t>;
+
+}  // namespace cheddar
@@ -1,9 +1,11 @@
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 
 #include "core/Parameter.h"
 #include "common/Assert.h"
 #include "common/CommonUtils.h"
+#include "common/HostRuntime.h"
 #include "common/PrimeUtils.h"
 
 namespace {
@@ -247,6 +249,38 @@ bool Parameter<word>::IsUsingSparseSecretEncapsulation() const {
   return dense_h_ > sparse_h_;
 }
 
+template <typename word>
+uint64_t Parameter<word>::GetFingerprint() const {
+  // 64-bit FNV-1a over the defining values
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  auto mix = [&hash](uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= UINT64_C(0x100000001b3);
+    }
+  };
+  uint64_t scale_bits;
+  std::memcpy(&scale_bits, &base_scale_, sizeof(scale_bits));
+  for (uint64_t value :
+       {static_cast<uint64_t>(word_size_), static_cast<uint64_t>(log_degree_),
+        scale_bits, static_cast<uint64_t>(default_encryption_level_),
+        static_cast<uint64_t>(dense_h_), static_cast<uint64_t>(sparse_h_)}) {
+    mix(value);
+  }
+  for (const auto* primes : {&main_primes_, &ter_primes_, &aux_primes_}) {
+    mix(primes->size());
+    for (word prime : *primes) mix(prime);
+  }
+  mix(level_config_.size());
+  for (const auto& [num_main, num_ter] : level_config_) {
+    mix(num_main);
+    mix(num_ter);
+  }
+  mix(additional_base_.first);
+  mix(additional_base_.second);
+  return hash;
+}
+
 template <typename word>
 int Parameter<word>::GetMaxNumTer() const {
   return ter_primes_.size();
@@ -314,6 +348,25 @@ int Parameter<word>::NPToLevel(const NPInfo& np) const {
   return found.first - level_config_.cbegin();
 }
 
+template <typename word>
+NPInfo Parameter<word>::GetEvkNP(int max_level) const {
+  // DtS case
+  if (max_level == -1) {
+    NPInfo short_base = LevelToNP(-1);
+    short_base.num_aux_ = short_base.num_main_ + short_base.num_ter_;
+    return short_base;
+  }
+
+  // Normal case
+  NPInfo res = LevelToNP(0);
+  for (int i = 1; i <= max_level; i++) {
+    res.num_main_ = Max(res.num_main_, LevelToNP(i).num_main_);
+  }
+  res.num_ter_ = GetMaxNumTer();
+  res.num_aux_ = alpha_;
+  return res;
+}
+
 template <typename word>
 std::vector<word> Parameter<word>::GetPrimeVector(const NPInfo& np) const {
   AssertValidNP(np);
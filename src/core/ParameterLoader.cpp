@@ -0,0 +1,316 @@
+#include "core/ParameterLoader.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+namespace {
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// A minimal JSON reader, enough for the parameter files
+struct JsonValue {
+  enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  Type type = Type::kNull;
+  bool boolean = false;
+  // Integers are kept exactly, as the primes may not fit in a double.
+  bool is_integer = false;
+  bool negative = false;
+  uint64_t magnitude = 0;
+  std::string string;
+  std::vector<JsonValue> array;
+  std::vector<std::pair<std::string, JsonValue>> object;
+
+  const JsonValue *Find(const std::string &key) const {
+    for (const auto &[name, value] : object) {
+      if (name == key) return &value;
+    }
+    return nullptr;
+  }
+};
+
+class JsonParser {
+ private:
+  const std::string &text_;
+  size_t pos_ = 0;
+
+  [[noreturn]] void Error(const std::string &msg) const {
+    Fail("ParameterConfig: " + msg + " at offset " + std::to_string(pos_));
+    std::abort();
+  }
+
+  void SkipSpaces() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r')) {
+      pos_++;
+    }
+  }
+
+  char Peek() {
+    SkipSpaces();
+    if (pos_ >= text_.size()) Error("Unexpected end of input");
+    return text_[pos_];
+  }
+
+  void Expect(char c) {
+    if (Peek() != c) Error(std::string("Expected '") + c + "'");
+    pos_++;
+  }
+
+  void ExpectWord(const std::string &word) {
+    if (text_.compare(pos_, word.size(), word) != 0) Error("Invalid literal");
+    pos_ += word.size();
+  }
+
+  std::string ParseString() {
+    Expect('"');
+    std::string res;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      char c = text_[pos_++];
+      if (c == '\\') {
+        if (pos_ >= text_.size()) break;
+        c = text_[pos_++];
+        if (c == 'n') {
+          c = '\n';
+        } else if (c == 't') {
+          c = '\t';
+        } else if (c == 'r') {
+          c = '\r';
+        } else if (c != '"' && c != '\\' && c != '/') {
+          Error("Unsupported escape sequence");
+        }
+      }
+      res.push_back(c);
+    }
+    Expect('"');
+    return res;
+  }
+
+  JsonValue ParseNumber() {
+    JsonValue value;
+    value.type = JsonValue::Type::kNumber;
+    if (text_[pos_] == '-') {
+      value.negative = true;
+      pos_++;
+    }
+    value.is_integer = true;
+    bool overflow = false;
+    size_t digits_start = pos_;
+    while (pos_ < text_.size() && IsDigit(text_[pos_])) {
+      uint64_t digit = text_[pos_++] - '0';
+      if (value.magnitude >
+          (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        overflow = true;
+      }
+      value.magnitude = value.magnitude * 10 + digit;
+    }
+    if (pos_ == digits_start) Error("Invalid number");
+    while (pos_ < text_.size() &&
+           (text_[pos_] == '.' || text_[pos_] == 'e' || text_[pos_] == 'E' ||
+            text_[pos_] == '+' || text_[pos_] == '-' ||
+            IsDigit(text_[pos_]))) {
+      value.is_integer = false;
+      pos_++;
+    }
+    if (overflow) value.is_integer = false;
+    return value;
+  }
+
+ public:
+  explicit JsonParser(const std::string &text) : text_{text} {}
+
+  JsonValue ParseValue() {
+    JsonValue value;
+    char c = Peek();
+    if (c == '{') {
+      value.type = JsonValue::Type::kObject;
+      pos_++;
+      if (Peek() == '}') {
+        pos_++;
+        return value;
+      }
+      while (true) {
+        std::string key = ParseString();
+        Expect(':');
+        value.object.emplace_back(std::move(key), ParseValue());
+        if (Peek() == '}') break;
+        Expect(',');
+      }
+      pos_++;
+    } else if (c == '[') {
+      value.type = JsonValue::Type::kArray;
+      pos_++;
+      if (Peek() == ']') {
+        pos_++;
+        return value;
+      }
+      while (true) {
+        value.array.push_back(ParseValue());
+        if (Peek() == ']') break;
+        Expect(',');
+      }
+      pos_++;
+    } else if (c == '"') {
+      value.type = JsonValue::Type::kString;
+      value.string = ParseString();
+    } else if (c == 't' || c == 'f') {
+      value.type = JsonValue::Type::kBool;
+      value.boolean = (c == 't');
+      ExpectWord(value.boolean ? "true" : "false");
+    } else if (c == 'n') {
+      ExpectWord("null");
+    } else if (c == '-' || IsDigit(c)) {
+      value = ParseNumber();
+    } else {
+      Error("Unexpected character");
+    }
+    return value;
+  }
+
+  JsonValue ParseDocument() {
+    JsonValue value = ParseValue();
+    SkipSpaces();
+    if (pos_ != text_.size()) Error("Trailing characters");
+    return value;
+  }
+};
+
+uint64_t GetUnsigned(const JsonValue &value, const std::string &name) {
+  AssertTrue(value.type == JsonValue::Type::kNumber && value.is_integer &&
+                 !value.negative,
+             "ParameterConfig: " + name + " should be a non-negative integer");
+  return value.magnitude;
+}
+
+int GetInt(const JsonValue &value, const std::string &name) {
+  uint64_t res = GetUnsigned(value, name);
+  AssertTrue(res <= static_cast<uint64_t>(std::numeric_limits<int>::max()),
+             "ParameterConfig: " + name + " is too large");
+  return static_cast<int>(res);
+}
+
+const JsonValue &GetRequired(const JsonValue &root, const std::string &name) {
+  const JsonValue *value = root.Find(name);
+  AssertTrue(value != nullptr, "ParameterConfig: Missing " + name);
+  return *value;
+}
+
+std::vector<uint64_t> GetPrimes(const JsonValue &value,
+                                const std::string &name) {
+  AssertTrue(value.type == JsonValue::Type::kArray,
+             "ParameterConfig: " + name + " should be an array");
+  std::vector<uint64_t> res;
+  for (const auto &prime : value.array) res.push_back(GetUnsigned(prime, name));
+  return res;
+}
+
+std::pair<int, int> GetPair(const JsonValue &value, const std::string &name) {
+  AssertTrue(value.type == JsonValue::Type::kArray && value.array.size() == 2,
+             "ParameterConfig: " + name + " should be a pair");
+  return {GetInt(value.array[0], name), GetInt(value.array[1], name)};
+}
+
+}  // namespace
+
+ParameterConfig ParameterConfig::Load(const std::string &path) {
+  std::ifstream file(path);
+  AssertTrue(file.is_open(), "ParameterConfig: Cannot open " + path);
+  std::stringstream text;
+  text << file.rdbuf();
+  return Parse(text.str());
+}
+
+ParameterConfig ParameterConfig::Parse(const std::string &text) {
+  JsonValue root = JsonParser(text).ParseDocument();
+  AssertTrue(root.type == JsonValue::Type::kObject,
+             "ParameterConfig: The root should be an object");
+
+  ParameterConfig config;
+  config.log_degree = GetInt(GetRequired(root, "log_degree"), "log_degree");
+  config.log_default_scale =
+      GetInt(GetRequired(root, "log_default_scale"), "log_default_scale");
+  config.default_encryption_level =
+      GetInt(GetRequired(root, "default_encryption_level"),
+             "default_encryption_level");
+  config.main_primes =
+      GetPrimes(GetRequired(root, "main_primes"), "main_primes");
+  config.auxiliary_primes =
+      GetPrimes(GetRequired(root, "auxiliary_primes"), "auxiliary_primes");
+  if (const auto *value = root.Find("terminal_primes")) {
+    config.terminal_primes = GetPrimes(*value, "terminal_primes");
+  }
+
+  const JsonValue &level_config = GetRequired(root, "level_config");
+  AssertTrue(level_config.type == JsonValue::Type::kArray,
+             "ParameterConfig: level_config should be an array");
+  for (const auto &pair : level_config.array) {
+    config.level_config.push_back(GetPair(pair, "level_config"));
+  }
+  if (const auto *value = root.Find("additional_base")) {
+    config.additional_base = GetPair(*value, "additional_base");
+  }
+
+  if (const auto *value = root.Find("dense_hamming_weight")) {
+    config.dense_hamming_weight = GetInt(*value, "dense_hamming_weight");
+  }
+  if (const auto *value = root.Find("sparse_hamming_weight")) {
+    config.sparse_hamming_weight = GetInt(*value, "sparse_hamming_weight");
+  }
+
+  if (const auto *value = root.Find("boot")) {
+    AssertTrue(value->type == JsonValue::Type::kBool,
+               "ParameterConfig: boot should be a boolean");
+    config.boot = value->boolean;
+  }
+  if (config.boot) {
+    config.num_cts_levels =
+        GetInt(GetRequired(root, "num_cts_levels"), "num_cts_levels");
+    config.num_stc_levels =
+        GetInt(GetRequired(root, "num_stc_levels"), "num_stc_levels");
+  }
+  return config;
+}
+
+template <typename word>
+std::unique_ptr<Parameter<word>> ParameterConfig::CreateParameter() const {
+  auto to_words = [](const std::vector<uint64_t> &primes) {
+    std::vector<word> res;
+    for (uint64_t prime : primes) {
+      AssertTrue(prime <= std::numeric_limits<word>::max(),
+                 "ParameterConfig: Prime " + std::to_string(prime) +
+                     " does not fit in the word");
+      res.push_back(static_cast<word>(prime));
+    }
+    return res;
+  };
+  AssertTrue(log_default_scale > 0 && log_default_scale < 64,
+             "ParameterConfig: Invalid log_default_scale");
+
+  auto param = std::make_unique<Parameter<word>>(
+      log_degree, std::ldexp(1.0, log_default_scale), default_encryption_level,
+      level_config, to_words(main_primes), to_words(auxiliary_primes),
+      to_words(terminal_primes), additional_base);
+  // Dense first, as the sparse weight should not exceed the dense one
+  if (dense_hamming_weight >= 0) {
+    param->SetDenseHammingWeight(dense_hamming_weight);
+  }
+  if (sparse_hamming_weight >= 0) {
+    param->SetSparseHammingWeight(sparse_hamming_weight);
+  }
+  return param;
+}
+
+template std::unique_ptr<Parameter<uint32_t>>
+ParameterConfig::CreateParameter() const;
+template std::unique_ptr<Parameter<uint64_t>>
+ParameterConfig::CreateParameter() const;
+
+}  // namespace cheddar
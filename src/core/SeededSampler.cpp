@@ -0,0 +1,154 @@
+#include "core/SeededSampler.h"
+
+#include <random>
+#include <vector>
+
+#include "common/Assert.h"
+#include "common/ThreadPool.h"
+
+namespace cheddar {
+
+namespace {
+
+// SHAKE128 (FIPS 202) of a single block of less than kRate bytes, squeezed
+// one 64-bit lane at a time
+class Shake128 {
+ public:
+  static constexpr int kRate = 168;
+
+  explicit Shake128(const std::vector<uint64_t> &input) {
+    AssertTrue(input.size() * 8 < kRate, "Shake128: Input too long");
+    for (size_t i = 0; i < input.size(); i++) state_[i] ^= input[i];
+    // The SHAKE domain bits (1111) with the first bit of pad10*1, then its
+    // last bit
+    state_[input.size()] ^= 0x1f;
+    state_[kRate / 8 - 1] ^= UINT64_C(1) << 63;
+  }
+
+  uint64_t Squeeze() {
+    if (next_lane_ == kRate / 8) next_lane_ = 0;
+    if (next_lane_ == 0) Permute();
+    return state_[next_lane_++];
+  }
+
+ private:
+  uint64_t state_[25] = {};
+  int next_lane_ = 0;
+
+  static uint64_t Rotl(uint64_t x, int shift) {
+    return (x << shift) | (x >> (64 - shift));
+  }
+
+  // Keccak-f[1600]
+  void Permute() {
+    static constexpr uint64_t kRoundConstants[24] = {
+        0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+        0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+        0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+        0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+        0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+        0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+        0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+        0x8000000000008080, 0x0000000080000001, 0x8000000080008008};
+    // The rotation of each lane, in the order of the pi step
+    static constexpr int kRotations[24] = {1,  3,  6,  10, 15, 21, 28, 36,
+                                           45, 55, 2,  14, 27, 41, 56, 8,
+                                           25, 43, 62, 18, 39, 61, 20, 44};
+    static constexpr int kPiLanes[24] = {10, 7,  11, 17, 18, 3, 5,  16,
+                                         8,  21, 24, 4,  15, 23, 19, 13,
+                                         12, 2,  20, 14, 22, 9,  6,  1};
+    uint64_t *st = state_;
+    uint64_t bc[5];
+    for (uint64_t round_constant : kRoundConstants) {
+      // theta
+      for (int i = 0; i < 5; i++) {
+        bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+      }
+      for (int i = 0; i < 5; i++) {
+        uint64_t t = bc[(i + 4) % 5] ^ Rotl(bc[(i + 1) % 5], 1);
+        for (int j = 0; j < 25; j += 5) st[j + i] ^= t;
+      }
+      // rho and pi
+      uint64_t t = st[1];
+      for (int i = 0; i < 24; i++) {
+        uint64_t next = st[kPiLanes[i]];
+        st[kPiLanes[i]] = Rotl(t, kRotations[i]);
+        t = next;
+      }
+      // chi
+      for (int j = 0; j < 25; j += 5) {
+        for (int i = 0; i < 5; i++) bc[i] = st[j + i];
+        for (int i = 0; i < 5; i++) {
+          st[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+        }
+      }
+      // iota
+      st[0] ^= round_constant;
+    }
+  }
+};
+
+// Uniform values in [0, prime) by rejection sampling of bit-masked words
+template <typename word>
+void SampleLimb(word *dst, int degree, word prime, Shake128 &xof) {
+  constexpr int kWordBits = sizeof(word) * 8;
+  int bits = kWordBits;
+  while (bits > 1 && (prime >> (bits - 1)) == 0) bits--;
+  word mask = (bits == kWordBits) ? ~word{0} : (word{1} << bits) - 1;
+  constexpr int kPerDraw = 64 / kWordBits;
+  int x = 0;
+  while (x < degree) {
+    uint64_t draw = xof.Squeeze();
+    for (int k = 0; k < kPerDraw && x < degree; k++) {
+      word candidate = static_cast<word>(draw >> (k * kWordBits)) & mask;
+      if (candidate < prime) dst[x++] = candidate;
+    }
+  }
+}
+
+}  // namespace
+
+PolySeed PolySeed::Generate() {
+  std::random_device rd;
+  PolySeed seed;
+  for (auto &seed_word : seed.words) {
+    seed_word = (static_cast<uint64_t>(rd()) << 32) | rd();
+  }
+  return seed;
+}
+
+bool PolySeed::operator==(const PolySeed &other) const {
+  return words[0] == other.words[0] && words[1] == other.words[1];
+}
+
+template <typename word>
+void ExpandUniformPolynomial(DeviceVector<word> &poly,
+                             const Parameter<word> &param, const NPInfo &np,
+                             const PolySeed &seed, int stream /*= 0*/) {
+  int degree = param.degree_;
+  int num_q = np.GetNumQ();
+  int num_total_primes = np.GetNumTotal();
+  int prime_offset = param.GetMaxNumTer() - np.num_ter_;
+  std::vector<word> primes = param.GetPrimeVector(np);
+
+  HostVector<word> poly_host(num_total_primes * degree);
+  ThreadPool::Global().ParallelFor(0, num_total_primes, [&](int i) {
+    // The position of the prime among all the primes (q primes, then aux)
+    uint64_t position = (i < num_q) ? i + prime_offset : param.L_ + i - num_q;
+    Shake128 xof({seed.words[0], seed.words[1],
+                  static_cast<uint64_t>(stream), position});
+    SampleLimb(poly_host.data() + i * degree, degree, primes[i], xof);
+  });
+  CopyHostToDevice(poly, poly_host);
+}
+
+template void ExpandUniformPolynomial(DeviceVector<uint32_t> &poly,
+                                      const Parameter<uint32_t> &param,
+                                      const NPInfo &np, const PolySeed &seed,
+                                      int stream);
+template void ExpandUniformPolynomial(DeviceVector<uint64_t> &poly,
+                                      const Parameter<uint64_t> &param,
+                                      const NPInfo &np, const PolySeed &seed,
+                                      int stream);
+
+}  // namespace cheddar
@@ -0,0 +1,504 @@
+#include "core/Serialize.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <utility>
+
+#include "common/Assert.h"
+#include "common/BasicSimd.h"
+
+namespace cheddar {
+
+namespace {
+
+size_t AlignUp(size_t bytes) {
+  return (bytes + kSerialAlignment - 1) / kSerialAlignment * kSerialAlignment;
+}
+
+// Bit-packing of b-bit values in word-sized containers. A block of
+// kLanes * kWordBits values is packed into kLanes * b words, with value
+// i * kLanes + lane going to the i-th b-bit slot of lane. Each lane is an
+// independent bit stream, so the lane loops vectorize with uniform shifts.
+template <typename word>
+struct PackLayout {
+  static constexpr int kWordBits = sizeof(word) * 8;
+  static constexpr int kLanes = 512 / kWordBits;
+  static constexpr int kBlock = kLanes * kWordBits;
+};
+
+template <typename word>
+inline __attribute__((always_inline)) void PackBlock(
+    word *__restrict__ dst, const word *__restrict__ src, int bits) {
+  using L = PackLayout<word>;
+  for (int i = 0; i < bits * L::kLanes; i++) dst[i] = 0;
+  for (int i = 0; i < L::kWordBits; i++) {
+    int bit_pos = i * bits;
+    int w = bit_pos / L::kWordBits;
+    int shift = bit_pos % L::kWordBits;
+    const word *src_i = src + i * L::kLanes;
+    word *dst_w = dst + w * L::kLanes;
+    for (int lane = 0; lane < L::kLanes; lane++) {
+      dst_w[lane] |= src_i[lane] << shift;
+    }
+    if (shift + bits > L::kWordBits) {
+      for (int lane = 0; lane < L::kLanes; lane++) {
+        dst_w[L::kLanes + lane] |= src_i[lane] >> (L::kWordBits - shift);
+      }
+    }
+  }
+}
+
+template <typename word>
+inline __attribute__((always_inline)) void UnpackBlock(
+    word *__restrict__ dst, const word *__restrict__ src, int bits) {
+  using L = PackLayout<word>;
+  word mask = (bits == L::kWordBits) ? ~word{0} : (word{1} << bits) - 1;
+  for (int i = 0; i < L::kWordBits; i++) {
+    int bit_pos = i * bits;
+    int w = bit_pos / L::kWordBits;
+    int shift = bit_pos % L::kWordBits;
+    const word *src_w = src + w * L::kLanes;
+    word *dst_i = dst + i * L::kLanes;
+    for (int lane = 0; lane < L::kLanes; lane++) {
+      dst_i[lane] = src_w[lane] >> shift;
+    }
+    if (shift + bits > L::kWordBits) {
+      for (int lane = 0; lane < L::kLanes; lane++) {
+        dst_i[lane] |= src_w[L::kLanes + lane] << (L::kWordBits - shift);
+      }
+    }
+    for (int lane = 0; lane < L::kLanes; lane++) dst_i[lane] &= mask;
+  }
+}
+
+// Packs (unpacks) a limb of n values, n being a multiple of kBlock
+template <typename word>
+inline __attribute__((always_inline)) void PackLimbImpl(word *dst,
+                                                        const word *src, int n,
+                                                        int bits) {
+  using L = PackLayout<word>;
+  for (int b = 0; b < n / L::kBlock; b++) {
+    PackBlock(dst + b * bits * L::kLanes, src + b * L::kBlock, bits);
+  }
+}
+
+template <typename word>
+inline __attribute__((always_inline)) void UnpackLimbImpl(word *dst,
+                                                          const word *src,
+                                                          int n, int bits) {
+  using L = PackLayout<word>;
+  for (int b = 0; b < n / L::kBlock; b++) {
+    UnpackBlock(dst + b * L::kBlock, src + b * bits * L::kLanes, bits);
+  }
+}
+
+CHEDDAR_HOST_TARGET_CLONES void PackLimb(uint32_t *dst, const uint32_t *src,
+                                         int n, int bits) {
+  PackLimbImpl(dst, src, n, bits);
+}
+
+CHEDDAR_HOST_TARGET_CLONES void PackLimb(uint64_t *dst, const uint64_t *src,
+                                         int n, int bits) {
+  PackLimbImpl(dst, src, n, bits);
+}
+
+CHEDDAR_HOST_TARGET_CLONES void UnpackLimb(uint32_t *dst, const uint32_t *src,
+                                           int n, int bits) {
+  UnpackLimbImpl(dst, src, n, bits);
+}
+
+CHEDDAR_HOST_TARGET_CLONES void UnpackLimb(uint64_t *dst, const uint64_t *src,
+                                           int n, int bits) {
+  UnpackLimbImpl(dst, src, n, bits);
+}
+
+template <typename word>
+int BitLength(word value) {
+  int bits = 0;
+  while (value != 0) {
+    bits++;
+    value >>= 1;
+  }
+  return bits;
+}
+
+}  // namespace
+
+NPInfo SerialHeader::GetNP() const {
+  return NPInfo(num_main, num_ter, num_aux);
+}
+
+size_t SerialHeader::GetPolyOffset() const {
+  return (flags & kSeededAx) ? 2 * kSerialAlignment : kSerialAlignment;
+}
+
+template <typename word>
+Serializer<word>::Serializer(const Parameter<word> &param,
+                             bool bit_packing /*= false*/)
+    : param_{param}, bit_packing_{bit_packing} {
+  if (bit_packing_) {
+    AssertTrue(param_.degree_ % PackLayout<word>::kBlock == 0,
+               "Serializer: Degree too small for bit-packing");
+  }
+}
+
+template <typename word>
+size_t Serializer<word>::GetPolyBytes(const NPInfo &np,
+                                      bool bit_packed) const {
+  if (!bit_packed) {
+    return AlignUp(np.GetNumTotal() * param_.degree_ * sizeof(word));
+  }
+  // Also reached when reading bit-packed data without bit_packing_
+  AssertTrue(param_.degree_ % PackLayout<word>::kBlock == 0,
+             "Serializer: Degree too small for bit-packing");
+  size_t words = 0;
+  for (word prime : param_.GetPrimeVector(np)) {
+    words += param_.degree_ / PackLayout<word>::kWordBits * BitLength(prime);
+  }
+  return AlignUp(words * sizeof(word));
+}
+
+template <typename word>
+uint64_t Serializer<word>::PrimeFingerprint(const NPInfo &np) const {
+  // 64-bit FNV-1a over the degree and the primes
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  auto mix = [&hash](uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= UINT64_C(0x100000001b3);
+    }
+  };
+  mix(param_.degree_);
+  for (word prime : param_.GetPrimeVector(np)) mix(prime);
+  return hash;
+}
+
+template <typename word>
+SerialHeader Serializer<word>::MakeHeader(SerialType type, const NPInfo &np,
+                                          int num_polys,
+                                          bool seeded_ax /*= false*/) const {
+  SerialHeader header{};
+  header.magic = SerialHeader::kMagic;
+  header.version = SerialHeader::kVersion;
+  header.type = type;
+  header.word_bytes = sizeof(word);
+  header.log_degree = param_.log_degree_;
+  header.num_main = np.num_main_;
+  header.num_ter = np.num_ter_;
+  header.num_aux = np.num_aux_;
+  header.num_polys = num_polys;
+  if (seeded_ax) header.flags |= SerialHeader::kSeededAx;
+  if (bit_packing_) header.flags |= SerialHeader::kBitPacked;
+  header.scale = 1.0;
+  header.prime_fingerprint = PrimeFingerprint(np);
+  header.total_bytes =
+      header.GetPolyOffset() + num_polys * GetPolyBytes(np, bit_packing_);
+  return header;
+}
+
+template <typename word>
+SerialHeader Serializer<word>::ReadHeader(const void *buffer, size_t size,
+                                          SerialType type) const {
+  AssertTrue(size >= sizeof(SerialHeader), "Deserialize: Buffer too small");
+  SerialHeader header;
+  std::memcpy(&header, buffer, sizeof(SerialHeader));
+  AssertTrue(header.magic == SerialHeader::kMagic,
+             "Deserialize: Not a serialized object");
+  AssertTrue(header.version == SerialHeader::kVersion,
+             "Deserialize: Unsupported version " +
+                 std::to_string(header.version));
+  AssertTrue(header.type == type, "Deserialize: Object type mismatch");
+  AssertTrue(header.word_bytes == sizeof(word),
+             "Deserialize: Word size mismatch");
+  AssertTrue(header.log_degree == param_.log_degree_,
+             "Deserialize: Degree mismatch");
+  NPInfo np = header.GetNP();
+  AssertTrue(np.num_main_ >= 0 && np.num_ter_ >= 0 && np.num_aux_ >= 0 &&
+                 np.GetNumQ() > 0,
+             "Deserialize: Invalid NPInfo");
+  AssertTrue(header.prime_fingerprint == PrimeFingerprint(np),
+             "Deserialize: Prime fingerprint mismatch");
+  size_t poly_bytes =
+      GetPolyBytes(np, (header.flags & SerialHeader::kBitPacked) != 0);
+  AssertTrue(header.num_polys >= 0 &&
+                 header.total_bytes ==
+                     header.GetPolyOffset() + header.num_polys * poly_bytes,
+             "Deserialize: Size mismatch");
+  AssertTrue(size >= header.total_bytes, "Deserialize: Truncated buffer");
+  return header;
+}
+
+template <typename word>
+void Serializer<word>::WritePolys(
+    std::ostream &os, const SerialHeader &header,
+    const std::vector<const DeviceVector<word> *> &polys,
+    const PolySeed *seed /*= nullptr*/) const {
+  static const char kZeros[kSerialAlignment] = {};
+  os.write(reinterpret_cast<const char *>(&header), sizeof(SerialHeader));
+  if (seed != nullptr) {
+    os.write(reinterpret_cast<const char *>(seed), sizeof(PolySeed));
+    os.write(kZeros, kSerialAlignment - sizeof(PolySeed));
+  }
+  bool bit_packed = (header.flags & SerialHeader::kBitPacked) != 0;
+  size_t poly_bytes = GetPolyBytes(header.GetNP(), bit_packed);
+  std::vector<word> primes = param_.GetPrimeVector(header.GetNP());
+  int degree = param_.degree_;
+  HostVector<word> h_poly;
+  HostVector<word> h_packed(poly_bytes / sizeof(word), 0);
+  for (const auto *poly : polys) {
+    CopyDeviceToHost(h_poly, *poly);
+    const word *output = h_poly.data();
+    size_t bytes = h_poly.size() * sizeof(word);
+    if (bit_packed) {
+      word *dst = h_packed.data();
+      for (size_t i = 0; i < primes.size(); i++) {
+        int bits = BitLength(primes[i]);
+        const word *limb = h_poly.data() + i * degree;
+        word overflow = 0;
+        for (int x = 0; x < degree; x++) overflow |= limb[x] >> (bits - 1) >> 1;
+        AssertTrue(overflow == 0, "Serialize: Coefficient out of range");
+        PackLimb(dst, limb, degree, bits);
+        dst += degree / PackLayout<word>::kWordBits * bits;
+      }
+      output = h_packed.data();
+      bytes = (dst - h_packed.data()) * sizeof(word);
+    }
+    os.write(reinterpret_cast<const char *>(output), bytes);
+    os.write(kZeros, AlignUp(bytes) - bytes);
+  }
+  AssertTrue(os.good(), "Serialize: Failed to write");
+}
+
+template <typename word>
+void Serializer<word>::ReadPoly(DeviceVector<word> &dst, const void *buffer,
+                                const SerialHeader &header, int index) const {
+  NPInfo np = header.GetNP();
+  int degree = param_.degree_;
+  int size = np.GetNumTotal() * degree;
+  bool bit_packed = (header.flags & SerialHeader::kBitPacked) != 0;
+  size_t offset =
+      header.GetPolyOffset() + index * GetPolyBytes(np, bit_packed);
+  const char *src = static_cast<const char *>(buffer) + offset;
+  if (!bit_packed) {
+    dst.resize(size);
+    cudaMemcpyAsync(dst.data(), src, size * sizeof(word),
+                    cudaMemcpyHostToDevice, dst.stream());
+    return;
+  }
+
+  // The packed words may not be aligned in the buffer.
+  std::vector<word> primes = param_.GetPrimeVector(np);
+  HostVector<word> h_packed(GetPolyBytes(np, true) / sizeof(word));
+  std::memcpy(h_packed.data(), src, h_packed.size() * sizeof(word));
+  HostVector<word> h_poly(size);
+  const word *packed = h_packed.data();
+  for (size_t i = 0; i < primes.size(); i++) {
+    int bits = BitLength(primes[i]);
+    UnpackLimb(h_poly.data() + i * degree, packed, degree, bits);
+    packed += degree / PackLayout<word>::kWordBits * bits;
+  }
+  CopyHostToDevice(dst, h_poly);
+}
+
+template <typename word>
+size_t Serializer<word>::GetSerializedSize(const Ct &ct) const {
+  return MakeHeader(SerialType::kCiphertext, ct.GetNP(), ct.HasRx() ? 3 : 2)
+      .total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::GetSerializedSize(const Pt &ptxt) const {
+  return MakeHeader(SerialType::kPlaintext, ptxt.GetNP(), 1).total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::GetSerializedSize(const Evk &evk) const {
+  return MakeHeader(SerialType::kEvaluationKey, evk.GetNP(), 2 * evk.GetBeta())
+      .total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::GetCompressedSize(const Ct &ct) const {
+  return MakeHeader(SerialType::kCiphertext, ct.GetNP(), 1, true).total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::GetCompressedSize(const Evk &evk) const {
+  return MakeHeader(SerialType::kEvaluationKey, evk.GetNP(), evk.GetBeta(),
+                    true)
+      .total_bytes;
+}
+
+template <typename word>
+void Serializer<word>::Serialize(std::ostream &os, const Ct &ct) const {
+  std::vector<const DeviceVector<word> *> polys{&ct.bx_, &ct.ax_};
+  if (ct.HasRx()) polys.push_back(&ct.rx_);
+  SerialHeader header =
+      MakeHeader(SerialType::kCiphertext, ct.GetNP(), polys.size());
+  header.num_slots = ct.GetNumSlots();
+  header.scale = ct.GetScale();
+  if (ct.HasRx()) header.flags |= SerialHeader::kHasRx;
+  WritePolys(os, header, polys);
+}
+
+template <typename word>
+void Serializer<word>::Serialize(std::ostream &os, const Pt &ptxt) const {
+  SerialHeader header = MakeHeader(SerialType::kPlaintext, ptxt.GetNP(), 1);
+  header.num_slots = ptxt.GetNumSlots();
+  header.scale = ptxt.GetScale();
+  WritePolys(os, header, {&ptxt.mx_});
+}
+
+template <typename word>
+void Serializer<word>::Serialize(std::ostream &os, const Evk &evk) const {
+  int beta = evk.GetBeta();
+  std::vector<const DeviceVector<word> *> polys;
+  for (int i = 0; i < beta; i++) {
+    polys.push_back(&evk.bx_[i]);
+    polys.push_back(&evk.ax_[i]);
+  }
+  SerialHeader header =
+      MakeHeader(SerialType::kEvaluationKey, evk.GetNP(), 2 * beta);
+  WritePolys(os, header, polys);
+}
+
+template <typename word>
+void Serializer<word>::SerializeCompressed(std::ostream &os, const Ct &ct,
+                                           const PolySeed &seed) const {
+  AssertFalse(ct.HasRx(), "SerializeCompressed: Rx is not allowed");
+  SerialHeader header =
+      MakeHeader(SerialType::kCiphertext, ct.GetNP(), 1, true);
+  header.num_slots = ct.GetNumSlots();
+  header.scale = ct.GetScale();
+  WritePolys(os, header, {&ct.bx_}, &seed);
+}
+
+template <typename word>
+void Serializer<word>::SerializeCompressed(std::ostream &os, const Evk &evk,
+                                           const PolySeed &seed) const {
+  int beta = evk.GetBeta();
+  std::vector<const DeviceVector<word> *> polys;
+  for (int i = 0; i < beta; i++) polys.push_back(&evk.bx_[i]);
+  SerialHeader header =
+      MakeHeader(SerialType::kEvaluationKey, evk.GetNP(), beta, true);
+  WritePolys(os, header, polys, &seed);
+}
+
+template <typename word>
+PolySeed Serializer<word>::ReadSeed(const void *buffer) const {
+  PolySeed seed;
+  std::memcpy(&seed, static_cast<const char *>(buffer) + kSerialAlignment,
+              sizeof(PolySeed));
+  return seed;
+}
+
+template <typename word>
+size_t Serializer<word>::Deserialize(Ct &ct, const void *buffer,
+                                     size_t size) const {
+  SerialHeader header = ReadHeader(buffer, size, SerialType::kCiphertext);
+  bool has_rx = (header.flags & SerialHeader::kHasRx) != 0;
+  bool seeded_ax = (header.flags & SerialHeader::kSeededAx) != 0;
+  AssertTrue(header.num_polys == 2 + has_rx - seeded_ax,
+             "Deserialize: Invalid ciphertext");
+  ct.ModifyNP(header.GetNP());
+  ct.SetNumSlots(header.num_slots);
+  ct.SetScale(header.scale);
+  ReadPoly(ct.bx_, buffer, header, 0);
+  if (seeded_ax) {
+    ExpandUniformPolynomial(ct.ax_, param_, header.GetNP(), ReadSeed(buffer));
+  } else {
+    ReadPoly(ct.ax_, buffer, header, 1);
+  }
+  if (has_rx) {
+    ReadPoly(ct.rx_, buffer, header, 2 - seeded_ax);
+  } else {
+    ct.RemoveRx();
+  }
+  return header.total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::Deserialize(Pt &ptxt, const void *buffer,
+                                     size_t size) const {
+  SerialHeader header = ReadHeader(buffer, size, SerialType::kPlaintext);
+  AssertTrue(header.num_polys == 1, "Deserialize: Invalid plaintext");
+  ptxt.ModifyNP(header.GetNP());
+  ptxt.SetNumSlots(header.num_slots);
+  ptxt.SetScale(header.scale);
+  ReadPoly(ptxt.mx_, buffer, header, 0);
+  return header.total_bytes;
+}
+
+template <typename word>
+size_t Serializer<word>::Deserialize(Evk &evk, const void *buffer,
+                                     size_t size) const {
+  SerialHeader header = ReadHeader(buffer, size, SerialType::kEvaluationKey);
+  if (header.flags & SerialHeader::kSeededAx) {
+    AssertTrue(header.num_polys > 0, "Deserialize: Invalid evaluation key");
+    int beta = header.num_polys;
+    PolySeed seed = ReadSeed(buffer);
+    evk = Evk(header.GetNP(), beta);
+    for (int i = 0; i < beta; i++) {
+      ReadPoly(evk.bx_[i], buffer, header, i);
+      ExpandUniformPolynomial(evk.ax_[i], param_, header.GetNP(), seed, i);
+    }
+    return header.total_bytes;
+  }
+  AssertTrue(header.num_polys > 0 && header.num_polys % 2 == 0,
+             "Deserialize: Invalid evaluation key");
+  int beta = header.num_polys / 2;
+  evk = Evk(header.GetNP(), beta);
+  for (int i = 0; i < beta; i++) {
+    ReadPoly(evk.bx_[i], buffer, header, 2 * i);
+    ReadPoly(evk.ax_[i], buffer, header, 2 * i + 1);
+  }
+  return header.total_bytes;
+}
+
+MappedFile::MappedFile(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  AssertTrue(fd >= 0, "MappedFile: Cannot open " + path);
+  // The mapping stays valid after the file is closed, so fd is closed before
+  // anything can throw.
+  struct stat st;
+  bool stat_ok = (fstat(fd, &st) == 0);
+  void *data = nullptr;
+  if (stat_ok && st.st_size > 0) {
+    data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  AssertTrue(stat_ok, "MappedFile: Cannot stat " + path);
+  AssertTrue(data != MAP_FAILED, "MappedFile: Cannot map " + path);
+  data_ = data;
+  size_ = st.st_size;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)} {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    if (data_ != nullptr) munmap(data_, size_);
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+const void *MappedFile::data() const { return data_; }
+
+size_t MappedFile::size() const { return size_; }
+
+template class Serializer<uint32_t>;
+template class Serializer<uint64_t>;
+
+}  // namespace cheddar
@@ -0,0 +1,174 @@
+#include "core/TableCache.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+namespace {
+
+#ifdef USE_CPU_BACKEND
+constexpr uint8_t kBackend = 2;
+#else
+constexpr uint8_t kBackend = 1;
+#endif
+
+uint64_t AlignUp(uint64_t bytes) {
+  return (bytes + kSerialAlignment - 1) / kSerialAlignment * kSerialAlignment;
+}
+
+}  // namespace
+
+TableCache::TableCache(const std::string &path, uint64_t fingerprint)
+    : path_{path}, fingerprint_{fingerprint} {
+  struct stat st;
+  if (stat(path_.c_str(), &st) != 0) return;
+  file_ = MappedFile(path_);
+
+  // A file of another parameter or backend is ignored.
+  const char *data = static_cast<const char *>(file_.data());
+  size_t size = file_.size();
+  if (size < sizeof(FileHeader)) return;
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(FileHeader));
+  if (header.magic != FileHeader::kMagic ||
+      header.version != FileHeader::kVersion || header.backend != kBackend ||
+      header.fingerprint != fingerprint_) {
+    return;
+  }
+
+  uint64_t index_end =
+      sizeof(FileHeader) + header.num_tables * sizeof(IndexEntry);
+  AssertTrue(header.num_tables >= 0 && index_end <= size,
+             "TableCache: Truncated index in " + path_);
+  for (int i = 0; i < header.num_tables; i++) {
+    IndexEntry entry;
+    std::memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(IndexEntry),
+                sizeof(IndexEntry));
+    entry.name[kMaxNameLength] = '\0';
+    AssertTrue(entry.offset + entry.bytes <= size,
+               "TableCache: Truncated table " + std::string(entry.name));
+    tables_.emplace(entry.name, Table{data + entry.offset, entry.bytes});
+  }
+}
+
+std::string TableCache::GetName(const std::string &group,
+                                const std::string &name) {
+  std::string res = group + "/" + name;
+  AssertTrue(static_cast<int>(res.size()) <= kMaxNameLength,
+             "TableCache: Too long table name " + res);
+  return res;
+}
+
+template <typename word>
+bool TableCache::Load(const std::string &group,
+                      const NamedTables<word> &tables) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<const Table *> found;
+  for (const auto &[name, _] : tables) {
+    auto table = tables_.find(GetName(group, name));
+    if (table == tables_.end() || table->second.bytes % sizeof(word) != 0) {
+      return false;
+    }
+    found.push_back(&table->second);
+  }
+  for (size_t i = 0; i < tables.size(); i++) {
+    DeviceVector<word> &dst = *tables[i].second;
+    dst.resize(found[i]->bytes / sizeof(word));
+    cudaMemcpyAsync(dst.data(), found[i]->data, found[i]->bytes,
+                    cudaMemcpyHostToDevice, dst.stream());
+  }
+  return true;
+}
+
+template <typename word>
+void TableCache::Store(const std::string &group,
+                       const NamedTables<word> &tables) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HostVector<word> h_table;
+  for (const auto &[name, src] : tables) {
+    std::string full_name = GetName(group, name);
+    CopyDeviceToHost(h_table, *src);
+    std::vector<char> &bytes = stored_[full_name];
+    bytes.resize(h_table.size() * sizeof(word));
+    std::memcpy(bytes.data(), h_table.data(), bytes.size());
+    tables_[full_name] = Table{bytes.data(), bytes.size()};
+  }
+  modified_ = true;
+}
+
+bool TableCache::Contains(const std::string &name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tables_.find(name) != tables_.end();
+}
+
+int TableCache::GetNumTables() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tables_.size();
+}
+
+bool TableCache::IsModified() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return modified_;
+}
+
+void TableCache::Save() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!modified_) return;
+
+  FileHeader header{};
+  header.magic = FileHeader::kMagic;
+  header.version = FileHeader::kVersion;
+  header.backend = kBackend;
+  header.num_tables = tables_.size();
+  header.fingerprint = fingerprint_;
+
+  std::vector<IndexEntry> entries;
+  uint64_t offset =
+      AlignUp(sizeof(FileHeader) + tables_.size() * sizeof(IndexEntry));
+  for (const auto &[name, table] : tables_) {
+    IndexEntry entry{};
+    std::strncpy(entry.name, name.c_str(), kMaxNameLength);
+    entry.offset = offset;
+    entry.bytes = table.bytes;
+    entries.push_back(entry);
+    offset += AlignUp(table.bytes);
+  }
+
+  // Written to a temporary file first, as the current file may be mapped
+  // (by this or another process).
+  std::string tmp_path = path_ + ".tmp";
+  std::ofstream os(tmp_path, std::ios::binary | std::ios::trunc);
+  AssertTrue(os.is_open(), "TableCache: Cannot open " + tmp_path);
+  static const char kZeros[kSerialAlignment] = {};
+  os.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+  os.write(reinterpret_cast<const char *>(entries.data()),
+           entries.size() * sizeof(IndexEntry));
+  uint64_t index_end = sizeof(FileHeader) + entries.size() * sizeof(IndexEntry);
+  os.write(kZeros, AlignUp(index_end) - index_end);
+  for (const auto &[_, table] : tables_) {
+    os.write(table.data, table.bytes);
+    os.write(kZeros, AlignUp(table.bytes) - table.bytes);
+  }
+  os.close();
+  AssertTrue(os.good(), "TableCache: Failed to write " + tmp_path);
+  AssertTrue(std::rename(tmp_path.c_str(), path_.c_str()) == 0,
+             "TableCache: Cannot replace " + path_);
+  modified_ = false;
+}
+
+template bool TableCache::Load(const std::string &group,
+                               const NamedTables<uint32_t> &tables) const;
+template bool TableCache::Load(const std::string &group,
+                               const NamedTables<uint64_t> &tables) const;
+template void TableCache::Store(const std::string &group,
+                                const NamedTables<uint32_t> &tables);
+template void TableCache::Store(const std::string &group,
+                                const NamedTables<uint64_t> &tables);
+
+}  // namespace cheddar
@@ -0,0 +1,102 @@
+#include "core/Workspace.h"
+
+#include <utility>
+
+namespace cheddar {
+
+namespace {
+
+template <typename word>
+Workspace<word> *&ActiveWorkspace() {
+  static thread_local Workspace<word> *workspace = nullptr;
+  return workspace;
+}
+
+}  // namespace
+
+template <typename word>
+void Workspace<word>::Return(std::map<int, Ct> &cts) {
+  for (auto &[_, ct] : cts) Return(std::move(ct));
+  cts.clear();
+}
+
+template <typename word>
+Workspace<word> *Workspace<word>::GetActive() {
+  return ActiveWorkspace<word>();
+}
+
+template <typename word>
+Workspace<word>::Activation::Activation(Workspace *workspace)
+    : activated_{workspace != nullptr}, previous_{ActiveWorkspace<word>()} {
+  if (activated_) ActiveWorkspace<word>() = workspace;
+}
+
+template <typename word>
+Workspace<word>::Activation::~Activation() {
+  if (activated_) ActiveWorkspace<word>() = previous_;
+}
+
+template <typename word>
+Workspace<word>::Scope::Scope(Workspace *workspace) : workspace_{workspace} {}
+
+template <typename word>
+Workspace<word>::Scope::~Scope() {
+  if (workspace_ == nullptr) return;
+  for (auto &ct : cts_) workspace_->Return(std::move(ct));
+  for (auto &dv : dvs_) workspace_->Return(std::move(dv));
+  for (auto &dv_vector : dv_vectors_) {
+    for (auto &dv : dv_vector) workspace_->Return(std::move(dv));
+  }
+  for (auto &ct_map : ct_maps_) workspace_->Return(ct_map);
+}
+
+template <typename word>
+Ciphertext<word> &Workspace<word>::Scope::TakeCt(
+    const NPInfo &np /*= NPInfo{}*/) {
+  cts_.push_back(MakeCt(np));
+  return cts_.back();
+}
+
+template <typename word>
+DeviceVector<word> &Workspace<word>::Scope::TakeDv(int size) {
+  dvs_.push_back(MakeDv(size));
+  return dvs_.back();
+}
+
+template <typename word>
+std::vector<DeviceVector<word>> &Workspace<word>::Scope::TakeDvs(int count,
+                                                                 int size) {
+  return TakeDvs(std::vector<int>(count, size));
+}
+
+template <typename word>
+std::vector<DeviceVector<word>> &Workspace<word>::Scope::TakeDvs(
+    const std::vector<int> &sizes) {
+  auto &dv_vector = dv_vectors_.emplace_back();
+  dv_vector.reserve(sizes.size());
+  for (int size : sizes) dv_vector.push_back(MakeDv(size));
+  return dv_vector;
+}
+
+template <typename word>
+std::map<int, Ciphertext<word>> &Workspace<word>::Scope::TakeCtMap() {
+  return ct_maps_.emplace_back();
+}
+
+template <typename word>
+Ciphertext<word> Workspace<word>::Scope::MakeCt(
+    const NPInfo &np /*= NPInfo{}*/) {
+  if (workspace_ == nullptr) return Ct(np);
+  return workspace_->TakeCt(np);
+}
+
+template <typename word>
+DeviceVector<word> Workspace<word>::Scope::MakeDv(int size) {
+  if (workspace_ == nullptr) return Dv(size);
+  return workspace_->TakeDv(size);
+}
+
+template class Workspace<uint32_t>;
+template class Workspace<uint64_t>;
+
+}  // namespace cheddar
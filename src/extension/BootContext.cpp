@@ -1,6 +1,7 @@
 #include "extension/BootContext.h"
 
 #include <cmath>
+#include <utility>
 
 #include "common/Assert.h"
 #include "common/CommonUtils.h"
@@ -13,6 +14,20 @@ int Log2Scale(double scale) {
   return static_cast<int>(std::log2(scale) + 0.5);
 }
 
+struct FFTFileHeader {
+  static constexpr uint32_t kMagic = 0x46444843;  // "CHDF"
+  static constexpr uint16_t kVersion = 1;
+
+  uint32_t magic;
+  uint16_t version;
+  uint8_t word_bytes;
+  uint8_t variant;
+  int32_t num_slots;
+  int32_t reserved;
+  uint64_t param_fingerprint;
+  uint64_t boot_param_fingerprint;
+};
+
 }  // namespace
 
 namespace cheddar {
@@ -165,6 +180,55 @@ void BootContext<word>::PrepareEvalSpecialFFT(int num_slots,
   boot_variant_.try_emplace(num_slots, variant);
 }
 
+template <typename word>
+void BootContext<word>::ExportEvalSpecialFFT(std::ostream &os,
+                                             int num_slots) const {
+  AssertTrue(eval_fft_.find(num_slots) != eval_fft_.end(),
+             "EvalSpecialFFT not prepared for num slots: " +
+                 std::to_string(num_slots));
+  FFTFileHeader header{};
+  header.magic = FFTFileHeader::kMagic;
+  header.version = FFTFileHeader::kVersion;
+  header.word_bytes = sizeof(word);
+  header.variant = static_cast<uint8_t>(boot_variant_.at(num_slots));
+  header.num_slots = num_slots;
+  header.param_fingerprint = this->param_.GetFingerprint();
+  header.boot_param_fingerprint = boot_param_.GetFingerprint();
+  WriteValue(os, header);
+  eval_fft_.at(num_slots).Export(GetContext(), os);
+}
+
+template <typename word>
+size_t BootContext<word>::ImportEvalSpecialFFT(const void *buffer,
+                                               size_t size) {
+  SerialReader reader(buffer, size);
+  auto header = reader.Read<FFTFileHeader>();
+  AssertTrue(header.magic == FFTFileHeader::kMagic &&
+                 header.version == FFTFileHeader::kVersion &&
+                 header.word_bytes == sizeof(word),
+             "Invalid EvalSpecialFFT file");
+  AssertTrue(header.param_fingerprint == this->param_.GetFingerprint() &&
+                 header.boot_param_fingerprint == boot_param_.GetFingerprint(),
+             "EvalSpecialFFT file of different parameters");
+  int num_slots = header.num_slots;
+  AssertTrue(IsPowOfTwo(num_slots) && num_slots <= this->param_.degree_ / 2,
+             "Invalid number of slots in EvalSpecialFFT file");
+  AssertTrue(header.variant <= static_cast<uint8_t>(BootVariant::kMergeTwoReal),
+             "Invalid boot variant in EvalSpecialFFT file");
+  auto variant = static_cast<BootVariant>(header.variant);
+
+  EvalSpecialFFT<word> eval_fft(GetContext(), boot_param_, num_slots,
+                                GetCtSConst(), GetStCConst(variant), reader);
+  if (eval_fft_.find(num_slots) != eval_fft_.end()) {
+    Warn("EvalSpecialFFT already prepared for num slots: " +
+         std::to_string(num_slots));
+  } else {
+    eval_fft_.try_emplace(num_slots, std::move(eval_fft));
+    boot_variant_.try_emplace(num_slots, variant);
+  }
+  return reader.GetPosition();
+}
+
 template <typename word>
 bool BootContext<word>::IsBootPrepared(int num_slots) const {
   return (eval_mod_ != nullptr) &&
@@ -185,7 +249,9 @@ void BootContext<word>::AddRequiredRotations(EvkRequest &req, int num_slots,
 
 template <typename word>
 void BootContext<word>::ModUpToMax(Ct &res, const Ct &input,
-                                   const EvkMap<word> &evk_map) const {
+                                   const EvkMap<word> &evk_map,
+                                   BootWorkspace<word> *workspace
+                                   /*= nullptr*/) const {
   const int L = this->param_.L_;
   const int alpha = this->param_.alpha_;
   const int degree = this->param_.degree_;
@@ -203,16 +269,18 @@ void BootContext<word>::ModUpToMax(Ct &res, const Ct &input,
   const Ct *working_ct = &input;
   if (sse) {
     // Dense to sparse key-switch
-    const auto &dts_key = evk_map.GetDenseToSparseKey();
+    auto dts_key_ptr = evk_map.GetDenseToSparseKey();
+    const auto &dts_key = *dts_key_ptr;
 
     // DtS key-switch
     this->MultKey(res, input, dts_key);
     working_ct = &res;
   }
   // ModUpToMax sequence
-  Dv tmp_bx(L * degree);
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Dv &tmp_bx = scope.TakeDv(L * degree);
   int tmp_ax_num_aux = sse ? alpha : 0;
-  Dv tmp_ax((L + tmp_ax_num_aux) * degree);
+  Dv &tmp_ax = scope.TakeDv((L + tmp_ax_num_aux) * degree);
 
   DvView<word> res_bx_view = res.BxView();
   DvView<word> res_ax_view = res.AxView();
@@ -239,10 +307,11 @@ void BootContext<word>::ModUpToMax(Ct &res, const Ct &input,
 
   if (sse) {
     // StD key-switch
-    const auto &std_key = evk_map.GetSparseToDenseKey();
+    auto std_key_ptr = evk_map.GetSparseToDenseKey();
+    const auto &std_key = *std_key_ptr;
     const auto &std_mod_switcher = this->GetStDModSwitchHandler();
     // MultKey
-    Ct tmp_std(max_level_np);
+    Ct &tmp_std = scope.TakeCt(max_level_np);
     std::vector<DvView<word>> tmp_std_view = tmp_std.ViewVector();
     this->elem_handler_.PMult(tmp_std_view, max_level_np,
                               std_key.ConstViewVector(0),
@@ -265,8 +334,9 @@ void BootContext<word>::ModUpToMax(Ct &res, const Ct &input,
     std_mod_switcher.ModDown(final_bx_view, tmp_std.BxConstView());
     std_mod_switcher.ModDown(final_ax_view, tmp_std.AxConstView());
   } else {
-    res.bx_ = std::move(tmp_bx);
-    res.ax_ = std::move(tmp_ax);
+    // The previous buffers of res are given back instead
+    std::swap(res.bx_, tmp_bx);
+    std::swap(res.ax_, tmp_ax);
     res.ModifyNP(max_level_np);
   }
 }
@@ -274,42 +344,130 @@ void BootContext<word>::ModUpToMax(Ct &res, const Ct &input,
 template <typename word>
 void BootContext<word>::CoeffToSlot(Ct &res, int num_slots, const Ct &input,
                                     const EvkMap<word> &evk_map,
-                                    bool min_ks /*= false*/) const {
+                                    bool min_ks /*= false*/,
+                                    BootWorkspace<word> *workspace
+                                    /*= nullptr*/) const {
   eval_fft_.at(num_slots).EvaluateCtS(GetContext(), res, input, evk_map,
-                                      min_ks);
+                                      min_ks, workspace);
 }
 
 template <typename word>
 void BootContext<word>::SlotToCoeff(Ct &res, int num_slots, const Ct &input,
                                     const EvkMap<word> &evk_map,
-                                    bool min_ks /*= false*/) const {
+                                    bool min_ks /*= false*/,
+                                    BootWorkspace<word> *workspace
+                                    /*= nullptr*/) const {
   eval_fft_.at(num_slots).EvaluateStC(GetContext(), res, input, evk_map,
-                                      min_ks);
+                                      min_ks, workspace);
 }
 
 template <typename word>
 void BootContext<word>::EvaluateMod(Ct &res, const Ct &input,
-                                    const Evk &mult_key) const {
+                                    const Evk &mult_key,
+                                    BootWorkspace<word> *workspace
+                                    /*= nullptr*/) const {
   AssertTrue(eval_mod_ != nullptr, "EvalMod not prepared");
   this->AssertSameScale(input, eval_mod_->start_scale_);
-  eval_mod_->Evaluate(GetContext(), res, input, mult_key);
+  eval_mod_->Evaluate(GetContext(), res, input, mult_key, workspace);
   this->AssertSameScale(res, eval_mod_->end_scale_);
 }
 
 template <typename word>
 void BootContext<word>::Boot(Ct &res, const Ct &input,
                              const EvkMap<word> &evk_map, bool min_ks) const {
+  EvaluateBoot(res, input, evk_map, min_ks, nullptr);
+}
+
+template <typename word>
+void BootContext<word>::Boot(Ct &res, const Ct &input,
+                             const EvkMap<word> &evk_map,
+                             BootWorkspace<word> &workspace,
+                             bool min_ks) const {
+  EvaluateBoot(res, input, evk_map, min_ks, &workspace);
+}
+
+template <typename word>
+BootWorkspace<word> BootContext<word>::CreateWorkspace(int num_slots) const {
+  num_slots = GetBootEnabledNumSlots(num_slots);
+  AssertTrue(eval_mod_ != nullptr, "EvalMod not prepared");
+  auto size = GetWorkspaceSize(this->param_,
+                               eval_fft_.at(num_slots).GetNumWorkspaceCts(),
+                               eval_mod_->GetNumWorkspaceCts());
+  return BootWorkspace<word>(size.num_cts, size.ct_np, size.num_dvs,
+                             size.dv_size);
+}
+
+template <typename word>
+size_t BootContext<word>::WorkspaceSize::GetBytes(int degree) const {
+  // With rx (see BootWorkspace)
+  size_t ct_size = 3 * static_cast<size_t>(ct_np.GetNumTotal()) * degree;
+  return (num_cts * ct_size + static_cast<size_t>(num_dvs) * dv_size) *
+         sizeof(word);
+}
+
+template <typename word>
+typename BootContext<word>::WorkspaceSize BootContext<word>::GetWorkspaceSize(
+    const Parameter<word> &param, int num_fft_cts, int num_mod_cts) {
+  NPInfo max_np = param.LevelToNP(param.max_level_);
+  int alpha = param.alpha_;
+  WorkspaceSize res;
+
+  // Boot keeps up to three (with a level-down input) during the evaluations
+  // below, and ModUpToMax takes one.
+  res.num_cts = 3 + Max(1, num_fft_cts, num_mod_cts);
+  res.ct_np = NPInfo(max_np.num_main_, max_np.num_ter_, alpha);
+
+  // ModUp results of the hoisted rotations (beta of them) and one more
+  int max_num_q = max_np.GetNumQ();
+  int beta = DivCeil(max_num_q + param.GetMaxNumTer() - max_np.num_ter_, alpha);
+  res.num_dvs = Max(2, beta + 1);
+  res.dv_size = (Max(param.L_, max_num_q) + alpha) * param.degree_;
+
+  // The Context operations take from the workspace as well (see
+  // Context::GetKeySwitchBytes): two ciphertexts (the result of MultKey and
+  // its accumulator, or those of LevelDown), the ModUp results, and an INTT
+  // buffer.
+  res.num_cts += 2;
+  res.num_dvs += beta + 1;
+  return res;
+}
+
+template <typename word>
+MemoryFootprint BootContext<word>::EstimateMemoryFootprint(
+    const Parameter<word> &param, const BootParameter &boot_param,
+    const std::vector<int> &num_slots, const EvkRequest &evk_request /*= {}*/) {
+  MemoryFootprint res = Base::EstimateMemoryFootprint(param, evk_request);
+  int num_mod_cts = EvalMod<word>::EstimateNumWorkspaceCts(boot_param);
+  for (int ns : num_slots) {
+    res.boot_plaintext_bytes +=
+        EvalSpecialFFT<word>::GetPlaintextBytes(param, boot_param, ns);
+    int num_fft_cts = EvalSpecialFFT<word>::EstimateNumWorkspaceCts(
+        boot_param, ns);
+    size_t boot_bytes = GetWorkspaceSize(param, num_fft_cts, num_mod_cts)
+                            .GetBytes(param.degree_);
+    res.peak_temporary_bytes = Max(res.peak_temporary_bytes, boot_bytes);
+  }
+  return res;
+}
+
+template <typename word>
+void BootContext<word>::EvaluateBoot(Ct &res, const Ct &input,
+                                     const EvkMap<word> &evk_map, bool min_ks,
+                                     BootWorkspace<word> *workspace) const {
   int half_degree = this->param_.degree_ / 2;
   int input_num_slots = input.GetNumSlots();
   int num_slots = GetBootEnabledNumSlots(input_num_slots);
   bool full_slot = (num_slots == half_degree);
   AssertTrue(eval_mod_ != nullptr, "EvalMod not prepared");
 
-  Ct main_ct;
+  // The temporaries of the Context operations are taken from it as well.
+  typename Workspace<word>::Activation activation(workspace);
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Ct &main_ct = scope.TakeCt();
   int input_level = this->param_.NPToLevel(input.GetNP());
   if (input_level > 0) {
     this->LevelDown(main_ct, input, 0);
-    Boot(res, main_ct, evk_map, min_ks);
+    EvaluateBoot(res, main_ct, evk_map, min_ks, workspace);
     return;
   }
 
@@ -319,7 +477,7 @@ void BootContext<word>::Boot(Ct &res, const Ct &input,
   this->MultUnsafe(main_ct, input, scaleup_const_, -1);
 
   // 1. ModUpToMax with optional DtS/StD key-switch + Trace
-  ModUpToMax(main_ct, main_ct, evk_map);
+  ModUpToMax(main_ct, main_ct, evk_map, workspace);
 
   // Perform trace
   main_ct.SetNumSlots(half_degree);
@@ -327,33 +485,33 @@ void BootContext<word>::Boot(Ct &res, const Ct &input,
   main_ct.SetNumSlots(num_slots);
 
   // 2. Perform CtS
-  CoeffToSlot(main_ct, num_slots, main_ct, evk_map, min_ks);
+  CoeffToSlot(main_ct, num_slots, main_ct, evk_map, min_ks, workspace);
 
   // 3. Extract real/imag part and perform EvalMod
   main_ct.SetScale(eval_mod_->start_scale_);
   if (full_slot) {
-    Ct ct_conj;
-    this->HConj(ct_conj, main_ct, evk_map.GetConjugationKey());
+    Ct &ct_conj = scope.TakeCt();
+    this->HConj(ct_conj, main_ct, *evk_map.GetConjugationKey());
     // Perform eval mod on real and imag part separately
     this->Add(res, main_ct, ct_conj);
     this->Sub(ct_conj, ct_conj, main_ct);
     this->MultImaginaryUnit(ct_conj, ct_conj);
-    EvaluateMod(res, res, evk_map.GetMultiplicationKey());
-    EvaluateMod(ct_conj, ct_conj, evk_map.GetMultiplicationKey());
+    EvaluateMod(res, res, *evk_map.GetMultiplicationKey(), workspace);
+    EvaluateMod(ct_conj, ct_conj, *evk_map.GetMultiplicationKey(), workspace);
     this->MultImaginaryUnit(ct_conj, ct_conj);
     this->Add(res, res, ct_conj);
   } else {
     // Can merge real and imag part using extra slots
-    this->HConjAdd(res, main_ct, main_ct, evk_map.GetConjugationKey());
-    EvaluateMod(res, res, evk_map.GetMultiplicationKey());
+    this->HConjAdd(res, main_ct, main_ct, *evk_map.GetConjugationKey());
+    EvaluateMod(res, res, *evk_map.GetMultiplicationKey(), workspace);
   }
 
   // 4. Finally, perform StC
-  SlotToCoeff(res, num_slots, res, evk_map, min_ks);
+  SlotToCoeff(res, num_slots, res, evk_map, min_ks, workspace);
 
   if (boot_variant_.at(num_slots) == BootVariant::kImaginaryRemoving) {
     // res += HConJ(res)
-    this->HConjAdd(res, res, res, evk_map.GetConjugationKey());
+    this->HConjAdd(res, res, res, *evk_map.GetConjugationKey());
   }
   // For kNormal of kMergeTwoReal, no additional operation is needed inside
   // this function. For kMergeTwoReal, extra ops are required after returing.
@@ -390,7 +548,8 @@ void BootContext<word>::Trace(Ct &res, int start_rot_dist, int num_accum,
   for (int i = 0; i < log_num_accum; i++) {
     int rot_idx = (start_rot_dist * (1 << i)) % num_slots;
     if (rot_idx < 0) rot_idx += num_slots;
-    const auto &evk = evk_map.GetRotationKey(rot_idx);
+    auto evk_ptr = evk_map.GetRotationKey(rot_idx);
+    const auto &evk = *evk_ptr;
     if (i == 0) {
       // res = HRot(input, rot_idx) + input
       this->HRotAdd(res, input, input, evk, rot_idx);
@@ -1,5 +1,7 @@
 #include "extension/BootParameter.h"
 
+#include <cstring>
+
 #include "common/CommonUtils.h"
 
 namespace cheddar {
@@ -39,4 +41,26 @@ int BootParameter::GetEndLevel() const {
   return GetStCStartLevel() - num_stc_levels_;
 }
 
+uint64_t BootParameter::GetFingerprint() const {
+  // 64-bit FNV-1a over the parameters
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  auto mix = [&hash](uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= UINT64_C(0x100000001b3);
+    }
+  };
+  for (int value : {max_level_, num_cts_levels_, num_stc_levels_,
+                    log_message_ratio_, num_double_angle_, initial_K_}) {
+    mix(value);
+  }
+  mix(mod_coefficients_.size());
+  for (double coefficient : mod_coefficients_) {
+    uint64_t bits;
+    std::memcpy(&bits, &coefficient, sizeof(bits));
+    mix(bits);
+  }
+  return hash;
+}
+
 }  // namespace cheddar
\ No newline at end of file
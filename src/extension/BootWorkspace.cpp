@@ -0,0 +1,79 @@
+#include "extension/BootWorkspace.h"
+
+#include <utility>
+
+#include "common/Assert.h"
+
+namespace cheddar {
+
+template <typename word>
+BootWorkspace<word>::BootWorkspace(int num_cts, const NPInfo &ct_np,
+                                   int num_dvs, int dv_size) {
+  AssertTrue(num_cts >= 0 && num_dvs >= 0 && dv_size >= 0,
+             "BootWorkspace: Invalid size");
+  free_cts_.reserve(num_cts);
+  // With rx, for the tensor products in EvalPoly
+  for (int i = 0; i < num_cts; i++) free_cts_.emplace_back(ct_np, true);
+  free_dvs_.reserve(num_dvs);
+  for (int i = 0; i < num_dvs; i++) free_dvs_.emplace_back(dv_size);
+}
+
+template <typename word>
+Ciphertext<word> BootWorkspace<word>::TakeCt(const NPInfo &np /*= NPInfo{}*/) {
+  Ct res(NPInfo{});
+  if (!free_cts_.empty()) {
+    // Only the buffers are reused; the rest is the same as a new ciphertext.
+    Ct &ct = free_cts_.back();
+    std::swap(res.bx_, ct.bx_);
+    std::swap(res.ax_, ct.ax_);
+    std::swap(res.rx_, ct.rx_);
+    free_cts_.pop_back();
+    res.RemoveRx();
+  }
+  res.ModifyNP(np);
+  return res;
+}
+
+template <typename word>
+DeviceVector<word> BootWorkspace<word>::TakeDv(int size) {
+  if (free_dvs_.empty()) return Dv(size);
+  Dv res = std::move(free_dvs_.back());
+  free_dvs_.pop_back();
+  res.resize(size);
+  return res;
+}
+
+template <typename word>
+void BootWorkspace<word>::Return(Ct &&ct) {
+  free_cts_.push_back(std::move(ct));
+}
+
+template <typename word>
+void BootWorkspace<word>::Return(Dv &&dv) {
+  free_dvs_.push_back(std::move(dv));
+}
+
+template <typename word>
+int BootWorkspace<word>::GetNumCts() const {
+  return free_cts_.size();
+}
+
+template <typename word>
+int BootWorkspace<word>::GetNumDvs() const {
+  return free_dvs_.size();
+}
+
+template <typename word>
+size_t BootWorkspace<word>::GetReservedBytes() const {
+  size_t res = 0;
+  for (const auto &ct : free_cts_) {
+    res += ct.bx_.capacity() + ct.ax_.capacity() + ct.rx_.capacity();
+  }
+  for (const auto &dv : free_dvs_) res += dv.capacity();
+  return res * sizeof(word);
+}
+
+template class BootWorkspace<uint32_t>;
+template class BootWorkspace<uint64_t>;
+
+}  // namespace cheddar
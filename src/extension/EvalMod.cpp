@@ -19,8 +19,8 @@ EvalMod<word>::EvalMod(ConstContextPtr<word> context,
 
   // See the development notes for details
   int actual_K = (1 << boot_param.num_double_angle_) * boot_param.initial_K_;
-  context->encoder_.EncodeConstant(initial_const_, start_level, start_scale_,
-                                   -0.25 / actual_K);
+  context->constant_cache_.EncodeConstant(initial_const_, start_level,
+                                          start_scale_, -0.25 / actual_K);
 
   const auto &mod_coefficients = boot_param.mod_coefficients_;
   int mod_levels = Log2Ceil(mod_coefficients.size());
@@ -52,14 +52,33 @@ EvalMod<word>::EvalMod(ConstContextPtr<word> context,
 
 template <typename word>
 void EvalMod<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
-                             const Ct &input, const Evk &mult_key) {
+                             const Ct &input, const Evk &mult_key,
+                             BootWorkspace<word> *workspace /*= nullptr*/) {
   context->Add(res, input, initial_const_);
-  mod_functions_[0].Evaluate(context, res, res, mult_key);
+  mod_functions_[0].Evaluate(context, res, res, mult_key, workspace);
   for (const auto &da : double_angle_) {
-    da.Evaluate(context, res, res, res, mult_key);
+    da.Evaluate(context, res, res, res, mult_key, workspace);
   }
 }
 
+template <typename word>
+int EvalMod<word>::GetNumWorkspaceCts() const {
+  int res = 1;  // AXYPBZ of the double angles
+  for (const auto &mod_function : mod_functions_) {
+    res = Max(res, mod_function.GetNumWorkspaceCts());
+  }
+  return res;
+}
+
+template <typename word>
+int EvalMod<word>::EstimateNumWorkspaceCts(const BootParameter &boot_param) {
+  // The scales do not change the evaluation tree.
+  EvalPoly<word> mod_function(boot_param.mod_coefficients_,
+                              boot_param.GetEvalModStartLevel(), 1.0, 1.0,
+                              true);
+  return Max(1, mod_function.GetNumWorkspaceCts());
+}
+
 template <typename word>
 int EvalMod<word>::GetEvalModPolyDegree(int poly_index /*= 0*/) const {
   return mod_functions_.at(poly_index).GetPolyDegree();
@@ -136,7 +136,7 @@ AXYPBZ<word>::AXYPBZ(ConstContextPtr<word> context, int a, double b,
     has_b_ = true;
     AssertTrue(context->IsMultUnsafeCompatible(z_level, working_level),
                "AXYPBZ: Invalid levels");
-    context->encoder_.EncodeConstant(b_, working_level, b_scale, b);
+    context->constant_cache_.EncodeConstant(b_, working_level, b_scale, b);
   }
 
   AssertTrue(a != 0, "AXYPBZ: a should not be 0");
@@ -144,7 +144,7 @@ AXYPBZ<word>::AXYPBZ(ConstContextPtr<word> context, int a, double b,
     has_a_ = false;
   } else {
     has_a_ = true;
-    context->encoder_.EncodeConstant(a_, working_level, 1.0, a);
+    context->constant_cache_.EncodeConstant(a_, working_level, 1.0, a);
   }
 
   final_level_ = working_level - 1;
@@ -173,7 +173,8 @@ AXYPBZ<word>::AXYPBZ(ConstContextPtr<word> context, int a, double b,
     has_b_ = false;
   } else {
     has_b_ = true;
-    context->encoder_.EncodeConstant(b_, working_level, working_scale, b);
+    context->constant_cache_.EncodeConstant(b_, working_level, working_scale,
+                                            b);
   }
 
   AssertTrue(a != 0, "AXYPBZ: a should not be 0");
@@ -181,7 +182,7 @@ AXYPBZ<word>::AXYPBZ(ConstContextPtr<word> context, int a, double b,
     has_a_ = false;
   } else {
     has_a_ = true;
-    context->encoder_.EncodeConstant(a_, working_level, 1.0, a);
+    context->constant_cache_.EncodeConstant(a_, working_level, 1.0, a);
   }
 
   final_level_ = working_level - 1;
@@ -191,8 +192,9 @@ AXYPBZ<word>::AXYPBZ(ConstContextPtr<word> context, int a, double b,
 
 template <typename word>
 void AXYPBZ<word>::Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
-                            const Ct &y, const Ct &z,
-                            const Evk &mult_key) const {
+                            const Ct &y, const Ct &z, const Evk &mult_key,
+                            BootWorkspace<word> *workspace
+                            /*= nullptr*/) const {
   AssertTrue(has_z_, "Z should be provided for AXYPBZ with Z");
   AssertTrue(!x.HasRx() && !y.HasRx() && !z.HasRx(),
              "AXYPBZ: Relinearization required");
@@ -200,7 +202,8 @@ void AXYPBZ<word>::Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
   AssertSameLevelAndScale(context, y, y_level_, y_scale_);
   AssertSameLevelAndScale(context, z, z_level_, z_scale_);
 
-  Ct tmp1;
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Ct &tmp1 = scope.TakeCt();
   if (has_a_) {  // a != 1
     context->MultUnsafe(tmp1, x, a_, final_level_ + 1);
     context->MultUnsafe(tmp1, tmp1, y, final_level_ + 1);
@@ -228,13 +231,16 @@ void AXYPBZ<word>::Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
 
 template <typename word>
 void AXYPBZ<word>::Evaluate(ConstContextPtr<word> context, Ct &res, const Ct &x,
-                            const Ct &y, const Evk &mult_key) const {
+                            const Ct &y, const Evk &mult_key,
+                            BootWorkspace<word> *workspace
+                            /*= nullptr*/) const {
   AssertTrue(!has_z_, "Z should not be provided for AXYPBZ without Z");
   AssertTrue(!x.HasRx() && !y.HasRx(), "AXYPBZ: Relinearization required");
   AssertSameLevelAndScale(context, x, x_level_, x_scale_);
   AssertSameLevelAndScale(context, y, y_level_, y_scale_);
 
-  Ct tmp1;
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Ct &tmp1 = scope.TakeCt();
   if (has_a_) {  // a != 1
     context->MultUnsafe(tmp1, x, a_, final_level_ + 1);
     context->MultUnsafe(tmp1, tmp1, y, final_level_ + 1);
@@ -354,7 +360,9 @@ void BasisMap<word>::AddBase(ConstContextPtr<word> context, int base_degree) {
 template <typename word>
 void BasisMap<word>::Evaluate(ConstContextPtr<word> context,
                               std::map<int, MLCt> &res,
-                              const Evk &mult_key) const {
+                              const Evk &mult_key,
+                              BootWorkspace<word> *workspace
+                              /*= nullptr*/) const {
   AssertTrue(!basis_eval_.empty(), "BasisMap: basis_eval_ is empty.");
 
   for (const auto &[base_degree, eval] : basis_eval_) {
@@ -375,9 +383,9 @@ void BasisMap<word>::Evaluate(ConstContextPtr<word> context,
       int sub_level = eval.z_level_;
       context->AddLowerLevelsUntil(res.at(sub_degree), sub_level);
       const Ct &sub = res.at(sub_degree).AtLevel(sub_level);
-      eval.Evaluate(context, new_base, left, right, sub, mult_key);
+      eval.Evaluate(context, new_base, left, right, sub, mult_key, workspace);
     } else {
-      eval.Evaluate(context, new_base, left, right, mult_key);
+      eval.Evaluate(context, new_base, left, right, mult_key, workspace);
     }
     res.try_emplace(base_degree, std::move(new_base));
   }
@@ -493,8 +501,8 @@ void EvalPolyNode<word>::Compile(ConstContextPtr<word> context,
   }
 
   if (is_low_constant_ && (!is_low_zero_)) {
-    context->encoder_.EncodeConstant(low_constant_, working_level,
-                                     working_scale, coefficients_[0]);
+    context->constant_cache_.EncodeConstant(low_constant_, working_level,
+                                            working_scale, coefficients_[0]);
   } else if (low_ != nullptr) {
     // Low parts target higher scale (lazy rescaling)
     low_->Compile(context, basis_eval, working_level, working_scale, false);
@@ -503,9 +511,9 @@ void EvalPolyNode<word>::Compile(ConstContextPtr<word> context,
     auto [_, split_scale] = basis_eval.GetBaseLevelAndScale(split_degree_);
     double high_scale = working_scale / split_scale;
     if (is_high_constant_) {
-      context->encoder_.EncodeConstant(high_constant_, high_scale,
-                                       working_level,
-                                       coefficients_[split_degree_]);
+      context->constant_cache_.EncodeConstant(high_constant_, working_level,
+                                              high_scale,
+                                              coefficients_[split_degree_]);
     } else {
       high_->Compile(context, basis_eval, working_level, high_scale, true);
     }
@@ -519,32 +527,50 @@ void EvalPolyNode<word>::Compile(ConstContextPtr<word> context,
       auto [_, base_scale] = basis_eval.GetBaseLevelAndScale(base_degree);
       scale /= base_scale;
     }
-    context->encoder_.EncodeConstant(constant, working_level, scale, value);
+    context->constant_cache_.EncodeConstant(constant, working_level, scale,
+                                            value);
   }
 }
 
 template <typename word>
 void EvalPolyNode<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
                                   std::map<int, MLCt> &basis,
-                                  const Evk &mult_key) const {
+                                  const Evk &mult_key,
+                                  BootWorkspace<word> *workspace
+                                  /*= nullptr*/) const {
   if (IsLeaf()) {
     // Evaluate is not for in-place operations
-    EvaluateLeaf(context, res, basis, mult_key, false);
+    EvaluateLeaf(context, res, basis, mult_key, false, workspace);
   } else {
-    EvaluateMiddleNode(context, res, basis, mult_key);
+    EvaluateMiddleNode(context, res, basis, mult_key, workspace);
   }
 }
 
+template <typename word>
+int EvalPolyNode<word>::GetNumWorkspaceCts(
+    bool do_rescale /*= true*/) const {
+  // See Compile for the do_rescale of the children
+  int res = do_rescale ? 1 : 0;
+  if (IsLeaf()) return res;
+  int high = (high_ != nullptr) ? high_->GetNumWorkspaceCts(true) : 0;
+  int low = (low_ != nullptr && !low_->IsLeaf())
+                ? low_->GetNumWorkspaceCts(false) + 1
+                : 0;
+  return res + Max(high, low);
+}
+
 template <typename word>
 void EvalPolyNode<word>::EvaluateMiddleNode(ConstContextPtr<word> context,
                                             Ct &res, std::map<int, MLCt> &basis,
-                                            const Evk &mult_key) const {
-  Ct tmp;
+                                            const Evk &mult_key,
+                                            BootWorkspace<word> *workspace)
+    const {
+  typename BootWorkspace<word>::Scope scope(workspace);
   Ct *accum = &res;
   int working_level = target_level_;
   if (do_rescale_) {
     working_level += 1;
-    accum = &tmp;
+    accum = &scope.TakeCt();
   }
   AssertTrue(high_ != nullptr || is_high_constant_,
              "This is not a middle node");
@@ -557,7 +583,7 @@ void EvalPolyNode<word>::EvaluateMiddleNode(ConstContextPtr<word> context,
   const Ct &split = ml_split.AtLevel(ml_split_level);
 
   if (high_ != nullptr) {
-    high_->Evaluate(context, *accum, basis, mult_key);
+    high_->Evaluate(context, *accum, basis, mult_key, workspace);
     context->MultUnsafe(*accum, *accum, split, working_level);
   } else if (is_high_constant_) {
     context->MultUnsafe(*accum, split, high_constant_, working_level);
@@ -568,10 +594,10 @@ void EvalPolyNode<word>::EvaluateMiddleNode(ConstContextPtr<word> context,
   if (low_ != nullptr) {
     if (low_->IsLeaf()) {
       // This will perform inplace mad addition to accum (optimized)
-      low_->EvaluateLeaf(context, *accum, basis, mult_key, true);
+      low_->EvaluateLeaf(context, *accum, basis, mult_key, true, workspace);
     } else {
-      Ct tmp2;
-      low_->Evaluate(context, tmp2, basis, mult_key);
+      Ct &tmp2 = scope.TakeCt();
+      low_->Evaluate(context, tmp2, basis, mult_key, workspace);
       context->Add(*accum, *accum, tmp2);
     }
   } else if (is_low_constant_ && (!is_low_zero_)) {
@@ -589,17 +615,18 @@ void EvalPolyNode<word>::EvaluateMiddleNode(ConstContextPtr<word> context,
 template <typename word>
 void EvalPolyNode<word>::EvaluateLeaf(ConstContextPtr<word> context, Ct &res,
                                       std::map<int, MLCt> &basis,
-                                      const Evk &mult_key, bool inplace) const {
+                                      const Evk &mult_key, bool inplace,
+                                      BootWorkspace<word> *workspace) const {
   AssertFalse(do_rescale_ && inplace,
               "Rescale and inplace EvaluateLeaf is not compatible");
   AssertTrue(IsLeaf() && !leaf_constants_.empty(),
              "This is not a leaf node or leaf constants are not available.");
 
-  Ct tmp;
+  typename BootWorkspace<word>::Scope scope(workspace);
   Ct *accum = &res;
   int working_level = target_level_;
   if (do_rescale_) {
-    accum = &tmp;
+    accum = &scope.TakeCt();
     working_level += 1;
   }
 
@@ -796,13 +823,19 @@ void EvalPoly<word>::PreparePlainChebyshevBasis() {
 }
 
 template <typename word>
-void EvalPoly<word>::Compile(ConstContextPtr<word> context) {
-  // Construct main evaluation tree
+std::shared_ptr<EvalPolyNode<word>> EvalPoly<word>::CreateTree() const {
   int level_consumption = Log2Ceil(GetPolyDegree() + 1);
   int baby_threshold = 1 << DivCeil(level_consumption, 2);
 
-  tree_root_ = std::make_shared<EvalPolyNode<word>>(
+  return std::make_shared<EvalPolyNode<word>>(
       coefficients_, level_consumption, baby_threshold, chebyshev_);
+}
+
+template <typename word>
+void EvalPoly<word>::Compile(ConstContextPtr<word> context) {
+  // Construct main evaluation tree
+  int level_consumption = Log2Ceil(GetPolyDegree() + 1);
+  tree_root_ = CreateTree();
 
   // Construct basis evaluation sequences
   std::set<int> required_base_degrees;
@@ -820,7 +853,9 @@ void EvalPoly<word>::Compile(ConstContextPtr<word> context) {
 
 template <typename word>
 void EvalPoly<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
-                              const Ct &input, const Evk &mult_key) const {
+                              const Ct &input, const Evk &mult_key,
+                              BootWorkspace<word> *workspace
+                              /*= nullptr*/) const {
   AssertTrue(tree_root_ != nullptr, "EvalPoly: not compiled.");
   NPInfo np = input.GetNP();
   AssertTrue(context->param_.NPToLevel(np) == input_level_,
@@ -836,13 +871,21 @@ void EvalPoly<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
   context->Copy(input_tmp, input);
   basis.try_emplace(1, std::move(input_tmp));
 
-  basis_map_.Evaluate(context, basis, mult_key);
-  tree_root_->Evaluate(context, res, basis, mult_key);
+  basis_map_.Evaluate(context, basis, mult_key, workspace);
+  tree_root_->Evaluate(context, res, basis, mult_key, workspace);
   // To avoid double calculation errors, manually set target scale
   context->AssertSameScale(res, target_scale_);
   res.SetScale(target_scale_);
 }
 
+template <typename word>
+int EvalPoly<word>::GetNumWorkspaceCts() const {
+  // The tree only depends on the coefficients
+  auto tree_root = (tree_root_ != nullptr) ? tree_root_ : CreateTree();
+  // AXYPBZ of the basis evaluation takes one
+  return Max(1, tree_root->GetNumWorkspaceCts());
+}
+
 template <typename word>
 double EvalPoly<word>::PlainEvaluate(double input) const {
   AssertTrue(tree_root_ != nullptr, "EvalPoly: not compiled.");
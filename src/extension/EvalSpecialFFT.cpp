@@ -1,6 +1,7 @@
 #include "extension/EvalSpecialFFT.h"
 
 #include <cmath>
+#include <set>
 
 #include "common/Assert.h"
 #include "common/CommonUtils.h"
@@ -27,7 +28,31 @@ EvalSpecialFFT<word>::EvalSpecialFFT(ConstContextPtr<word> context,
 }
 
 template <typename word>
-std::pair<int, int> EvalSpecialFFT<word>::BSGSSplit(int num_diag) const {
+EvalSpecialFFT<word>::EvalSpecialFFT(ConstContextPtr<word> context,
+                                     const BootParameter &boot_param,
+                                     int num_slots, double cts_const,
+                                     double stc_const, SerialReader &reader)
+    : num_slots_{num_slots},
+      boot_param_{boot_param},
+      cts_const_{cts_const},
+      stc_const_{stc_const},
+      full_slot_{num_slots == context->param_.degree_ / 2} {
+  int num_cts_phases = reader.Read<int32_t>();
+  AssertTrue(num_cts_phases == boot_param_.num_cts_levels_,
+             "EvalSpecialFFT: CtS phases do not match the BootParameter");
+  for (int i = 0; i < num_cts_phases; i++) {
+    cts_phases_.emplace_back(context, reader);
+  }
+  int num_stc_phases = reader.Read<int32_t>();
+  AssertTrue(num_stc_phases == boot_param_.num_stc_levels_,
+             "EvalSpecialFFT: StC phases do not match the BootParameter");
+  for (int i = 0; i < num_stc_phases; i++) {
+    stc_phases_.emplace_back(context, reader);
+  }
+}
+
+template <typename word>
+std::pair<int, int> EvalSpecialFFT<word>::BSGSSplit(int num_diag) {
   AssertTrue(IsPowOfTwo(num_diag) || IsPowOfTwo(num_diag + 1),
              "Invalid number of diagonals for EvalSpecialFFT");
   // this is somewhat heuristic
@@ -61,6 +86,111 @@ std::pair<int, int> EvalSpecialFFT<word>::BSGSSplit(int num_diag) const {
   return {bs, gs};
 }
 
+template <typename word>
+std::vector<int> EvalSpecialFFT<word>::SplitStages(int log_num_slots,
+                                                   int num_phases, bool cts) {
+  std::vector<int> res;
+  int stages_left = log_num_slots;
+  for (int i = 0; i < num_phases; i++) {
+    int num_stages;
+    if (cts && i == 0) {
+      num_stages = DivCeil(stages_left, num_phases);
+    } else {
+      num_stages = stages_left / (num_phases - i);
+    }
+    stages_left -= num_stages;
+    res.push_back(num_stages);
+  }
+  return res;
+}
+
+template <typename word>
+std::vector<typename EvalSpecialFFT<word>::PhaseShape>
+EvalSpecialFFT<word>::GetPhaseShapes(const BootParameter &boot_param,
+                                     int num_slots) {
+  AssertTrue(num_slots >= 256,
+             "Currently only high number of slots are supported");
+  AssertTrue(IsPowOfTwo(num_slots), "Number of slots must be a power of 2");
+  int log_num_slots = Log2Ceil(num_slots);
+  // The diagonals of the FFT stage of stride 2^i (see PopulatePlainMatrices)
+  auto stage_diags = [&](int i) {
+    std::set<int> diags{0, 1 << i};
+    if (i != log_num_slots - 1) diags.insert(num_slots - (1 << i));
+    return diags;
+  };
+  // The diagonals of a product (see StripedMatrix::Mult)
+  auto mult_diags = [&](const std::set<int> &a, const std::set<int> &b) {
+    std::set<int> c;
+    for (int i : a) {
+      for (int j : b) c.insert((i + j) % num_slots);
+    }
+    return c;
+  };
+
+  // See PreparePlaintexts
+  std::vector<PhaseShape> res;
+  int num_cts_phases = boot_param.num_cts_levels_;
+  auto cts_stages = SplitStages(log_num_slots, num_cts_phases, true);
+  int stages_cumul = 0;
+  for (int i = 0; i < num_cts_phases; i++) {
+    std::set<int> diags{0};
+    for (int j = stages_cumul; j < stages_cumul + cts_stages[i]; j++) {
+      // plain_ifft_stages_[j] has the diagonals of FFT stage
+      // (log_num_slots - 1 - j)
+      diags = mult_diags(stage_diags(log_num_slots - 1 - j), diags);
+    }
+    stages_cumul += cts_stages[i];
+    int num_diag = diags.size();
+    int num_eff_diag = num_diag + (i == num_cts_phases - 1 ? 1 : 0);
+    res.push_back({boot_param.GetCtSStartLevel() - i, num_diag, num_eff_diag});
+  }
+  int num_stc_phases = boot_param.num_stc_levels_;
+  auto stc_stages = SplitStages(log_num_slots, num_stc_phases, false);
+  stages_cumul = 0;
+  for (int i = 0; i < num_stc_phases; i++) {
+    std::set<int> diags{0};
+    for (int j = stages_cumul; j < stages_cumul + stc_stages[i]; j++) {
+      diags = mult_diags(stage_diags(j), diags);
+    }
+    stages_cumul += stc_stages[i];
+    int num_diag = diags.size();
+    int num_eff_diag = num_diag + (i == 0 ? 1 : 0);
+    res.push_back({boot_param.GetStCStartLevel() - i, num_diag, num_eff_diag});
+  }
+  return res;
+}
+
+template <typename word>
+size_t EvalSpecialFFT<word>::GetPlaintextBytes(const Parameter<word> &param,
+                                               const BootParameter &boot_param,
+                                               int num_slots) {
+  AssertTrue(num_slots <= param.degree_ / 2,
+             "Number of slots exceeds the maximum possible");
+  size_t res = 0;
+  for (const auto &shape : GetPhaseShapes(boot_param, num_slots)) {
+    // Encoded with alpha auxiliary primes (see HoistHandler)
+    NPInfo np = param.LevelToNP(shape.level, param.alpha_);
+    res += static_cast<size_t>(shape.num_diag) * np.GetNumTotal() *
+           param.degree_ * sizeof(word);
+  }
+  return res;
+}
+
+template <typename word>
+int EvalSpecialFFT<word>::EstimateNumWorkspaceCts(
+    const BootParameter &boot_param, int num_slots) {
+  int res = 0;
+  for (const auto &shape : GetPhaseShapes(boot_param, num_slots)) {
+    auto [bs, gs] = BSGSSplit(shape.num_eff_diag);
+    // At most bs distinct baby steps and gs distinct giant steps, unless a
+    // single giant step takes every diagonal
+    int num_bs = (gs == 1) ? 1 : bs;
+    int num_gs = (gs == 1) ? shape.num_diag : gs;
+    res = Max(res, HoistHandler<word>::GetNumWorkspaceCts(num_bs, num_gs));
+  }
+  return res;
+}
+
 template <typename word>
 void EvalSpecialFFT<word>::PopulatePlainMatrices(
     ConstContextPtr<word> context) {
@@ -178,6 +308,7 @@ void EvalSpecialFFT<word>::PreparePlaintexts(ConstContextPtr<word> context) {
   AssertTrue(num_cts_phases >= 2, "Use at least 2 levels for CtS");
   AssertTrue(num_stc_phases >= 2, "Use at least 2 levels for StC");
 
+  auto cts_stages = SplitStages(log_num_slots, num_cts_phases, true);
   int cts_stages_left = log_num_slots;
   int cts_stages_cumul = 0;
   double cts_const_div = std::pow(cts_const_, 1.0 / num_cts_phases);
@@ -195,12 +326,7 @@ void EvalSpecialFFT<word>::PreparePlaintexts(ConstContextPtr<word> context) {
   for (int i = 0; i < num_cts_phases; i++) {
     std::cout << "CtS preparation phase " << i << std::endl;
     // CtS: high strides (num_slots / 2) --> low strides (1)
-    int num_stages;
-    if (i == 0) {
-      num_stages = DivCeil(cts_stages_left, num_cts_phases);
-    } else {
-      num_stages = cts_stages_left / (num_cts_phases - i);
-    }
+    int num_stages = cts_stages[i];
     cts_stages_left -= num_stages;
 
     StripedMatrix phase_matrix = plain_ifft_stages_[cts_stages_cumul];
@@ -253,13 +379,12 @@ void EvalSpecialFFT<word>::PreparePlaintexts(ConstContextPtr<word> context) {
   }
 
   // 2. StC initialization
-  int stc_stages_left = log_num_slots;
+  auto stc_stages = SplitStages(log_num_slots, num_stc_phases, false);
   int stc_stages_cumul = 0;
   for (int i = 0; i < num_stc_phases; i++) {
     std::cout << "StC preparation phase " << i << std::endl;
     // StC: low strides (1) --> high strides (num_slots / 2)
-    int num_stages = stc_stages_left / (num_stc_phases - i);
-    stc_stages_left -= num_stages;
+    int num_stages = stc_stages[i];
 
     StripedMatrix phase_matrix = plain_fft_stages_[stc_stages_cumul];
     for (int j = stc_stages_cumul + 1; j < stc_stages_cumul + num_stages; j++) {
@@ -325,15 +450,25 @@ void EvalSpecialFFT<word>::AddRequiredRotations(EvkRequest &req,
   }
 }
 
+template <typename word>
+void EvalSpecialFFT<word>::Export(ConstContextPtr<word> context,
+                                  std::ostream &os) const {
+  WriteValue<int32_t>(os, cts_phases_.size());
+  for (const auto &cts_phase : cts_phases_) cts_phase.Export(context, os);
+  WriteValue<int32_t>(os, stc_phases_.size());
+  for (const auto &stc_phase : stc_phases_) stc_phase.Export(context, os);
+}
+
 template <typename word>
 void EvalSpecialFFT<word>::EvaluateCtS(ConstContextPtr<word> context, Ct &res,
                                        const Ct &input,
                                        const EvkMap<word> &evk_map,
-                                       bool min_ks) const {
+                                       bool min_ks,
+                                       BootWorkspace<word> *workspace) const {
   int num_cts_phases = cts_phases_.size();
-  cts_phases_.at(0).Evaluate(context, res, input, evk_map, min_ks);
+  cts_phases_.at(0).Evaluate(context, res, input, evk_map, min_ks, workspace);
   for (int i = 1; i < num_cts_phases; i++) {
-    cts_phases_.at(i).Evaluate(context, res, res, evk_map, min_ks);
+    cts_phases_.at(i).Evaluate(context, res, res, evk_map, min_ks, workspace);
   }
   if (!full_slot_) {
     res.SetNumSlots(num_slots_ * 2);
@@ -344,23 +479,36 @@ template <typename word>
 void EvalSpecialFFT<word>::EvaluateStC(ConstContextPtr<word> context, Ct &res,
                                        const Ct &input,
                                        const EvkMap<word> &evk_map,
-                                       bool min_ks) const {
+                                       bool min_ks,
+                                       BootWorkspace<word> *workspace) const {
   int num_stc_phases = stc_phases_.size();
-  stc_phases_.at(0).Evaluate(context, res, input, evk_map, min_ks);
+  stc_phases_.at(0).Evaluate(context, res, input, evk_map, min_ks, workspace);
   for (int i = 1; i < num_stc_phases; i++) {
-    stc_phases_.at(i).Evaluate(context, res, res, evk_map, min_ks);
+    stc_phases_.at(i).Evaluate(context, res, res, evk_map, min_ks, workspace);
   }
 
   Ct tmp;
   if (!full_slot_) {
     res.SetNumSlots(num_slots_ * 2);
     // res += HRot(res, num_slots_)
-    context->HRotAdd(res, res, res, evk_map.GetRotationKey(num_slots_),
+    context->HRotAdd(res, res, res, *evk_map.GetRotationKey(num_slots_),
                      num_slots_);
   }
   res.SetNumSlots(num_slots_);
 }
 
+template <typename word>
+int EvalSpecialFFT<word>::GetNumWorkspaceCts() const {
+  int res = 0;
+  for (const auto &phase : cts_phases_) {
+    res = Max(res, phase.GetNumWorkspaceCts());
+  }
+  for (const auto &phase : stc_phases_) {
+    res = Max(res, phase.GetNumWorkspaceCts());
+  }
+  return res;
+}
+
 template class EvalSpecialFFT<uint32_t>;
 template class EvalSpecialFFT<uint64_t>;
 
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <vector>
+
+#ifdef USE_CPU_BACKEND
+#include "common/BasicSimd.h"
+#else
 #include "common/Basic.cuh"
+#endif
 #include "common/CommonUtils.h"
 #include "common/ConstantMemory.cuh"
 #include "extension/Hoist.h"
@@ -17,6 +24,93 @@ constexpr void constexpr_for(Func &&func) {
 namespace cheddar {
 namespace kernel {
 
+#ifdef USE_CPU_BACKEND
+// Host versions of the fused kernels below, walking the primes limb by limb.
+// Each limb is accumulated with the array operations of basic::simd, so
+// inv_primes is unused; basic::Modulus carries its own constants.
+
+// Fused kernel for KeyMult, MAC, and Aut in the baby step.
+template <typename word>
+void BSFusedKernel(word **dst_bx, word **dst_ax, const word **mod_up,
+                   const word **key_bx, const word **key_ax, int num_accum,
+                   int num_rotations, const word *primes,
+                   const make_signed_t<word> *inv_primes, int num_q_primes,
+                   int num_primes, word *key_extra,
+                   const word *input_bx_pseudo_modup, word *galois_factors) {
+  int log_degree = cm_log_degree();
+  int degree = 1 << log_degree;
+  // Destination of every coefficient, shared by all limbs
+  std::vector<uint32_t> dst_indices(static_cast<size_t>(num_rotations) *
+                                    degree);
+  for (int k = 0; k < num_rotations; k++) {
+    uint32_t galois_factor = galois_factors[k];
+    for (int x = 0; x < degree; x++) {
+      uint32_t dst_index = basic::BitReverse(x, log_degree + 1) + 1;
+      dst_index = dst_index * galois_factor - 1;
+      dst_indices[k * degree + x] =
+          basic::BitReverse(dst_index, log_degree + 1);
+    }
+  }
+
+  std::vector<word> res_bx(degree);
+  std::vector<word> res_ax(degree);
+  for (int prime_index = 0; prime_index < num_primes; prime_index++) {
+    basic::Modulus<word> mod(primes[prime_index]);
+    bool aux_part = (prime_index >= num_q_primes);
+    int offset = prime_index << log_degree;
+    for (int k = 0; k < num_rotations; k++) {
+      int key_offset = offset + (aux_part ? key_extra[k] : 0);
+      std::fill(res_bx.begin(), res_bx.end(), 0);
+      std::fill(res_ax.begin(), res_ax.end(), 0);
+      for (int j = 0; j < num_accum; j++) {
+        const word *mod_up_limb = mod_up[j] + offset;
+        basic::simd::MultMontgomeryAccum(
+            res_bx.data(), mod_up_limb, key_bx[j + k * num_accum] + key_offset,
+            degree, mod);
+        basic::simd::MultMontgomeryAccum(
+            res_ax.data(), mod_up_limb, key_ax[j + k * num_accum] + key_offset,
+            degree, mod);
+      }
+      if (!aux_part) {
+        basic::simd::Add(res_bx.data(), res_bx.data(),
+                         input_bx_pseudo_modup + offset, degree, mod);
+      }
+      const uint32_t *dst_index = dst_indices.data() + k * degree;
+      for (int x = 0; x < degree; x++) {
+        dst_bx[k][dst_index[x] + offset] = res_bx[x];
+        dst_ax[k][dst_index[x] + offset] = res_ax[x];
+      }
+    }
+  }
+}
+
+// Fused kernel for plaintext multiplication and accumulation in the giant step.
+template <typename word>
+void GSFusedKernel(word **dst_bx, word **dst_ax, const word **bx,
+                   const word **ax, const word **mx, int num_bs, int num_gs,
+                   const word *primes, const make_signed_t<word> *inv_primes,
+                   int num_primes) {
+  int degree = cm_degree();
+  for (int prime_index = 0; prime_index < num_primes; prime_index++) {
+    basic::Modulus<word> mod(primes[prime_index]);
+    int offset = prime_index * degree;
+    for (int k = 0; k < num_gs; k++) {
+      word *res_bx = dst_bx[k] + offset;
+      word *res_ax = dst_ax[k] + offset;
+      std::fill_n(res_bx, degree, 0);
+      std::fill_n(res_ax, degree, 0);
+      for (int j = 0; j < num_bs; j++) {
+        const word *mx_limb = mx[j + k * num_bs];
+        if (mx_limb == nullptr) continue;
+        basic::simd::MultMontgomeryAccum(res_bx, bx[j] + offset,
+                                         mx_limb + offset, degree, mod);
+        basic::simd::MultMontgomeryAccum(res_ax, ax[j] + offset,
+                                         mx_limb + offset, degree, mod);
+      }
+    }
+  }
+}
+#else
 // Fused kernel for KeyMult, MAC, and Aut in the baby step.
 template <typename word, int num_accum_padded>
 __global__ void BSFusedKernel(
@@ -116,6 +210,7 @@ __global__ void GSFusedKernel(word **dst_bx, word **dst_ax, const word **bx,
     dst_ax[k][i] = res_ax;
   }
 }
+#endif
 }  // namespace kernel
 
 template <typename word>
@@ -176,6 +271,58 @@ HoistHandler<word>::HoistHandler(ConstContextPtr<word> context,
   }
 }
 
+template <typename word>
+HoistHandler<word>::HoistHandler(ConstContextPtr<word> context,
+                                 SerialReader &reader)
+    : pt_level_(reader.Read<int32_t>()), pt_scale_(reader.Read<double>()) {
+  Serializer<word> serializer(context->param_);
+  int num_bs = reader.Read<int32_t>();
+  for (int i = 0; i < num_bs; i++) {
+    bs_indices_.insert(reader.Read<int32_t>());
+  }
+  int num_gs = reader.Read<int32_t>();
+  for (int i = 0; i < num_gs; i++) {
+    int gs_idx = reader.Read<int32_t>();
+    gs_indices_.push_back(gs_idx);
+    auto &pt_map = hoist_pt_map_[gs_idx];
+    int num_pt = reader.Read<int32_t>();
+    for (int j = 0; j < num_pt; j++) {
+      int bs_idx = reader.Read<int32_t>();
+      Pt &pt = pt_map[bs_idx];
+      reader.Skip(
+          serializer.Deserialize(pt, reader.Current(), reader.Remaining()));
+    }
+  }
+  AssertTrue(num_gs > 0 && std::is_sorted(gs_indices_.begin(),
+                                          gs_indices_.end()),
+             "Hoist: Invalid serialized state");
+  if (!cm_populated_) {
+    PopulateConstantMemory(context->param_);
+    cm_populated_ = true;
+  }
+}
+
+template <typename word>
+void HoistHandler<word>::Export(ConstContextPtr<word> context,
+                                std::ostream &os) const {
+  // The plaintexts are the bulk of the state
+  Serializer<word> serializer(context->param_, true);
+  WriteValue<int32_t>(os, pt_level_);
+  WriteValue<double>(os, pt_scale_);
+  WriteValue<int32_t>(os, bs_indices_.size());
+  for (int bs_idx : bs_indices_) WriteValue<int32_t>(os, bs_idx);
+  WriteValue<int32_t>(os, gs_indices_.size());
+  for (int gs_idx : gs_indices_) {
+    const auto &pt_map = hoist_pt_map_.at(gs_idx);
+    WriteValue<int32_t>(os, gs_idx);
+    WriteValue<int32_t>(os, pt_map.size());
+    for (const auto &[bs_idx, pt] : pt_map) {
+      WriteValue<int32_t>(os, bs_idx);
+      serializer.Serialize(os, pt);
+    }
+  }
+}
+
 template <typename word>
 std::pair<int, int> HoistHandler<word>::CheckStrideMinKS() const {
   int non_zero_bs = 0;
@@ -213,7 +360,12 @@ void HoistHandler<word>::BSFusedKeyMult(
   int level = context->param_.NPToLevel(a_orig_np);
   int num_main = a_orig_np.num_main_;
   int num_ter = a_orig_np.num_ter_;
-  int num_aux = keys.GetRotationKey(rotations[0]).GetNP().num_aux_;
+  // The keys are pinned until the fused kernel has used them.
+  std::vector<typename EvkMap<word>::EvkPtr> rot_keys;
+  for (int rot_idx : rotations) {
+    rot_keys.push_back(keys.GetRotationKey(rot_idx));
+  }
+  int num_aux = rot_keys[0]->GetNP().num_aux_;
   int num_q = num_main + num_ter;
   int prime_offset = context->param_.GetMaxNumTer() - num_ter;
 
@@ -261,13 +413,13 @@ void HoistHandler<word>::BSFusedKeyMult(
     // keys
     for (int j = 0; j < num_accum; j++) {
       key_b_ptrs[i * num_accum + j] =
-          keys.GetRotationKey(rotations[i]).bx_[j + num_accum_offset].data() +
+          rot_keys[i]->bx_[j + num_accum_offset].data() +
           prime_offset * context->param_.degree_;
       key_a_ptrs[i * num_accum + j] =
-          keys.GetRotationKey(rotations[i]).ax_[j + num_accum_offset].data() +
+          rot_keys[i]->ax_[j + num_accum_offset].data() +
           prime_offset * context->param_.degree_;
     }
-    const Evk &key = keys.GetRotationKey(rotations[i]);
+    const Evk &key = *rot_keys[i];
     DvConstView<word> key_view = key.AxConstView(0, prime_offset);
     key_extra[i] = key_view.QSize() - num_q_primes * context->param_.degree_;
 
@@ -298,22 +450,30 @@ void HoistHandler<word>::BSFusedKeyMult(
   DeviceVector<word *> dst_a_d_ptrs(num_rotations);
   DeviceVector<word> key_extra_d(num_rotations);
   DeviceVector<word> galois_factors(num_rotations);
-  CopyHostToDevice(modup_d_ptrs, modup_ptrs);
-  CopyHostToDevice(key_a_d_ptrs, key_a_ptrs);
-  CopyHostToDevice(key_b_d_ptrs, key_b_ptrs);
-  CopyHostToDevice(dst_b_d_ptrs, dst_b_ptrs);
-  CopyHostToDevice(dst_a_d_ptrs, dst_a_ptrs);
-  CopyHostToDevice(key_extra_d, key_extra);
-  CopyHostToDevice(galois_factors, galois_factors_h);
+  CopyHostToDeviceAsync(modup_d_ptrs, modup_ptrs);
+  CopyHostToDeviceAsync(key_a_d_ptrs, key_a_ptrs);
+  CopyHostToDeviceAsync(key_b_d_ptrs, key_b_ptrs);
+  CopyHostToDeviceAsync(dst_b_d_ptrs, dst_b_ptrs);
+  CopyHostToDeviceAsync(dst_a_d_ptrs, dst_a_ptrs);
+  CopyHostToDeviceAsync(key_extra_d, key_extra);
+  CopyHostToDeviceAsync(galois_factors, galois_factors_h);
 
   const word *primes = context->param_.GetPrimesPtr(np);
   const make_signed_t<word> *inv_primes = context->param_.GetInvPrimesPtr(np);
-  dim3 block_dim(kernel_block_dim_);
-  dim3 grid_dim(num_primes * context->param_.degree_ / kernel_block_dim_);
 
   AssertTrue(num_accum <= (1 << max_log_beta_),
              "num_accum should not be greater than " +
                  std::to_string(1 << max_log_beta_));
+#ifdef USE_CPU_BACKEND
+  kernel::BSFusedKernel<word>(
+      dst_b_d_ptrs.data(), dst_a_d_ptrs.data(), modup_d_ptrs.data(),
+      key_b_d_ptrs.data(), key_a_d_ptrs.data(), num_accum, num_rotations,
+      primes, inv_primes, num_q_primes, num_primes, key_extra_d.data(),
+      input_bx_pseudo_modup.data(), galois_factors.data());
+#else
+  dim3 block_dim(kernel_block_dim_);
+  dim3 grid_dim(num_primes * context->param_.degree_ / kernel_block_dim_);
+
   constexpr_for<1, max_log_beta_ + 1>([&](auto i) {
     constexpr int num_accum_padded = 1 << i;
     if (num_accum > num_accum_padded) return;
@@ -324,6 +484,7 @@ void HoistHandler<word>::BSFusedKeyMult(
         primes, inv_primes, num_q_primes, key_extra_d.data(),
         input_bx_pseudo_modup.data(), galois_factors.data());
   });
+#endif
 }
 
 template <typename word>
@@ -331,7 +492,7 @@ void HoistHandler<word>::GSFusedPAccum(ConstContextPtr<word> context,
                                        std::map<int, Ct> &results,
                                        const std::vector<int> &gs_indices,
                                        const std::map<int, Ct> &bs) const {
-  constexpr int kernel_block_dim_ = 256;
+  [[maybe_unused]] constexpr int kernel_block_dim_ = 256;
 
   // Check if all bs and pt have the same scale and number of primes
   const Ct &first_ct = bs.begin()->second;
@@ -415,14 +576,20 @@ void HoistHandler<word>::GSFusedPAccum(ConstContextPtr<word> context,
   DeviceVector<const word *> mx_d_ptrs(num_gs * num_bs);
   DeviceVector<word *> dst_b_d_ptrs(num_gs);
   DeviceVector<word *> dst_a_d_ptrs(num_gs);
-  CopyHostToDevice(bx_d_ptrs, bx_ptrs);
-  CopyHostToDevice(ax_d_ptrs, ax_ptrs);
-  CopyHostToDevice(mx_d_ptrs, mx_ptrs);
-  CopyHostToDevice(dst_b_d_ptrs, dst_b_ptrs);
-  CopyHostToDevice(dst_a_d_ptrs, dst_a_ptrs);
+  CopyHostToDeviceAsync(bx_d_ptrs, bx_ptrs);
+  CopyHostToDeviceAsync(ax_d_ptrs, ax_ptrs);
+  CopyHostToDeviceAsync(mx_d_ptrs, mx_ptrs);
+  CopyHostToDeviceAsync(dst_b_d_ptrs, dst_b_ptrs);
+  CopyHostToDeviceAsync(dst_a_d_ptrs, dst_a_ptrs);
 
   const word *primes = context->param_.GetPrimesPtr(np);
   const make_signed_t<word> *inv_primes = context->param_.GetInvPrimesPtr(np);
+#ifdef USE_CPU_BACKEND
+  kernel::GSFusedKernel<word>(dst_b_d_ptrs.data(), dst_a_d_ptrs.data(),
+                              bx_d_ptrs.data(), ax_d_ptrs.data(),
+                              mx_d_ptrs.data(), num_bs, num_gs, primes,
+                              inv_primes, num_primes);
+#else
   dim3 block_dim(kernel_block_dim_);
   dim3 grid_dim(num_primes * context->param_.degree_ / kernel_block_dim_);
 
@@ -434,6 +601,7 @@ void HoistHandler<word>::GSFusedPAccum(ConstContextPtr<word> context,
         dst_b_d_ptrs.data(), dst_a_d_ptrs.data(), bx_d_ptrs.data(),
         ax_d_ptrs.data(), mx_d_ptrs.data(), num_bs, num_gs, primes, inv_primes);
   });
+#endif
 }
 
 template <typename word>
@@ -517,12 +685,12 @@ void HoistHandler<word>::EvaluateFinalModDown(ConstContextPtr<word> context,
 template <typename word>
 void HoistHandler<word>::EvaluateMinKSBabyStep(
     ConstContextPtr<word> context, std::map<int, Ct> &bs, const Ct &input,
-    const EvkMap<word> &evk_map) const {
+    const EvkMap<word> &evk_map, BootWorkspace<word> *workspace) const {
   auto [bs_stride, _] = CheckStrideMinKS();
   AssertTrue(bs.empty(), "Hoist: bs should be empty");
-  Ct tmp;
+  typename BootWorkspace<word>::Scope scope(workspace);
   for (const auto &bs_idx : bs_indices_) {
-    bs.try_emplace(bs_idx, NPInfo(0, 0, 0));
+    bs.try_emplace(bs_idx, scope.MakeCt(NPInfo(0, 0, 0)));
     if (bs_idx == 0) {
       context->Copy(bs[0], input);
     } else {
@@ -530,7 +698,7 @@ void HoistHandler<word>::EvaluateMinKSBabyStep(
       AssertTrue(bs.find(prev_bs_idx) != bs.end(),
                  "Hoist: MinKS baby-step sequence is not complete");
       context->HRot(bs[bs_idx], bs[prev_bs_idx],
-                    evk_map.GetRotationKey(bs_stride), bs_stride);
+                    *evk_map.GetRotationKey(bs_stride), bs_stride);
     }
   }
 }
@@ -538,12 +706,13 @@ void HoistHandler<word>::EvaluateMinKSBabyStep(
 template <typename word>
 void HoistHandler<word>::EvaluateMinKSGiantStep(
     ConstContextPtr<word> context, Ct &res, const std::map<int, Ct> &bs,
-    const EvkMap<word> &evk_map) const {
+    const EvkMap<word> &evk_map, BootWorkspace<word> *workspace) const {
   // Reversed traversal
   AssertFalse(bs.empty(), "Hoist: bs should not be empty");
 
   auto [_, gs_stride] = CheckStrideMinKS();
-  Ct accum;
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Ct &accum = scope.TakeCt();
   int prev_gs_idx = 0;
   bool first = true;
   for (auto it = hoist_pt_map_.rbegin(); it != hoist_pt_map_.rend(); it++) {
@@ -555,7 +724,8 @@ void HoistHandler<word>::EvaluateMinKSGiantStep(
                  "Hoist: MinKS giant-step sequence is not complete");
     }
     if (gs_idx != 0) {
-      context->HRot(accum, accum, evk_map.GetRotationKey(gs_stride), gs_stride);
+      context->HRot(accum, accum, *evk_map.GetRotationKey(gs_stride),
+                    gs_stride);
     } else {
       AssertTrue(first || prev_gs_idx == gs_stride,
                  "Hoist: MinKS giant-step sequence is not complete");
@@ -569,18 +739,19 @@ void HoistHandler<word>::EvaluateMinKSGiantStep(
 template <typename word>
 void HoistHandler<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
                                   const Ct &input, const EvkMap<word> &evk_map,
-                                  bool min_ks) const {
-  std::map<int, Ct> bs;
-  EvaluateBabyStep(context, bs, input, evk_map, min_ks);
-  EvaluateGiantStep(context, res, bs, evk_map, min_ks);
+                                  bool min_ks,
+                                  BootWorkspace<word> *workspace) const {
+  typename BootWorkspace<word>::Scope scope(workspace);
+  std::map<int, Ct> &bs = scope.TakeCtMap();
+  EvaluateBabyStep(context, bs, input, evk_map, min_ks, workspace);
+  EvaluateGiantStep(context, res, bs, evk_map, min_ks, workspace);
 }
 
 template <typename word>
-void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
-                                          std::map<int, Ct> &bs,
-                                          const Ct &input,
-                                          const EvkMap<word> &evk_map,
-                                          bool min_ks) const {
+void HoistHandler<word>::EvaluateBabyStep(
+    ConstContextPtr<word> context, std::map<int, Ct> &bs, const Ct &input,
+    const EvkMap<word> &evk_map, bool min_ks,
+    BootWorkspace<word> *workspace) const {
   NPInfo input_np = input.GetNP();
   int num_main_primes = input_np.num_main_;
   int num_ter_primes = input_np.num_ter_;
@@ -594,14 +765,15 @@ void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
   AssertTrue(input.GetNP().num_aux_ == 0, "Hoist: input should be mod-down");
   AssertFalse(input.HasRx(), "Hoist: input should be relinearized");
 
+  typename BootWorkspace<word>::Scope scope(workspace);
   if (bs_indices_.size() == 1 && *bs_indices_.begin() == 0) {
-    bs.try_emplace(0, NPInfo(num_main_primes, num_ter_primes, 0));
+    bs.try_emplace(0, scope.MakeCt(NPInfo(num_main_primes, num_ter_primes, 0)));
     context->Copy(bs[0], input);
     return;
   }
 
   if (min_ks) {
-    EvaluateMinKSBabyStep(context, bs, input, evk_map);
+    EvaluateMinKSBabyStep(context, bs, input, evk_map, workspace);
     return;
   }
 
@@ -611,10 +783,10 @@ void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
   AssertTrue(bs.empty(), "Hoist: bs should be empty");
 
   // 1. ModUp
-  std::vector<Dv> tmp_modup;
+  std::vector<Dv> &tmp_modup =
+      scope.TakeDvs(beta, (num_q_primes + num_p_primes) * degree);
   std::vector<DvView<word>> tmp_modup_view;
   for (int i = 0; i < beta; i++) {
-    tmp_modup.emplace_back((num_q_primes + num_p_primes) * degree);
     tmp_modup_view.push_back(tmp_modup[i].View(num_p_primes * degree));
   }
   mod_switcher.ModUp(tmp_modup_view, input.AxConstView());
@@ -624,20 +796,19 @@ void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
 
   DvConstView<word> p_prod_view(context->p_prod_.data() + prime_offset,
                                 num_q_primes);
-  Dv pseudo_modup_tmp;
 
   NPInfo modup_np(num_main_primes, num_ter_primes, num_p_primes);
 
   // Special handling for bs_idx = 0 case
   if (bs_indices_.find(0) == bs_indices_.end()) {
-    pseudo_modup_tmp.resize(num_q_primes * degree);
+    Dv &pseudo_modup_tmp = scope.TakeDv(num_q_primes * degree);
     DvView<word> pseudo_modup_tmp_view = pseudo_modup_tmp.View();
     mod_switcher.PseudoModUp(pseudo_modup_tmp_view, input.BxConstView(),
                              p_prod_view);
     pseudo_modup_tmp.ZeroExtend(num_p_primes * degree);
     input_bx_pseudo_modup = &pseudo_modup_tmp;
   } else {
-    bs.try_emplace(0, input_np);
+    bs.try_emplace(0, scope.MakeCt(input_np));
     bs[0].SetScale(input.GetScale());
     bs[0].SetNumSlots(input.GetNumSlots());
     DvView<word> bs_0_bx_view = bs[0].BxView();
@@ -658,19 +829,20 @@ void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
     std::vector<int> rotations;
     for (const auto &bs_idx : bs_indices_) {
       if (bs_idx != 0) {
-        bs.try_emplace(bs_idx, modup_np);
+        bs.try_emplace(bs_idx, scope.MakeCt(modup_np));
         rotations.push_back(bs_idx);
       }
     }
     BSFusedKeyMult(context, bs, tmp_modup, input, evk_map, rotations,
                    *input_bx_pseudo_modup);
   } else {
-    Ct tmp(modup_np);
+    Ct &tmp = scope.TakeCt(modup_np);
 
     for (const auto &bs_idx : bs_indices_) {
       if (bs_idx != 0) {
-        const auto &key = evk_map.GetRotationKey(bs_idx);
-        bs.try_emplace(bs_idx, modup_np);
+        auto key_ptr = evk_map.GetRotationKey(bs_idx);
+        const auto &key = *key_ptr;
+        bs.try_emplace(bs_idx, scope.MakeCt(modup_np));
 
         // KeyMult
         context->MultKeyNoModDown(tmp, tmp_modup, input, key);
@@ -693,10 +865,10 @@ void HoistHandler<word>::EvaluateBabyStep(ConstContextPtr<word> context,
 // 3. Giant-step accumulation and rotations
 
 template <typename word>
-void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
-                                           Ct &res, const std::map<int, Ct> &bs,
-                                           const EvkMap<word> &evk_map,
-                                           bool min_ks) const {
+void HoistHandler<word>::EvaluateGiantStep(
+    ConstContextPtr<word> context, Ct &res, const std::map<int, Ct> &bs,
+    const EvkMap<word> &evk_map, bool min_ks,
+    BootWorkspace<word> *workspace) const {
   AssertFalse(bs.empty(), "Hoist: bs should not be empty");
   const Ct &ref_ct = bs.begin()->second;
   NPInfo ref_np = ref_ct.GetNP();
@@ -711,26 +883,26 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
   double input_scale = ref_ct.GetScale();
   int degree = context->param_.degree_;
   auto &mod_switcher = context->mod_switch_handlers_.at(pt_level_);
+  typename BootWorkspace<word>::Scope scope(workspace);
 
   // when only gs indices exits
   if (bs_indices_.size() == 1 && *bs_indices_.begin() == 0) {
     AssertFalse(min_ks, "Hoist: min_ks should be false for bs == 1 case");
     const Ct &ct = bs.begin()->second;
-    std::vector<Dv> ax_modup;
+    std::vector<Dv> &ax_modup =
+        scope.TakeDvs(beta, (num_q_primes + num_aux_primes) * degree);
     std::vector<DvView<word>> ax_modup_view;
     for (int i = 0; i < beta; i++) {
-      ax_modup.emplace_back((num_q_primes + num_aux_primes) * degree);
       ax_modup_view.push_back(ax_modup[i].View(num_aux_primes * degree));
     }
     mod_switcher.ModUp(ax_modup_view, ct.AxConstView());
-    std::map<int, Ct> pt_mult;
+    std::map<int, Ct> &pt_mult = scope.TakeCtMap();
 
     Dv *bx_pseudo = nullptr;
-    Dv bx_pseudo_tmp;
     DvConstView<word> p_prod_view(context->p_prod_.data() + prime_offset,
                                   num_q_primes);
     if (hoist_pt_map_.find(0) == hoist_pt_map_.end()) {
-      bx_pseudo_tmp.resize(num_q_primes * degree);
+      Dv &bx_pseudo_tmp = scope.TakeDv(num_q_primes * degree);
       DvConstView<word> ct_bx_view(ct.bx_.data(), num_q_primes * degree, 0);
       DvView<word> bx_pseudo_tmp_view = bx_pseudo_tmp.View();
       mod_switcher.PseudoModUp(bx_pseudo_tmp_view, ct_bx_view, p_prod_view);
@@ -740,14 +912,14 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
     std::vector<std::vector<DvConstView<word>>> ct_bx_ax_view;
     std::vector<int> rot_indices;
 
-    Ct final_accum;
+    Ct &final_accum = scope.TakeCt();
     bool inplace = false;
     for (const auto &[gs_idx, pt_map] : hoist_pt_map_) {
       const auto &pt = pt_map.begin()->second;
 
       if (gs_idx == 0) {
         AssertFalse(inplace, "Hoist: inplace should be false for gs_idx == 0");
-        pt_mult.try_emplace(0, q_prime_np);
+        pt_mult.try_emplace(0, scope.MakeCt(q_prime_np));
         DvConstView<word> ct_bx_view(ct.bx_.data(), num_q_primes * degree, 0);
         DvConstView<word> ct_ax_view(ct.ax_.data(), num_q_primes * degree, 0);
         DvView<word> final_accum_bx_view = pt_mult.at(0).BxView();
@@ -764,9 +936,10 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
         continue;
       }
 
-      const auto &key = evk_map.GetRotationKey(gs_idx);
+      auto key_ptr = evk_map.GetRotationKey(gs_idx);
+      const auto &key = *key_ptr;
 
-      pt_mult.try_emplace(gs_idx, q_p_prime_np);
+      pt_mult.try_emplace(gs_idx, scope.MakeCt(q_p_prime_np));
 
       context->MultKeyNoModDown(pt_mult.at(gs_idx), ax_modup, ct, key);
       DvView<word> pt_mult_bx_view(pt_mult.at(gs_idx).bx_.data(),
@@ -803,16 +976,17 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
   }
 
   if (min_ks) {
-    EvaluateMinKSGiantStep(context, res, bs, evk_map);
+    EvaluateMinKSGiantStep(context, res, bs, evk_map, workspace);
     return;
   }
 
   if (kOptimizeAutomorphism) {
-    EvaluateGiantStepOptimized(context, res, bs, evk_map);
+    EvaluateGiantStepOptimized(context, res, bs, evk_map, workspace);
     return;
   }
 
-  Ct tmp, accum;
+  Ct &tmp = scope.TakeCt();
+  Ct &accum = scope.TakeCt();
   // 3-1. simplified sequence for non-BSGS accumulation.
   if (gs_indices_.size() == 1 && gs_indices_.at(0) == 0) {
     EvaluateSingleAccum(context, accum, bs, hoist_pt_map_.begin()->second);
@@ -821,15 +995,15 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
   }
 
   // 3-2. regular BSGS accumulation sequence
-  Ct final_accum;
+  Ct &final_accum = scope.TakeCt();
   bool final_accum_init = false;
-  std::vector<Dv> tmp_modup;
+  std::vector<Dv> &tmp_modup =
+      scope.TakeDvs(beta, (num_q_primes + num_aux_primes) * degree);
   std::vector<DvView<word>> tmp_modup_view;
   for (int i = 0; i < beta; i++) {
-    tmp_modup.emplace_back((num_q_primes + num_aux_primes) * degree);
     tmp_modup_view.push_back(tmp_modup[i].View(num_aux_primes * degree));
   }
-  Dv tmp_moddown(num_q_primes * degree);
+  Dv &tmp_moddown = scope.TakeDv(num_q_primes * degree);
   for (const auto &[gs_idx, pt_map] : hoist_pt_map_) {
     if (gs_idx == 0 && final_accum_init == false) {
       EvaluateSingleAccum(context, final_accum, bs, pt_map);
@@ -845,7 +1019,8 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
       DvView<word> tmp_moddown_view = tmp_moddown.View(0);
       mod_switcher.ModDown(tmp_moddown_view, accum.AxConstView());
       mod_switcher.ModUp(tmp_modup_view, tmp_moddown.ConstView());
-      const auto &key = evk_map.GetRotationKey(gs_idx);
+      auto key_ptr = evk_map.GetRotationKey(gs_idx);
+      const auto &key = *key_ptr;
       context->MultKeyNoModDown(tmp, tmp_modup, accum, key);
       std::vector<DvView<word>> tmp_bx_view = {tmp.BxView()};
 
@@ -870,7 +1045,7 @@ void HoistHandler<word>::EvaluateGiantStep(ConstContextPtr<word> context,
 template <typename word>
 void HoistHandler<word>::EvaluateGiantStepOptimized(
     ConstContextPtr<word> context, Ct &res, const std::map<int, Ct> &bs,
-    const EvkMap<word> &evk_map) const {
+    const EvkMap<word> &evk_map, BootWorkspace<word> *workspace) const {
   AssertFalse(bs.empty(), "Hoist: bs should not be empty");
   const Ct &ref_ct = bs.begin()->second;
 
@@ -884,7 +1059,8 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
   int degree = context->param_.degree_;
   auto &mod_switcher = context->mod_switch_handlers_.at(pt_level_);
 
-  Ct tmp;
+  typename BootWorkspace<word>::Scope scope(workspace);
+  Ct &tmp = scope.TakeCt();
 
   // 3-1. simplified sequence for non-BSGS accumulation.
   // But this should not occur in optimized cases
@@ -895,15 +1071,17 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
   }
 
   // 3-2. regular BSGS accumulation sequence
-  std::map<int, Ct> accum;
+  std::map<int, Ct> &accum = scope.TakeCtMap();
   bool gs_idx_0_exists = false;
   Ct *final_accum;
-  accum.try_emplace(0, ref_ct_np);
+  accum.try_emplace(0, scope.MakeCt(ref_ct_np));
   final_accum = &accum[0];
 
   if (hoist_pt_map_.begin() != hoist_pt_map_.end()) gs_idx_0_exists = true;
   for (const auto &[gs_idx, pt_map] : hoist_pt_map_) {
-    accum.try_emplace(gs_idx, ref_ct_np);
+    if (accum.find(gs_idx) == accum.end()) {
+      accum.try_emplace(gs_idx, scope.MakeCt(ref_ct_np));
+    }
   }
 
   // Plaintext multiplication for all baby-step results and accumulation.
@@ -918,13 +1096,13 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
   }
 
   // giant-step rotation and accumulation
-  std::vector<Dv> tmp_modup;
+  std::vector<Dv> &tmp_modup =
+      scope.TakeDvs(beta, (num_q_primes + num_p_primes) * degree);
   std::vector<DvView<word>> tmp_modup_view;
   for (int i = 0; i < beta; i++) {
-    tmp_modup.emplace_back((num_q_primes + num_p_primes) * degree);
     tmp_modup_view.push_back(tmp_modup[i].View(num_p_primes * degree));
   }
-  Dv tmp_moddown(num_q_primes * degree);
+  Dv &tmp_moddown = scope.TakeDv(num_q_primes * degree);
 
   bool first = true;
   for (const auto &[gs_idx, ct] : accum) {
@@ -938,7 +1116,8 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
     }
 
     mod_switcher.ModUp(tmp_modup_view, tmp_moddown_view);
-    const auto &key = evk_map.GetRotationKey(gs_idx);
+    auto key_ptr = evk_map.GetRotationKey(gs_idx);
+    const auto &key = *key_ptr;
 
     if (first & !gs_idx_0_exists) {
       context->MultKeyNoModDown(*final_accum, tmp_modup, ct, key);
@@ -960,9 +1139,6 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
     ct_bx_view.push_back({ct.BxConstView()});
     rot_indices.push_back(gs_idx);
   }
-  Dv tmp_add(ref_ct_np.GetNumTotal() * degree);
-  DvView<word> tmp_add_view = tmp_add.View(ref_ct_np.num_aux_ * degree);
-  std::vector<DvView<word>> tmp_add_view_vector = {tmp_add_view};
   std::vector<DvView<word>> accum_view_vector = {(*final_accum).BxView()};
 
   // inplace
@@ -974,6 +1150,17 @@ void HoistHandler<word>::EvaluateGiantStepOptimized(
                        input_scale);
 }
 
+template <typename word>
+int HoistHandler<word>::GetNumWorkspaceCts() const {
+  return GetNumWorkspaceCts(bs_indices_.size(), hoist_pt_map_.size());
+}
+
+template <typename word>
+int HoistHandler<word>::GetNumWorkspaceCts(int num_bs, int num_gs) {
+  // Baby steps, giant-step accumulators, and a few more temporaries
+  return num_bs + num_gs + 3;
+}
+
 template <typename word>
 void HoistHandler<word>::AddRequiredRotations(EvkRequest &req,
                                               bool min_ks) const {
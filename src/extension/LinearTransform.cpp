@@ -89,6 +89,18 @@ LinearTransform<word>::LinearTransform(ConstContextPtr<word> context,
       stride_{DetermineStride(matrix)},
       hoist_{context, ConstructPlainHoistMap(matrix), pt_level, pt_scale} {}
 
+template <typename word>
+LinearTransform<word>::LinearTransform(ConstContextPtr<word> context,
+                                       SerialReader &reader)
+    : pt_level_{reader.Read<int32_t>()},
+      pt_scale_{reader.Read<double>()},
+      bs_{reader.Read<int32_t>()},
+      gs_{reader.Read<int32_t>()},
+      pre_rotation_{reader.Read<int32_t>()},
+      additional_pt_rot_{reader.Read<int32_t>()},
+      stride_{reader.Read<int32_t>()},
+      hoist_{context, reader} {}
+
 template <typename word>
 bool LinearTransform<word>::IsUsingBSGS() const {
   return bs_ > 1 && gs_ > 1;
@@ -115,12 +127,32 @@ void LinearTransform<word>::AddRequiredRotations(
   return hoist_.AddRequiredRotations(req, min_ks);
 }
 
+template <typename word>
+void LinearTransform<word>::Export(ConstContextPtr<word> context,
+                                   std::ostream &os) const {
+  WriteValue<int32_t>(os, pt_level_);
+  WriteValue<double>(os, pt_scale_);
+  WriteValue<int32_t>(os, bs_);
+  WriteValue<int32_t>(os, gs_);
+  WriteValue<int32_t>(os, pre_rotation_);
+  WriteValue<int32_t>(os, additional_pt_rot_);
+  WriteValue<int32_t>(os, stride_);
+  hoist_.Export(context, os);
+}
+
 template <typename word>
 void LinearTransform<word>::Evaluate(ConstContextPtr<word> context, Ct &res,
                                      const Ct &input,
                                      const EvkMap<word> &evk_map,
-                                     bool min_ks /*= false*/) const {
-  hoist_.Evaluate(context, res, input, evk_map, min_ks);
+                                     bool min_ks /*= false*/,
+                                     BootWorkspace<word> *workspace
+                                     /*= nullptr*/) const {
+  hoist_.Evaluate(context, res, input, evk_map, min_ks, workspace);
+}
+
+template <typename word>
+int LinearTransform<word>::GetNumWorkspaceCts() const {
+  return hoist_.GetNumWorkspaceCts();
 }
 
 template class LinearTransform<uint32_t>;
@@ -1,8 +1,17 @@
 #undef ENABLE_EXTENSION
 
 #include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
 
 #include "Testbed.h"
+#include "common/ThreadPool.h"
+#include "core/ContextFactory.h"
+#include "core/EvkStore.h"
+#include "core/BigInt.h"
+#include "core/DoubleModReducer.h"
+#include "core/Serialize.h"
 
 static constexpr int warm_up = 5;
 using word = uint32_t;
@@ -24,6 +33,493 @@ TEST_P(Testbed32, EncodeDecode) {
   }
 }
 
+TEST_P(Testbed32, EncodeDecodeBatch) {
+  constexpr int batch_size = 4;
+  for (int level = 0; level <= param_->max_level_; level++) {
+    std::vector<std::vector<Complex>> msgs(batch_size);
+    for (auto &msg : msgs) GenerateRandomMessage(msg);
+
+    std::vector<Plaintext<word>> pts;
+    context_->encoder_.EncodeBatch(pts, level, DetermineScale(level), msgs);
+
+    std::vector<std::vector<Complex>> res;
+    context_->encoder_.DecodeBatch(res, pts);
+    for (int i = 0; i < batch_size; i++) {
+      CompareMessages(msgs[i], res[i], level == param_->max_level_ && i == 0);
+    }
+  }
+}
+
+TEST_P(Testbed32, EncodeMultiLevel) {
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+
+  MultiLevelPlaintext<word> mlp;
+  context_->encoder_.EncodeMultiLevel(mlp, 0, param_->max_level_,
+                                      DetermineScale(0), msg);
+  for (int level = 0; level <= param_->max_level_; level++) {
+    std::vector<Complex> res;
+    context_->encoder_.Decode(res, mlp.AtLevel(level));
+    CompareMessages(msg, res, level == param_->max_level_);
+  }
+}
+
+TEST_P(Testbed32, DoubleModReducer) {
+  // Reference: the truncated value reduced bit by bit, from the top
+  auto mod_word = [](double value, uint64_t mod) {
+    double abs_value = std::trunc(std::fabs(value));
+    unsigned __int128 res = 0;
+    int top_bit = (abs_value < 1) ? -1 : std::ilogb(abs_value);
+    for (int bit = top_bit; bit >= 0; bit--) {
+      res = (res * 2 + (std::fmod(std::ldexp(abs_value, -bit), 2) >= 1)) % mod;
+    }
+    uint64_t res_word = static_cast<uint64_t>(res);
+    return (value < 0 && res_word != 0) ? mod - res_word : res_word;
+  };
+
+  // Around the 2^64 boundary of the single-limb path, and values whose
+  // mantissa is all ones
+  std::vector<double> values = {0,
+                                0.5,
+                                2.5,
+                                0x1p63,
+                                std::nextafter(0x1p64, 0),
+                                0x1p64,
+                                std::nextafter(0x1p64, 0x1p65),
+                                0x1.fffffffffffffp+64,
+                                0x1.fffffffffffffp+127,
+                                0x1p1000 * 3.14159,
+                                std::numeric_limits<double>::max()};
+  auto primes = param_->GetPrimeVector(param_->LevelToNP(param_->max_level_));
+  std::vector<uint64_t> mods(primes.begin(), primes.end());
+  mods.push_back(0xffffffff00000001);
+  mods.push_back(3);
+  for (double value : values) {
+    for (double signed_value : {value, -value}) {
+      DoubleModReducer big_value(signed_value);
+      BigInt reference(signed_value);
+      for (uint64_t mod : mods) {
+        ASSERT_EQ(big_value.Reduce(mod), mod_word(signed_value, mod))
+            << "value: " << signed_value << ", mod: " << mod;
+        BigInt reference_res(static_cast<uint64_t>(0));
+        BigInt::Mod(reference_res, reference, BigInt(mod));
+        ASSERT_EQ(big_value.Reduce(mod), reference_res.GetUnsigned());
+      }
+    }
+  }
+}
+
+TEST_P(Testbed32, ConstantCache) {
+  const auto &cache = context_->constant_cache_;
+  auto const_stats = cache.GetConstantStats();
+  auto pt_stats = cache.GetPlaintextStats();
+  int level = param_->max_level_;
+  double scale = DetermineScale(level);
+
+  Constant<word> ref, first, second;
+  context_->encoder_.EncodeConstant(ref, level, scale, 0.125);
+  cache.EncodeConstant(first, level, scale, 0.125);
+  cache.EncodeConstant(second, level, scale, 0.125);
+  HostVector<word> h_ref, h_second;
+  CopyDeviceToHost(h_ref, ref.cx_);
+  CopyDeviceToHost(h_second, second.cx_);
+  ASSERT_TRUE(h_ref == h_second);
+  ASSERT_EQ(cache.GetConstantStats().misses, const_stats.misses + 1);
+  ASSERT_EQ(cache.GetConstantStats().hits, const_stats.hits + 1);
+
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+  auto pt1 = cache.Encode(level, scale, msg);
+  auto pt2 = cache.Encode(level, scale, msg);
+  ASSERT_EQ(pt1, pt2);
+  ASSERT_EQ(cache.GetPlaintextStats().misses, pt_stats.misses + 1);
+  ASSERT_EQ(cache.GetPlaintextStats().hits, pt_stats.hits + 1);
+
+  std::vector<Complex> res;
+  context_->encoder_.Decode(res, *pt2);
+  CompareMessages(msg, res);
+}
+
+TEST_P(Testbed32, Serialize) {
+  Serializer<word> serializer(*param_);
+  int level = param_->max_level_;
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+
+  Ciphertext<word> ct;
+  Plaintext<word> pt;
+  EncodeAndEncrypt(ct, msg, level);
+  Encode(pt, msg, level);
+  const auto &evk = interface_->GetMultiplicationKey();
+
+  std::stringstream stream;
+  serializer.Serialize(stream, ct);
+  serializer.Serialize(stream, pt);
+  serializer.Serialize(stream, evk);
+  std::string buffer = stream.str();
+  ASSERT_EQ(buffer.size(), serializer.GetSerializedSize(ct) +
+                               serializer.GetSerializedSize(pt) +
+                               serializer.GetSerializedSize(evk));
+
+  Ciphertext<word> ct_res;
+  Plaintext<word> pt_res;
+  EvaluationKey<word> evk_res;
+  size_t offset = 0;
+  offset += serializer.Deserialize(ct_res, buffer.data() + offset,
+                                   buffer.size() - offset);
+  offset += serializer.Deserialize(pt_res, buffer.data() + offset,
+                                   buffer.size() - offset);
+  offset += serializer.Deserialize(evk_res, buffer.data() + offset,
+                                   buffer.size() - offset);
+  ASSERT_EQ(offset, buffer.size());
+
+  std::vector<Complex> res;
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg, res);
+  Decode(res, pt_res);
+  CompareMessages(msg, res, false);
+
+  ExpectSameEvk(evk, evk_res);
+}
+
+TEST_P(Testbed32, SerializeCompressed) {
+  Serializer<word> serializer(*param_);
+  int level = param_->max_level_;
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+
+  Plaintext<word> pt;
+  Ciphertext<word> ct;
+  PolySeed seed;
+  Encode(pt, msg, level);
+  interface_->Encrypt(ct, pt, &seed);
+  UserInterface<word> seeded_interface(context_, true);
+  const auto &evk = seeded_interface.GetMultiplicationKey();
+  const auto &evk_seed =
+      seeded_interface.GetEvkSeed(EvkMap<word>::kMultiplicationKeyIndex);
+
+  std::stringstream stream;
+  serializer.SerializeCompressed(stream, ct, seed);
+  serializer.SerializeCompressed(stream, evk, evk_seed);
+  std::string buffer = stream.str();
+  ASSERT_EQ(buffer.size(), serializer.GetCompressedSize(ct) +
+                               serializer.GetCompressedSize(evk));
+  ASSERT_LT(2 * serializer.GetCompressedSize(evk),
+            serializer.GetSerializedSize(evk) + 4 * kSerialAlignment);
+
+  Ciphertext<word> ct_res;
+  EvaluationKey<word> evk_res;
+  size_t offset = serializer.Deserialize(ct_res, buffer.data(), buffer.size());
+  offset += serializer.Deserialize(evk_res, buffer.data() + offset,
+                                   buffer.size() - offset);
+  ASSERT_EQ(offset, buffer.size());
+
+  std::vector<Complex> res;
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg, res);
+  ExpectSameEvk(evk, evk_res);
+}
+
+TEST_P(Testbed32, SerializeBitPacked) {
+  Serializer<word> serializer(*param_);
+  Serializer<word> packer(*param_, true);
+  int level = param_->max_level_;
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+
+  Ciphertext<word> ct;
+  EncodeAndEncrypt(ct, msg, level);
+  const auto &evk = interface_->GetMultiplicationKey();
+
+  std::stringstream stream;
+  packer.Serialize(stream, ct);
+  packer.Serialize(stream, evk);
+  std::string buffer = stream.str();
+  ASSERT_EQ(buffer.size(),
+            packer.GetSerializedSize(ct) + packer.GetSerializedSize(evk));
+  ASSERT_LE(packer.GetSerializedSize(ct), serializer.GetSerializedSize(ct));
+  ASSERT_LE(packer.GetSerializedSize(evk), serializer.GetSerializedSize(evk));
+
+  // Packed data is readable by a non-packing serializer as well.
+  Ciphertext<word> ct_res;
+  EvaluationKey<word> evk_res;
+  size_t offset = serializer.Deserialize(ct_res, buffer.data(), buffer.size());
+  offset += serializer.Deserialize(evk_res, buffer.data() + offset,
+                                   buffer.size() - offset);
+  ASSERT_EQ(offset, buffer.size());
+
+  ExpectSameDv(ct.bx_, ct_res.bx_);
+  ExpectSameDv(ct.ax_, ct_res.ax_);
+  ExpectSameEvk(evk, evk_res);
+
+  std::vector<Complex> res;
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg, res);
+}
+
+TEST_P(Testbed32, TableCache) {
+  std::string path = testing::TempDir() + "cheddar_table_cache.bin";
+  std::remove(path.c_str());
+  uint64_t fingerprint = param_->GetFingerprint();
+  {
+    TableCache tables(path, fingerprint);
+    ASSERT_EQ(tables.GetNumTables(), 0);
+    auto context = Context<word>::Create(*param_, &tables);
+    ASSERT_TRUE(tables.IsModified());
+    tables.Save();
+  }
+  ASSERT_EQ(TableCache(path, fingerprint + 1).GetNumTables(), 0);
+
+  TableCache tables(path, fingerprint);
+  ASSERT_GT(tables.GetNumTables(), 0);
+  auto context = Context<word>::Create(*param_, &tables);
+  ASSERT_FALSE(tables.IsModified());
+
+  // The loaded tables should give the same results.
+  ExpectSameEncoding(*context);
+  std::remove(path.c_str());
+}
+
+TEST_P(Testbed32, ContextFactory) {
+  ContextFactory<word> factory(*param_);
+  auto context1 = factory.Create();
+  auto context2 = factory.Create();
+  ASSERT_EQ(factory.GetNumContexts(), 2);
+  ASSERT_EQ(&context1->ntt_handler_, &context2->ntt_handler_);
+  ASSERT_EQ(&context1->encoder_, &context2->encoder_);
+  ASSERT_NE(&context1->constant_cache_, &context2->constant_cache_);
+
+  // The shared tables should give the same results.
+  ExpectSameEncoding(*context2);
+
+  context1.reset();
+  ASSERT_EQ(factory.GetNumContexts(), 1);
+}
+
+TEST_P(Testbed32, ThreadPoolFailure) {
+  // An exception from a task is rethrown on the calling thread.
+  ThreadPool pool(4);
+  ASSERT_THROW(pool.ParallelFor(0, 1 << 10,
+                                [](int i) {
+                                  if (i == 100) throw std::runtime_error("");
+                                }),
+               std::runtime_error);
+  std::atomic<int> count{0};
+  pool.ParallelFor(0, 1 << 10, [&](int) { count++; });
+  ASSERT_EQ(count, 1 << 10);
+
+  // A failing assertion on a worker thread exits with its message. The pool
+  // is never destroyed, like the global one.
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  auto fail_on_worker = [] {
+    auto caller = std::this_thread::get_id();
+    (new ThreadPool(4))->ParallelFor(0, 1 << 10, [&](int) {
+      if (std::this_thread::get_id() == caller) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return;
+      }
+      AssertTrue(false, "ThreadPoolFailure");
+    });
+  };
+  ASSERT_EXIT(fail_on_worker(), testing::ExitedWithCode(EXIT_FAILURE),
+              "ThreadPoolFailure");
+}
+
+TEST_P(Testbed32, HostStagingPool) {
+  auto &pool = HostStagingPool::Global();
+  pool.Release();
+  ASSERT_EQ(pool.GetCachedBytes(), 0);
+  ASSERT_EQ(HostStagingPool::GetClassSize(1), HostStagingPool::kMinClassSize);
+  ASSERT_EQ(HostStagingPool::GetClassSize(1000), 1024);
+  ASSERT_EQ(HostStagingPool::GetClassSize(1025), 1280);
+
+  // A freed buffer is reused for a buffer of the same size class.
+  size_t size = (size_t{1} << log_degree_) * param_->max_level_;
+  const word *data = nullptr;
+  {
+    HostVector<word> h_vec(size);
+    data = h_vec.data();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % kHostAlignment, 0);
+  }
+  ASSERT_EQ(pool.GetCachedBytes(),
+            HostStagingPool::GetClassSize(size * sizeof(word)));
+  {
+    HostVector<word> h_vec(size - 1);
+    ASSERT_EQ(h_vec.data(), data);
+  }
+
+  // A buffer freed right after an asynchronous copy is reused once the copy
+  // is done.
+  DeviceVector<word> d_vec;
+  {
+    HostVector<word> h_vec(size);
+    for (size_t i = 0; i < size; i++) h_vec[i] = static_cast<word>(i);
+    CopyHostToDeviceAsync(d_vec, h_vec);
+  }
+  cudaDeviceSynchronize();
+  {
+    HostVector<word> h_vec(size);
+    ASSERT_EQ(h_vec.data(), data);
+    CopyDeviceToHost(h_vec, d_vec);
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_EQ(h_vec[i], static_cast<word>(i));
+    }
+  }
+
+  // Encoding with recycled buffers should give the same results.
+  ExpectSameEncoding(*context_);
+
+  pool.Release();
+  ASSERT_EQ(pool.GetCachedBytes(), 0);
+}
+
+TEST_P(Testbed32, MemoryStats) {
+  context_->ResetPeakMemoryStats();
+  MemoryPoolStats before = context_->GetMemoryStats();
+  ASSERT_FALSE(before.bins.empty());
+  ASSERT_GE(before.upstream_live_bytes, before.live_bytes);
+
+  size_t bytes = 0;
+  {
+    std::vector<Complex> msg;
+    GenerateRandomMessage(msg);
+    Ciphertext<word> ct;
+    EncodeAndEncrypt(ct, msg, default_encryption_level_);
+    bytes = (ct.bx_.size() + ct.ax_.size()) * sizeof(word);
+
+    MemoryPoolStats stats = context_->GetMemoryStats();
+    ASSERT_GE(stats.live_bytes, before.live_bytes + bytes);
+    ASSERT_GE(stats.live_binned_bytes, stats.live_bytes);
+    ASSERT_GE(stats.upstream_live_bytes, stats.live_bytes);
+    uint64_t num_allocations = stats.fall_through.num_allocations;
+    for (const auto &bin : stats.bins) {
+      num_allocations += bin.num_allocations;
+    }
+    ASSERT_GE(num_allocations, 2);
+  }
+
+  // The temporary allocations are freed, but the peak remains.
+  MemoryPoolStats after = context_->GetMemoryStats();
+  ASSERT_EQ(after.live_bytes, before.live_bytes);
+  ASSERT_GE(after.peak_live_bytes, before.live_bytes + bytes);
+  ASSERT_GE(after.GetFragmentation(), 0);
+  ASSERT_LE(after.GetFragmentation(), 1);
+
+  std::stringstream dump;
+  context_->DumpMemoryStats(dump);
+  ASSERT_NE(dump.str().find("upstream"), std::string::npos);
+  std::cout << dump.str();
+
+  // Destroying a newer Context gives the allocations back to context_.
+  { auto context = Context<word>::Create(*param_); }
+  size_t live_bytes = context_->GetMemoryStats().live_bytes;
+  {
+    DeviceVector<word> dv(1 << log_degree_);
+    ASSERT_EQ(context_->GetMemoryStats().live_bytes,
+              live_bytes + dv.size() * sizeof(word));
+  }
+}
+
+TEST_P(Testbed32, MemoryBinConfig) {
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+  int level = param_->default_encryption_level_;
+  double scale = param_->GetScale(level);
+  auto workload = [&](const Context<word> &context) {
+    Plaintext<word> pt1, pt2;
+    context.encoder_.Encode(pt1, level, scale, msg);
+    context.encoder_.Encode(pt2, level - 1, scale, msg);
+  };
+
+  MemoryTrace trace;
+  {
+    auto context = Context<word>::Create(*param_);
+    context->StartMemoryTrace();
+    workload(*context);
+    trace = context->StopMemoryTrace();
+  }
+  ASSERT_FALSE(trace.events.empty());
+  MemoryBinConfig config = MemoryBinConfig::FromTrace(trace);
+  ASSERT_FALSE(config.bins.empty());
+  ASSERT_LE(config.bins.size(), MemoryBinConfig::kDefaultMaxNumBins);
+  for (size_t i = 1; i < config.bins.size(); i++) {
+    ASSERT_LT(config.bins[i - 1].size, config.bins[i].size);
+  }
+
+  std::string path = testing::TempDir() + "cheddar_memory_bins_test.txt";
+  config.Save(path);
+  MemoryBinConfig loaded = MemoryBinConfig::Load(path);
+  std::remove(path.c_str());
+  ASSERT_EQ(loaded.bins.size(), config.bins.size());
+  for (size_t i = 0; i < config.bins.size(); i++) {
+    ASSERT_EQ(loaded.bins[i].size, config.bins[i].size);
+    ASSERT_EQ(loaded.bins[i].num_reserved, config.bins[i].num_reserved);
+  }
+
+  // The reserved blocks should serve the same workload without the upstream.
+  auto context = Context<word>::Create(*param_, nullptr, &loaded);
+  MemoryPoolStats before = context->GetMemoryStats();
+  ASSERT_GE(before.upstream_live_bytes, loaded.GetReservedBytes());
+  workload(*context);
+  MemoryPoolStats after = context->GetMemoryStats();
+  ASSERT_EQ(after.num_upstream_allocations, before.num_upstream_allocations);
+}
+
+TEST_P(Testbed32, MemoryFootprint) {
+  int level = param_->default_encryption_level_;
+  EvkRequest req;
+  req.AddRequest(1, param_->max_level_);
+  req.AddRequest(2, level);
+  interface_->PrepareRotationKey(req);
+  MemoryFootprint footprint =
+      Context<word>::EstimateMemoryFootprint(*param_, req);
+
+  // Each evaluation key, including the basic ones
+  const auto &evk_map = interface_->GetEvkMap();
+  ASSERT_EQ(footprint.evk_bytes.size(), evk_map.size());
+  for (const auto &[key_idx, evk] : evk_map) {
+    size_t bytes = 0;
+    for (const auto &dv : evk.bx_) bytes += dv.size() * sizeof(word);
+    for (const auto &dv : evk.ax_) bytes += dv.size() * sizeof(word);
+    ASSERT_EQ(footprint.evk_bytes.at(key_idx), bytes);
+  }
+
+  // Key switchings at the maximum level, with the results allocated by the
+  // first run of each
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+  Ciphertext<word> ct, ct_res;
+  EncodeAndEncrypt(ct, msg, param_->max_level_);
+  auto peak_temporary_bytes = [&](auto op) {
+    op();
+    context_->ResetPeakMemoryStats();
+    MemoryPoolStats stats = context_->GetMemoryStats();
+    op();
+    return context_->GetMemoryStats().peak_live_bytes - stats.live_bytes;
+  };
+  ASSERT_EQ(peak_temporary_bytes([&] {
+              context_->HRot(ct_res, ct, *evk_map.GetRotationKey(1), 1);
+            }),
+            footprint.peak_temporary_bytes);
+  ASSERT_EQ(peak_temporary_bytes([&] {
+              context_->HMult(ct_res, ct, ct, *evk_map.GetMultiplicationKey());
+            }),
+            footprint.peak_temporary_bytes);
+
+  // The tables of a new Context (measured last, as the new Context takes over
+  // the allocations while it is alive)
+  {
+    auto context = Context<word>::Create(*param_);
+    ASSERT_EQ(context->GetMemoryStats().live_bytes,
+              footprint.GetTableBytes());
+  }
+
+  std::stringstream dump;
+  footprint.Dump(dump);
+  ASSERT_NE(dump.str().find("total"), std::string::npos);
+  std::cout << dump.str();
+}
+
 TEST_P(Testbed32, EncodeEncryptDecryptDecode) {
   std::cout << "Encode, Encrypt, Decrypt and Decode functions exist for test "
                "purposes and their performance is not a priority."
@@ -398,6 +894,57 @@ TEST_P(Testbed32, HRot) {
   }
 }
 
+TEST_P(Testbed32, HRotFromEvkStore) {
+  int num_slots = (1 << log_degree_) / 2;
+  int level = param_->max_level_;
+  std::vector<int> rot_dists = {1, 1234};
+  for (int rot_dist : rot_dists) {
+    interface_->PrepareRotationKey(rot_dist, level);
+  }
+  std::string path = testing::TempDir() + "cheddar_evk_store.bin";
+  EvkStore<word>::Write(path, *param_, interface_->GetEvkMap());
+
+  // A budget of a single key: every other access evicts a key.
+  const auto &key = interface_->GetRotationKey(rot_dists[0]);
+  uint64_t key_bytes = Serializer<word>(*param_).GetSerializedSize(key);
+  auto store = std::make_shared<EvkStore<word>>(*param_, path, key_bytes);
+  EvkMap<word> evk_map;
+  evk_map.AttachStore(store);
+
+  std::vector<Complex> msg1;
+  GenerateRandomMessage(msg1);
+  Ciphertext<word> ct1, ct_res;
+  EncodeAndEncrypt(ct1, msg1, level);
+  for (int iter = 0; iter < 2; iter++) {
+    for (int rot_dist : rot_dists) {
+      std::vector<Complex> true_res;
+      for (int i = 0; i < static_cast<int>(msg1.size()); i++) {
+        true_res.push_back(msg1[(i + rot_dist) % num_slots]);
+      }
+      context_->HRot(ct_res, ct1, *evk_map.GetRotationKey(rot_dist), rot_dist);
+
+      std::vector<Complex> res;
+      DecryptAndDecode(res, ct_res);
+      CompareMessages(true_res, res, false);
+    }
+  }
+  ASSERT_EQ(store->GetStats().loads, 4u);
+  ASSERT_EQ(store->GetStats().evictions, 3u);
+  ASSERT_EQ(store->GetResidentBytes(), key_bytes);
+
+  // A held key is pinned: it is not evicted even over the budget.
+  {
+    auto pinned = evk_map.GetRotationKey(rot_dists[0]);
+    auto other = evk_map.GetRotationKey(rot_dists[1]);
+    ASSERT_EQ(store->GetResidentBytes(), 2 * key_bytes);
+    store->Clear();
+    ASSERT_EQ(store->GetResidentBytes(), 2 * key_bytes);
+  }
+  store->SetBudget(key_bytes);
+  ASSERT_EQ(store->GetResidentBytes(), key_bytes);
+  std::remove(path.c_str());
+}
+
 TEST_P(Testbed32, HConj) {
   for (int level = 0; level <= param_->max_level_; level++) {
     std::vector<Complex> msg1;
@@ -418,6 +965,27 @@ TEST_P(Testbed32, HConj) {
   }
 }
 
+TEST_P(Testbed32, Compact) {
+  int level = param_->default_encryption_level_;
+  std::vector<Complex> msg;
+  GenerateRandomMessage(msg);
+  Ciphertext<word> ct;
+  EncodeAndEncrypt(ct, msg, level);
+
+  // |msg| <= sqrt(2) for random complex messages in [-1, 1] + [-1, 1]i
+  Ciphertext<word> ct_leveled, ct_res;
+  context_->Compact(ct_leveled, ct, 12, 2.0, false);
+  context_->Compact(ct_res, ct, 12, 2.0);
+  ASSERT_LT(param_->NPToLevel(ct_leveled.GetNP()), level);
+  ASSERT_LE(ct_res.GetNP().GetNumTotal(), ct_leveled.GetNP().GetNumTotal());
+
+  std::vector<Complex> res;
+  DecryptAndDecode(res, ct_leveled);
+  CompareMessages(msg, res, false);
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg, res);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Cheddar, Testbed32,
     testing::Values("bootparam_30.json", "bootparam_35.json",
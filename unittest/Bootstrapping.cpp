@@ -1,4 +1,7 @@
+#include <cstdio>
+
 #include "Testbed.h"
+#include "core/Serialize.h"
 
 static constexpr int num_slots = 1 << 15;
 
@@ -40,6 +43,214 @@ TEST_P(Testbed32, Bootstrap) {
   CompareMessages(msg1, res);
 }
 
+TEST_P(Testbed32, BootImportedSpecialFFT) {
+  using word = uint32_t;
+  constexpr int sparse_num_slots = 1 << 10;
+  std::shared_ptr<BootContext<word>> boot_context =
+      std::dynamic_pointer_cast<BootContext<word>>(context_);
+
+  // Prepare in another BootContext (as another process would)
+  std::string path = testing::TempDir() + "cheddar_special_fft.bin";
+  {
+    auto exporter =
+        BootContext<word>::Create(*param_, boot_context->boot_param_);
+    exporter->PrepareEvalSpecialFFT(sparse_num_slots);
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    exporter->ExportEvalSpecialFFT(os, sparse_num_slots);
+  }
+  {
+    MappedFile file(path);
+    ASSERT_EQ(boot_context->ImportEvalSpecialFFT(file.data(), file.size()),
+              file.size());
+  }
+  std::remove(path.c_str());
+  boot_context->PrepareEvalMod();
+  ASSERT_TRUE(boot_context->IsBootPrepared(sparse_num_slots));
+
+  EvkRequest req;
+  boot_context->AddRequiredRotations(req, sparse_num_slots);
+  interface_->PrepareRotationKey(req);
+
+  std::vector<Complex> msg1;
+  GenerateRandomMessage(msg1, sparse_num_slots);
+  Ciphertext<word> ct1;
+  EncodeAndEncrypt(ct1, msg1, 0);
+
+  Ciphertext<word> ct_res;
+  std::vector<Complex> res;
+  boot_context->Boot(ct_res, ct1, interface_->GetEvkMap());
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg1, res);
+}
+
+TEST_P(Testbed32, BootWorkspace) {
+  using word = uint32_t;
+  constexpr int sparse_num_slots = 1 << 10;
+  std::shared_ptr<BootContext<word>> boot_context =
+      std::dynamic_pointer_cast<BootContext<word>>(context_);
+  boot_context->PrepareEvalMod();
+  boot_context->PrepareEvalSpecialFFT(sparse_num_slots);
+  EvkRequest req;
+  boot_context->AddRequiredRotations(req, sparse_num_slots, true);
+  interface_->PrepareRotationKey(req);
+
+  BootWorkspace<word> workspace =
+      boot_context->CreateWorkspace(sparse_num_slots);
+  int num_cts = workspace.GetNumCts();
+  int num_dvs = workspace.GetNumDvs();
+  size_t reserved_bytes = workspace.GetReservedBytes();
+  ASSERT_GT(reserved_bytes, 0);
+
+  std::vector<Complex> msg1;
+  GenerateRandomMessage(msg1, sparse_num_slots);
+  Ciphertext<word> ct1;
+  EncodeAndEncrypt(ct1, msg1, 0);
+
+  Ciphertext<word> ct_ref;
+  boot_context->Boot(ct_ref, ct1, interface_->GetEvkMap(), true);
+
+  std::vector<Complex> res;
+  for (int i = 0; i < 2; i++) {
+    Ciphertext<word> ct_res;
+    boot_context->Boot(ct_res, ct1, interface_->GetEvkMap(), workspace, true);
+    DecryptAndDecode(res, ct_res);
+    CompareMessages(msg1, res);
+
+    // Same as without a workspace, and every temporary is given back
+    HostVector<word> ref_bx, res_bx;
+    CopyDeviceToHost(ref_bx, ct_ref.bx_);
+    CopyDeviceToHost(res_bx, ct_res.bx_);
+    ASSERT_EQ(ref_bx, res_bx);
+    ASSERT_EQ(workspace.GetNumCts(), num_cts);
+    ASSERT_EQ(workspace.GetNumDvs(), num_dvs);
+    ASSERT_EQ(workspace.GetReservedBytes(), reserved_bytes);
+  }
+}
+
+TEST_P(Testbed32, BootWorkspaceAllocations) {
+  using word = uint32_t;
+  constexpr int sparse_num_slots = 1 << 10;
+  std::shared_ptr<BootContext<word>> boot_context =
+      std::dynamic_pointer_cast<BootContext<word>>(context_);
+  boot_context->PrepareEvalMod();
+  boot_context->PrepareEvalSpecialFFT(sparse_num_slots);
+  EvkRequest req;
+  boot_context->AddRequiredRotations(req, sparse_num_slots);
+  boot_context->AddRequiredRotations(req, sparse_num_slots, true);
+  interface_->PrepareRotationKey(req);
+
+  std::vector<Complex> msg1;
+  GenerateRandomMessage(msg1, sparse_num_slots);
+  Ciphertext<word> ct1;
+  EncodeAndEncrypt(ct1, msg1, 0);
+
+  for (bool min_ks : {false, true}) {
+    BootWorkspace<word> workspace =
+        boot_context->CreateWorkspace(sparse_num_slots);
+    int num_cts = workspace.GetNumCts();
+    int num_dvs = workspace.GetNumDvs();
+
+    // The temporaries of the Context operations (e.g., the key switchings)
+    // come from the workspace as well, so the second run takes nothing new
+    // from the upstream.
+    Ciphertext<word> ct_res;
+    boot_context->Boot(ct_res, ct1, interface_->GetEvkMap(), workspace,
+                       min_ks);
+    uint64_t num_upstream_allocations =
+        boot_context->GetMemoryStats().num_upstream_allocations;
+    boot_context->Boot(ct_res, ct1, interface_->GetEvkMap(), workspace,
+                       min_ks);
+    ASSERT_EQ(boot_context->GetMemoryStats().num_upstream_allocations,
+              num_upstream_allocations);
+    ASSERT_EQ(workspace.GetNumCts(), num_cts);
+    ASSERT_EQ(workspace.GetNumDvs(), num_dvs);
+
+    std::vector<Complex> res;
+    DecryptAndDecode(res, ct_res);
+    CompareMessages(msg1, res);
+  }
+}
+
+TEST_P(Testbed32, BootFromEvkStore) {
+  using word = uint32_t;
+  constexpr int sparse_num_slots = 1 << 10;
+  std::shared_ptr<BootContext<word>> boot_context =
+      std::dynamic_pointer_cast<BootContext<word>>(context_);
+  boot_context->PrepareEvalMod();
+  boot_context->PrepareEvalSpecialFFT(sparse_num_slots);
+  EvkRequest req;
+  boot_context->AddRequiredRotations(req, sparse_num_slots);
+  interface_->PrepareRotationKey(req);
+
+  std::string path = testing::TempDir() + "cheddar_boot_evk_store.bin";
+  EvkStore<word>::Write(path, *param_, interface_->GetEvkMap());
+
+  // A budget of a single key, while a hoisted transform uses several keys at
+  // once: they are pinned until the transform releases them.
+  Serializer<word> serializer(*param_);
+  uint64_t key_bytes = 0;
+  for (const auto &[_, evk] : interface_->GetEvkMap()) {
+    key_bytes = std::max(key_bytes, serializer.GetSerializedSize(evk));
+  }
+  auto store = std::make_shared<EvkStore<word>>(*param_, path, key_bytes);
+  EvkMap<word> evk_map;
+  evk_map.AttachStore(store);
+
+  std::vector<Complex> msg1;
+  GenerateRandomMessage(msg1, sparse_num_slots);
+  Ciphertext<word> ct1;
+  EncodeAndEncrypt(ct1, msg1, 0);
+
+  Ciphertext<word> ct_ref, ct_res;
+  boot_context->Boot(ct_ref, ct1, interface_->GetEvkMap());
+  boot_context->Boot(ct_res, ct1, evk_map);
+  HostVector<word> ref_bx, res_bx;
+  CopyDeviceToHost(ref_bx, ct_ref.bx_);
+  CopyDeviceToHost(res_bx, ct_res.bx_);
+  ASSERT_EQ(ref_bx, res_bx);
+  std::vector<Complex> res;
+  DecryptAndDecode(res, ct_res);
+  CompareMessages(msg1, res);
+
+  // Nothing is pinned any more, so the store gets back within the budget.
+  ASSERT_GT(store->GetStats().evictions, 0u);
+  store->SetBudget(key_bytes);
+  ASSERT_LE(store->GetResidentBytes(), key_bytes);
+  std::remove(path.c_str());
+}
+
+TEST_P(Testbed32, BootMemoryFootprint) {
+  using word = uint32_t;
+  constexpr int sparse_num_slots = 1 << 10;
+  std::shared_ptr<BootContext<word>> boot_context =
+      std::dynamic_pointer_cast<BootContext<word>>(context_);
+  boot_context->PrepareEvalMod();
+  size_t live_bytes = boot_context->GetMemoryStats().live_bytes;
+  boot_context->PrepareEvalSpecialFFT(sparse_num_slots);
+  size_t plaintext_bytes =
+      boot_context->GetMemoryStats().live_bytes - live_bytes;
+
+  EvkRequest req;
+  boot_context->AddRequiredRotations(req, sparse_num_slots, true);
+  MemoryFootprint footprint = BootContext<word>::EstimateMemoryFootprint(
+      *param_, boot_context->boot_param_, {sparse_num_slots}, req);
+  ASSERT_EQ(footprint.boot_plaintext_bytes, plaintext_bytes);
+
+  interface_->PrepareRotationKey(req);
+  const auto &evk_map = interface_->GetEvkMap();
+  ASSERT_EQ(footprint.evk_bytes.size(), evk_map.size());
+  size_t evk_bytes = 0;
+  for (const auto &[key_idx, evk] : evk_map) {
+    for (const auto &dv : evk.bx_) evk_bytes += dv.size() * sizeof(word);
+    for (const auto &dv : evk.ax_) evk_bytes += dv.size() * sizeof(word);
+  }
+  ASSERT_EQ(footprint.GetEvkBytes(), evk_bytes);
+
+  BootWorkspace<word> workspace =
+      boot_context->CreateWorkspace(sparse_num_slots);
+  ASSERT_LE(workspace.GetReservedBytes(), footprint.peak_temporary_bytes);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Cheddar, Testbed32,
     testing::Values("bootparam_30.json", "bootparam_35.json",
@@ -2,9 +2,6 @@
 
 #include <gtest/gtest.h>
 
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
-
 #include <algorithm>
 #include <chrono>
 #include <cmath>
@@ -14,6 +11,7 @@ using json = nlohmann::json;
 #include <memory>
 
 #include "UserInterface.h"
+#include "core/ParameterLoader.h"
 
 #ifdef ENABLE_EXTENSION
 #include "extension/BootContext.h"
@@ -46,13 +44,6 @@ using namespace cheddar;
             << "us" << std::endl;                                           \
   }
 
-void Check(bool condition, const std::string &message) {
-  if (!condition) {
-    std::cerr << "ERROR:" << message << std::endl;
-    exit(EXIT_FAILURE);
-  }
-}
-
 template <typename T>
 void PrintVector(const std::vector<T> &vec, int print_num = 5) {
   std::cout << std::fixed << std::setprecision(8);
@@ -94,123 +85,28 @@ class Testbed : public testing::TestWithParam<const char *> {
 
   void SetUp() override {
     std::string json_path = std::string(PARAM_DIR) + "/" + GetParam();
-    std::ifstream json_file(json_path);
-    Check(json_file.is_open(), "Failed to open JSON file: " + json_path);
-    json json_data = json::parse(json_file);
-    json_file.close();
-
-    // Parsing...
-    Check(json_data.contains("log_degree"), "Missing log_degree in JSON file");
-    Check(json_data["log_degree"].is_number_integer(),
-          "log_degree should be an integer");
-    log_degree_ = json_data["log_degree"];
-
-    Check(json_data.contains("log_default_scale"),
-          "Missing log_default_scale in JSON file");
-    Check(json_data["log_default_scale"].is_number_integer(),
-          "log_default_scale should be an integer");
-    int log_default_scale = json_data["log_default_scale"];
-    default_scale_ = (UINT64_C(1) << log_default_scale);
-
-    Check(json_data.contains("default_encryption_level"),
-          "Missing default_encryption_level in JSON file");
-    Check(json_data["default_encryption_level"].is_number_integer(),
-          "default_encryption_level should be an integer");
-    default_encryption_level_ = json_data["default_encryption_level"];
-
-    main_primes_.clear();
-    Check(json_data.contains("main_primes"),
-          "Missing main_primes in JSON file");
-    auto main_primes = json_data["main_primes"];
-    Check(main_primes.is_array(), "main_primes should be an array");
-    std::vector<word> main_primes_;
-    for (const auto &prime : main_primes) {
-      Check(prime.is_number_integer(),
-            "main_primes should be an array of integers");
-      main_primes_.push_back(prime);
-    }
-
-    ter_primes_.clear();
-    if (json_data.contains("terminal_primes")) {
-      auto ter_primes = json_data["terminal_primes"];
-      Check(ter_primes.is_array(), "aux_primes should be an array");
-      for (const auto &prime : ter_primes) {
-        Check(prime.is_number_integer(),
-              "terminal_primes should be an array of integers");
-        ter_primes_.push_back(prime);
-      }
-    }
-
-    aux_primes_.clear();
-    Check(json_data.contains("auxiliary_primes"),
-          "Missing auxiliary_primes in JSON file");
-    auto aux_primes = json_data["auxiliary_primes"];
-    Check(aux_primes.is_array(), "aux_primes should be an array");
-    for (const auto &prime : aux_primes) {
-      Check(prime.is_number_integer(),
-            "auxiliary_primes should be an array of integers");
-      aux_primes_.push_back(prime);
-    }
-
-    level_config_.clear();
-    Check(json_data.contains("level_config"),
-          "Missing level_config in JSON file");
-    auto level_config = json_data["level_config"];
-    Check(level_config.is_array(), "level_config should be an array");
-    for (const auto &pair : level_config) {
-      Check(pair.is_array() && pair.size() == 2,
-            "level_config should be an array of pairs");
-      level_config_.emplace_back(pair[0], pair[1]);
-    }
-
-    additional_base_ = {0, 0};
-    if (json_data.contains("additional_base")) {
-      auto additional_base = json_data["additional_base"];
-      Check(additional_base.is_array() && additional_base.size() == 2,
-            "additional_base should be an array of pairs");
-      additional_base_ = {additional_base[0], additional_base[1]};
-    }
+    ParameterConfig config = ParameterConfig::Load(json_path);
+
+    log_degree_ = config.log_degree;
+    default_scale_ = (UINT64_C(1) << config.log_default_scale);
+    default_encryption_level_ = config.default_encryption_level;
+    main_primes_.assign(config.main_primes.begin(), config.main_primes.end());
+    ter_primes_.assign(config.terminal_primes.begin(),
+                       config.terminal_primes.end());
+    aux_primes_.assign(config.auxiliary_primes.begin(),
+                       config.auxiliary_primes.end());
+    level_config_ = config.level_config;
+    additional_base_ = config.additional_base;
 
     // Initialize Parameter
-    param_ = std::make_unique<Parameter<word>>(
-        log_degree_, default_scale_, default_encryption_level_, level_config_,
-        main_primes_, aux_primes_, ter_primes_, additional_base_);
-
-    if (json_data.contains("dense_hamming_weight")) {
-      Check(json_data["dense_hamming_weight"].is_number_integer(),
-            "dense_hamming_weight should be an integer");
-      int dense_h = json_data["dense_hamming_weight"];
-      param_->SetDenseHammingWeight(dense_h);
-    }
-    if (json_data.contains("sparse_hamming_weight")) {
-      Check(json_data["sparse_hamming_weight"].is_number_integer(),
-            "sparse_hamming_weight should be an integer");
-      int sparse_h = json_data["sparse_hamming_weight"];
-      param_->SetSparseHammingWeight(sparse_h);
-    }
+    param_ = config.CreateParameter<word>();
 
 #ifdef ENABLE_EXTENSION
-    bool enable_boot = false;
-    if (json_data.contains("boot")) {
-      Check(json_data["boot"].is_boolean(), "boot should be a boolean");
-      enable_boot = json_data["boot"];
-    }
-
-    if (enable_boot) {
+    if (config.boot) {
       std::cout << "Bootstrapping enabled" << std::endl;
-      Check(json_data.contains("num_cts_levels"),
-            "Missing num_cts_levels in JSON file");
-      Check(json_data["num_cts_levels"].is_number_integer(),
-            "num_cts_levels should be an integer");
-      int num_cts_levels = json_data["num_cts_levels"];
-      Check(json_data.contains("num_stc_levels"),
-            "Missing num_stc_levels in JSON file");
-      Check(json_data["num_stc_levels"].is_number_integer(),
-            "num_stc_levels should be an integer");
-      int num_stc_levels = json_data["num_stc_levels"];
       context_ = BootContext<word>::Create(
-          *param_,
-          BootParameter(param_->max_level_, num_cts_levels, num_stc_levels));
+          *param_, BootParameter(param_->max_level_, config.num_cts_levels,
+                                 config.num_stc_levels));
     } else {
       context_ = Context<word>::Create(*param_);
     }
@@ -363,6 +259,37 @@ class Testbed : public testing::TestWithParam<const char *> {
 
     ASSERT_EQ(equal, true) << "Messages are not equal";
   }
+
+  static void ExpectSameDv(const DeviceVector<word> &a,
+                           const DeviceVector<word> &b) {
+    HostVector<word> h_a, h_b;
+    CopyDeviceToHost(h_a, a);
+    CopyDeviceToHost(h_b, b);
+    EXPECT_TRUE(h_a == h_b) << "Device vectors differ";
+  }
+
+  // Encoding the same message with context should give the same plaintext
+  // as with context_ (e.g., with tables loaded or shared otherwise).
+  void ExpectSameEncoding(const Context<word> &context) {
+    std::vector<Complex> msg;
+    GenerateRandomMessage(msg);
+    Plaintext<word> pt_ref, pt_res;
+    int level = param_->default_encryption_level_;
+    double scale = param_->GetScale(level);
+    context_->encoder_.Encode(pt_ref, level, scale, msg);
+    context.encoder_.Encode(pt_res, level, scale, msg);
+    ExpectSameDv(pt_ref.mx_, pt_res.mx_);
+  }
+
+  static void ExpectSameEvk(const EvaluationKey<word> &a,
+                            const EvaluationKey<word> &b) {
+    EXPECT_TRUE(a.GetNP() == b.GetNP());
+    ASSERT_EQ(a.GetBeta(), b.GetBeta());
+    for (int i = 0; i < a.GetBeta(); i++) {
+      ExpectSameDv(a.ax_[i], b.ax_[i]);
+      ExpectSameDv(a.bx_[i], b.bx_[i]);
+    }
+  }
 };
 
 using Testbed32 = Testbed<uint32_t>;